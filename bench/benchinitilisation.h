@@ -1,7 +1,6 @@
-
-
 void bench_first_initialisation(int probsz){
 	probsz; /* We don't care about this... */
+	cvtx_accelerator_initialisation(CVTX_ACCELERATOR_INIT_IMMEDIATE);
 	cvtx_initialise();
 	return;
 }
@@ -12,3 +11,31 @@ void bench_reinitialisation(int probsz){
 	cvtx_initialise();
 	return;
 }
+
+void bench_background_initialisation(int probsz){
+	(void)probsz; /* We don't care about this... */
+	/* Only the time to return - accelerators are prepared on another thread. */
+	cvtx_accelerator_initialisation(CVTX_ACCELERATOR_INIT_BACKGROUND);
+	cvtx_initialise();
+	return;
+}
+
+void bench_background_first_cpu_call(int probsz){
+	/* A small problem that runs on the CPU whilst accelerators load. */
+	cvtx_P3D particle;
+	const cvtx_P3D *pparticle;
+	bsv_V3f mes, result;
+	cvtx_VortFunc vf;
+	(void)probsz; /* We don't care about this... */
+	cvtx_accelerator_initialisation(CVTX_ACCELERATOR_INIT_BACKGROUND);
+	cvtx_initialise();
+	particle.coord.x[0] = 0.f; particle.coord.x[1] = 0.f; particle.coord.x[2] = 0.f;
+	particle.vorticity.x[0] = 0.f; particle.vorticity.x[1] = 0.f; 
+	particle.vorticity.x[2] = 1.f;
+	particle.volume = 1.f;
+	mes.x[0] = 1.f; mes.x[1] = 0.f; mes.x[2] = 0.f;
+	pparticle = &particle;
+	vf = cvtx_VortFunc_winckelmans();
+	cvtx_P3D_M2M_vel(&pparticle, 1, &mes, 1, &result, &vf, 0.1f);
+	return;
+}
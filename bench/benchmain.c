@@ -45,6 +45,14 @@ int main(int argc, char* argv[]){
 	BENCH("init cold", bench_first_initialisation, 1, 1);
 	cvtx_initialise();	/* If already run cold-init this does nothing. */
 	BENCH("init reinit", bench_reinitialisation, 6, 1);
+	/* Background loading can only be timed from a finalised library. */
+	cvtx_finalise();
+	BENCH("init background", bench_background_initialisation, 1, 1);
+	cvtx_finalise();
+	BENCH("init background first cpu call", bench_background_first_cpu_call, 1, 1);
+	cvtx_finalise();
+	cvtx_accelerator_initialisation(CVTX_ACCELERATOR_INIT_IMMEDIATE);
+	cvtx_initialise();
 	run_redistribution_tests();
 	run_P3D_bench();
 	run_P2D_bench();
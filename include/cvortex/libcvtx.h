@@ -47,6 +47,7 @@ extern "C"
 {
 #endif
 
+#include <stddef.h>
 #include <bsv/bsv.h>
 
 /* A Vortex particle in 3D */
@@ -98,6 +99,44 @@ typedef struct {
 	float radius;
 } cvtx_RedistFunc;
 
+/* Algorithms for many-to-many (M2M) interactions
+	- CVTX_ALGORITHM_BRUTE_FORCE: direct O(N*M) summation.
+		Uses accelerators where possible. The default.
+	- CVTX_ALGORITHM_BARNES_HUT: octtree treecode with quadrupole
+		expansions. O(M log N). CPU only. P3D vel only.
+		- theta: opening angle. Smaller is more accurate. ~0.5 typical.
+	- CVTX_ALGORITHM_FMM: fast multipole method. O(N + M). CPU only.
+		P3D vel and dvort (cartesian), P2D vel (complex variable).
+		- order: expansion order. Larger is more accurate. 
+			4-8 typical for P3D, 10-20 for P2D.
+		- theta: well separatedness criterion. ~0.5 typical.
+	Where an algorithm doesn't support a function, brute force is used.
+*/
+typedef enum {
+	CVTX_ALGORITHM_BRUTE_FORCE = 0,
+	CVTX_ALGORITHM_BARNES_HUT = 1,
+	CVTX_ALGORITHM_FMM = 2
+} cvtx_AlgorithmType;
+
+typedef struct {
+	cvtx_AlgorithmType type;
+	float theta;
+	int order;
+} cvtx_Algorithm;
+
+/* When cvtx_initialise prepares the accelerators
+	- CVTX_ACCELERATOR_INIT_IMMEDIATE: before it returns. The default.
+	- CVTX_ACCELERATOR_INIT_BACKGROUND: on a background thread. Calls 
+		that want an accelerator wait for it to finish.
+	- CVTX_ACCELERATOR_INIT_ON_DEMAND: on the first call that wants an 
+		accelerator.
+*/
+typedef enum {
+	CVTX_ACCELERATOR_INIT_IMMEDIATE = 0,
+	CVTX_ACCELERATOR_INIT_BACKGROUND = 1,
+	CVTX_ACCELERATOR_INIT_ON_DEMAND = 2
+} cvtx_AcceleratorInit;
+
 /* cvtx libary accelerator controls */
 CVTX_EXPORT void cvtx_initialise();
 CVTX_EXPORT void cvtx_finalise();
@@ -108,6 +147,19 @@ CVTX_EXPORT const char* cvtx_accelerator_name(int accelerator_id);
 CVTX_EXPORT int cvtx_accelerator_enabled(int accelerator_id);
 CVTX_EXPORT void cvtx_accelerator_enable(int accelerator_id);
 CVTX_EXPORT void cvtx_accelerator_disable(int accelerator_id);
+/* Cache compiled accelerator programs in directory. Call before 
+cvtx_initialise. NULL uses CVTX_ACCELERATOR_CACHE_DIR, "" disables. */
+CVTX_EXPORT void cvtx_accelerator_cache_directory(const char *directory);
+/* Call before cvtx_initialise. Otherwise CVTX_ACCELERATOR_INIT is used. */
+CVTX_EXPORT void cvtx_accelerator_initialisation(cvtx_AcceleratorInit mode);
+/* Nonzero has the CPU take a share of the P3D M2M vel and dvort work given
+to the accelerators. Otherwise CVTX_ACCELERATOR_SHARE_WITH_CPU=1 enables. 
+The _async functions never share - their work stays on the accelerators so
+the CPU is left to the caller. */
+CVTX_EXPORT void cvtx_accelerator_share_with_cpu(int share);
+/* Measure the problem sizes from which the enabled accelerators beat the 
+CPU and use them to choose between the two. Returns 0 on success. */
+CVTX_EXPORT int cvtx_accelerator_calibrate();
 
 /* cvtx_VortFunc functions */
 CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_singular(void);
@@ -122,6 +174,14 @@ CVTX_EXPORT const cvtx_RedistFunc cvtx_RedistFunc_lambda2(void);
 CVTX_EXPORT const cvtx_RedistFunc cvtx_RedistFunc_lambda3(void);
 CVTX_EXPORT const cvtx_RedistFunc cvtx_RedistFunc_m4p(void);
 
+/* cvtx_Algorithm functions */
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_brute_force(void);
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_barnes_hut(float theta);
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_fmm(int order, float theta);
+/* Algorithm used by M2M functions not given an algorithm explicitly. */
+CVTX_EXPORT void cvtx_Algorithm_set_default(const cvtx_Algorithm* algorithm);
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_default(void);
+
 /* cvtx_P3D 3D vortex particle functions */
 CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_vel(
 	const cvtx_P3D *self,
@@ -219,6 +279,29 @@ CVTX_EXPORT void cvtx_P3D_M2M_vel(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius);
 
+CVTX_EXPORT void cvtx_P3D_M2M_vel_algorithm(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm);
+
+/* The _strided functions take particles as an array rather than an array
+of pointers. stride is the number of bytes from the start of one particle
+to the next, or 0 for a contiguous array. */
+CVTX_EXPORT void cvtx_P3D_M2M_vel_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
 CVTX_EXPORT void cvtx_P3D_M2M_dvort(
 	const cvtx_P3D **array_start,
 	const int num_particles,
@@ -228,6 +311,27 @@ CVTX_EXPORT void cvtx_P3D_M2M_dvort(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius);
 
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_algorithm(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm);
+
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
 CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort(
 	const cvtx_P3D **array_start,
 	const int num_particles,
@@ -238,6 +342,56 @@ CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort(
 	float regularisation_radius,
 	float kinematic_visc);
 
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_truncated(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc,
+	float truncation);	/* Cutoff / regularisation_radius. 0 for none. */
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_dvort_visc(	/* vel at induced particles */
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+CVTX_EXPORT void cvtx_P3D_self_dvort(	/* array_start == induced_start */
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT void cvtx_P3D_self_visc_dvort(	/* array_start == induced_start */
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
 CVTX_EXPORT void cvtx_P3D_M2M_vort(
 	const cvtx_P3D** array_start,
 	const int num_particles,
@@ -247,6 +401,148 @@ CVTX_EXPORT void cvtx_P3D_M2M_vort(
 	const cvtx_VortFunc* kernel,
 	float regularisation_radius);
 
+CVTX_EXPORT void cvtx_P3D_M2M_vort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+/* A cvtx_P3D_soa holds a copy of a set of particles as a structure of 
+arrays. Reusing one between calls avoids repacking the particles each time
+they are used. */
+typedef struct cvtx_P3D_soa cvtx_P3D_soa;
+
+CVTX_EXPORT cvtx_P3D_soa *cvtx_P3D_soa_create(void);
+
+CVTX_EXPORT void cvtx_P3D_soa_destroy(cvtx_P3D_soa *soa);
+
+CVTX_EXPORT void cvtx_P3D_soa_fill(
+	cvtx_P3D_soa *soa,
+	const cvtx_P3D **array_start,
+	const int num_particles);
+
+CVTX_EXPORT void cvtx_P3D_soa_fill_strided(
+	cvtx_P3D_soa *soa,
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles);
+
+CVTX_EXPORT int cvtx_P3D_soa_size(const cvtx_P3D_soa *soa);
+
+CVTX_EXPORT cvtx_P3D cvtx_P3D_soa_get(const cvtx_P3D_soa *soa, int index);
+
+/* The update functions take an array of cvtx_P3D_soa_size(soa) values. */
+CVTX_EXPORT void cvtx_P3D_soa_update_coords(
+	cvtx_P3D_soa *soa,
+	const bsv_V3f *coords);
+
+CVTX_EXPORT void cvtx_P3D_soa_update_vorticities(
+	cvtx_P3D_soa *soa,
+	const bsv_V3f *vorticities);
+
+CVTX_EXPORT void cvtx_P3D_soa_update_volumes(
+	cvtx_P3D_soa *soa,
+	const float *volumes);
+
+/* Keep a copy of the particles on the accelerator. It is updated by 
+cvtx_P3D_soa_fill and the update functions. 0 on success, -1 otherwise. */
+CVTX_EXPORT int cvtx_P3D_soa_to_accelerator(cvtx_P3D_soa *soa);
+
+CVTX_EXPORT void cvtx_P3D_soa_release_accelerator(cvtx_P3D_soa *soa);
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_soa(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_dvort_visc_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+CVTX_EXPORT void cvtx_P3D_M2M_vort_soa(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+/* Asynchronous M2M evaluations. On an accelerator these return once the 
+work is queued, so the CPU is free for other work. The inputs may be 
+reused straight away - updating a cvtx_P3D_soa kept on the accelerator
+first waits for the accelerators to finish their queued work - but 
+result_array isn't written until the request is waited on. Work done on
+the CPU completes before returning. */
+typedef struct cvtx_Request cvtx_Request;
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_vel_async(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_vel_soa_async(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_dvort_async(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_dvort_soa_async(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+/* 1 if cvtx_wait wouldn't block, 0 otherwise. */
+CVTX_EXPORT int cvtx_test(cvtx_Request *request);
+/* Block until the results are written, then free the request. Requests 
+must be waited on before cvtx_finalise. 0 on success, -1 if the 
+accelerator failed and the results weren't written. */
+CVTX_EXPORT int cvtx_wait(cvtx_Request *request);
+
 CVTX_EXPORT int cvtx_P3D_redistribute_on_grid(
 	const cvtx_P3D **input_array_start,
 	const int n_input_particles,
@@ -289,6 +585,14 @@ CVTX_EXPORT void cvtx_F3D_M2M_vel(
 	const int num_mes,
 	bsv_V3f *result_array);
 
+CVTX_EXPORT void cvtx_F3D_M2M_vel_strided(
+	const cvtx_F3D *filaments,
+	size_t stride,
+	const int num_filaments,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array);
+
 CVTX_EXPORT void cvtx_F3D_M2M_dvort(
 	const cvtx_F3D **array_start,
 	const int num_filaments,
@@ -296,6 +600,15 @@ CVTX_EXPORT void cvtx_F3D_M2M_dvort(
 	const int num_induced,
 	bsv_V3f *result_array);
 
+CVTX_EXPORT void cvtx_F3D_M2M_dvort_strided(
+	const cvtx_F3D *filaments,
+	size_t stride,
+	const int num_fil,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array);
+
 CVTX_EXPORT void cvtx_F3D_inf_mtrx(
 	const cvtx_F3D **array_start,
 	const int num_filaments,
@@ -335,6 +648,26 @@ CVTX_EXPORT void cvtx_P2D_M2M_vel(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius);
 
+CVTX_EXPORT void cvtx_P2D_M2M_vel_algorithm(
+	const cvtx_P2D **array_start,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm);
+
+CVTX_EXPORT void cvtx_P2D_M2M_vel_strided(
+	const cvtx_P2D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
 CVTX_EXPORT float cvtx_P2D_S2S_visc_dvort(
 	const cvtx_P2D * self,
 	const cvtx_P2D * induced_particle,
@@ -369,6 +702,18 @@ CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort(
 	float regularisation_radius,
 	float kinematic_visc);
 
+CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort_strided(
+	const cvtx_P2D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P2D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	float *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
 CVTX_EXPORT int cvtx_P2D_redistribute_on_grid( /* Returns number of created particles. */
 	const cvtx_P2D **input_array_start,
 	const int num_particles,
@@ -0,0 +1,67 @@
+#include "libcvtx.h"
+/*============================================================================
+Algorithm.cpp
+
+Selection of the algorithm used for many-to-many interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+
+static cvtx_Algorithm default_algorithm = { CVTX_ALGORITHM_BRUTE_FORCE, 0.f, 0 };
+
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_brute_force(void) {
+	cvtx_Algorithm alg;
+	alg.type = CVTX_ALGORITHM_BRUTE_FORCE;
+	alg.theta = 0.f;
+	alg.order = 0;
+	return alg;
+}
+
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_barnes_hut(float theta) {
+	assert(theta > 0.f && "Barnes-Hut opening angle must be positive.");
+	cvtx_Algorithm alg;
+	alg.type = CVTX_ALGORITHM_BARNES_HUT;
+	alg.theta = theta;
+	alg.order = 2;
+	return alg;
+}
+
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_fmm(int order, float theta) {
+	assert(order > 0 && "FMM expansion order must be positive.");
+	assert(theta > 0.f && "FMM separation criterion must be positive.");
+	cvtx_Algorithm alg;
+	alg.type = CVTX_ALGORITHM_FMM;
+	alg.theta = theta;
+	alg.order = order;
+	return alg;
+}
+
+CVTX_EXPORT void cvtx_Algorithm_set_default(const cvtx_Algorithm* algorithm) {
+	assert(algorithm != NULL);
+	default_algorithm = *algorithm;
+	return;
+}
+
+CVTX_EXPORT const cvtx_Algorithm cvtx_Algorithm_default(void) {
+	return default_algorithm;
+}
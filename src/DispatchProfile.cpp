@@ -0,0 +1,384 @@
+#include "DispatchProfile.h"
+/*============================================================================
+DispatchProfile.cpp
+
+Chooses between the CPU and the accelerators for brute force interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifdef CVTX_USING_OPENCL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "OclDeviceState.h"
+#include "opencl_acc.h"
+
+/* Calibration times square problems of these sizes, smallest first. */
+static const int calibration_sizes[] = { 64, 128, 256, 512, 1024, 2048 };
+static const long long max_calibration_size = 
+	calibration_sizes[sizeof(calibration_sizes) / sizeof(int) - 1];
+/* Each workgroup takes one target, so fewer than this many targets (or
+sources) are unlikely to fill an accelerator whatever the product. */
+static const long long min_dimension = 256;
+
+static const char *function_names[DISPATCH_NUM_FUNCTIONS] = {
+	"P3D_M2M_vel", "P3D_M2M_dvort", "P3D_M2M_visc_dvort", 
+	"P3D_M2M_vel_dvort_visc", "P3D_M2M_vort", "P2D_M2M_vel", 
+	"P2D_M2M_visc_dvort", "F3D_M2M_vel", "F3D_M2M_dvort", "P3D_self_dvort",
+	"P3D_self_visc_dvort"
+};
+
+static const char *regularisation_names[CVTX_NUM_VORTFUNC_TYPES] = {
+	"none", "singular", "winckelmans", "planetary", "gaussian"
+};
+
+/* The smallest number of interactions for which the accelerators are
+faster, or 0 if not measured. If they never won it is just above the 
+largest problem measured, since bigger problems favour them further. Other
+threads read it while it is loaded or calibrated, so the entries are 
+atomic. */
+static struct DispatchProfile {
+	std::mutex mutex;	/* Held while loading or calibrating. */
+	std::atomic<long long> 
+		crossover[DISPATCH_NUM_FUNCTIONS][CVTX_NUM_VORTFUNC_TYPES];
+} profile;
+
+/* -1, or the backend this thread uses while it calibrates. Other threads
+carry on as normal. */
+static thread_local int forced_backend = -1;
+
+static int calibrate();
+
+bool dispatch_to_accelerator(
+	DispatchFunction function,
+	VortFuncType regularisation,
+	long long num_sources,
+	long long num_targets)
+{
+	long long crossover, side;
+	if (forced_backend >= 0) {
+		return forced_backend == 1;
+	}
+	crossover = profile.crossover[function][regularisation].load(
+		std::memory_order_relaxed);
+	/* Until they're measured the self interactions go with the M2M. */
+	if (crossover == 0 && function == DISPATCH_P3D_SELF_DVORT) {
+		function = DISPATCH_P3D_M2M_DVORT;
+		crossover = profile.crossover[function][regularisation].load(
+			std::memory_order_relaxed);
+	}
+	else if (crossover == 0 && function == DISPATCH_P3D_SELF_VISC_DVORT) {
+		function = DISPATCH_P3D_M2M_VISC_DVORT;
+		crossover = profile.crossover[function][regularisation].load(
+			std::memory_order_relaxed);
+	}
+	if (crossover != 0) {
+		/* Square problems won from side, so smaller dimensions than that
+		and min_dimension are left to the CPU. */
+		side = std::min((long long) sqrt((double) crossover), min_dimension);
+		return num_sources >= side && num_targets >= side
+			&& num_sources * num_targets >= crossover;
+	}
+	switch (function) {
+	case DISPATCH_P2D_M2M_VEL:
+		/* A loosey goosey estimate of the accelerator's overheads. */
+		return 20000 + num_sources * num_targets / 20 
+			< num_sources * num_targets;
+	case DISPATCH_F3D_M2M_VEL:
+		return num_sources * num_targets / 20 + 5000 + 300 * num_targets
+			< num_sources * num_targets;
+	default:
+		return num_sources >= min_dimension && num_targets >= min_dimension;
+	}
+}
+
+bool dispatch_calibrating()
+{
+	return forced_backend >= 0;
+}
+
+/* The profile only applies to the accelerators it was measured on. */
+static std::string device_signature()
+{
+	std::string signature;
+	OclDeviceState *device;
+	cl_program prog;
+	cl_context cont;
+	cl_command_queue queue;
+	int i;
+	for (i = 0; i < opencl_num_active_devices(); ++i) {
+		if (opencl_get_device_state(i, &prog, &cont, &queue) != 0) { continue; }
+		device = opencl_device_of_queue(queue);
+		if (device != NULL) {
+			signature += device->name_ref() + ";";
+		}
+	}
+	return signature;
+}
+
+static std::string profile_path()
+{
+	std::string directory = opencl_program_cache_dir();
+	if (directory.empty()) { return directory; }
+	char last = directory.back();
+	if (last != '/' && last != '\\') { directory += "/"; }
+	return directory + "cvtx_dispatch.profile";
+}
+
+void dispatch_load_profile()
+{
+	std::string path = profile_path(), line, function, regularisation;
+	long long crossover;
+	const char *env;
+	bool found = false;
+	int i, j;
+	std::lock_guard<std::mutex> lock(profile.mutex);
+	for (i = 0; i < DISPATCH_NUM_FUNCTIONS; ++i) {
+		for (j = 0; j < CVTX_NUM_VORTFUNC_TYPES; ++j) {
+			profile.crossover[i][j] = 0;
+		}
+	}
+	if (!path.empty()) {
+		std::ifstream file(path.c_str());
+		if (std::getline(file, line) && line == "cvtx-dispatch 1"
+			&& std::getline(file, line) && line == device_signature()) {
+			found = true;
+			while (file >> function >> regularisation >> crossover) {
+				for (i = 0; i < DISPATCH_NUM_FUNCTIONS; ++i) {
+					for (j = 0; j < CVTX_NUM_VORTFUNC_TYPES; ++j) {
+						/* Older profiles saved -1 where the CPU always won. */
+						if (function == function_names[i] 
+							&& regularisation == regularisation_names[j]) {
+							profile.crossover[i][j] = crossover >= 0 ? crossover
+								: max_calibration_size * max_calibration_size + 1;
+						}
+					}
+				}
+			}
+		}
+	}
+	env = getenv("CVTX_ACCELERATOR_CALIBRATE");
+	if (!found && env != NULL && !strcmp(env, "1")) {
+		calibrate();
+	}
+}
+
+/* Written to a temporary and renamed, so that a concurrent reader never 
+sees a partial file. */
+static void save_profile()
+{
+	std::string path = profile_path();
+	int i, j;
+	if (path.empty()) { return; }
+	std::string tmp_path = path + ".tmp";
+	{
+		std::ofstream file(tmp_path.c_str());
+		file << "cvtx-dispatch 1\n" << device_signature() << "\n";
+		for (i = 0; i < DISPATCH_NUM_FUNCTIONS; ++i) {
+			for (j = 0; j < CVTX_NUM_VORTFUNC_TYPES; ++j) {
+				if (profile.crossover[i][j] != 0) {
+					file << function_names[i] << " " << regularisation_names[j]
+						<< " " << profile.crossover[i][j] << "\n";
+				}
+			}
+		}
+		if (!file) { 
+			file.close();
+			remove(tmp_path.c_str());
+			return;
+		}
+	}
+	remove(path.c_str());
+	rename(tmp_path.c_str(), path.c_str());
+}
+
+/* Best of two runs of run(n), in seconds. */
+static double time_run(const std::function<void(int)> &run, int n)
+{
+	double best = 0.;
+	int i;
+	for (i = 0; i < 2; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		run(n);
+		std::chrono::duration<double> secs = 
+			std::chrono::steady_clock::now() - start;
+		best = i == 0 || secs.count() < best ? secs.count() : best;
+	}
+	return best;
+}
+
+/* The smallest square problem from which the accelerators beat the CPU. 
+Stops once they've won twice running, assuming bigger problems favour 
+them further. If they don't, it is just above the largest problem timed so
+that larger ones still reach the accelerators. */
+static long long measure_crossover(const std::function<void(int)> &run)
+{
+	const int num_sizes = sizeof(calibration_sizes) / sizeof(int);
+	long long crossover = -1;
+	int i, n, wins = 0;
+	double cpu_time, acc_time;
+	/* The first calls create kernels and buffers. */
+	forced_backend = 0;
+	run(calibration_sizes[0]);
+	forced_backend = 1;
+	run(calibration_sizes[0]);
+	for (i = 0; i < num_sizes && wins < 2; ++i) {
+		n = calibration_sizes[i];
+		forced_backend = 0;
+		cpu_time = time_run(run, n);
+		forced_backend = 1;
+		acc_time = time_run(run, n);
+		if (acc_time < cpu_time) {
+			crossover = wins == 0 ? (long long) n * n : crossover;
+			++wins;
+		}
+		else {
+			crossover = -1;
+			wins = 0;
+		}
+	}
+	forced_backend = -1;
+	return crossover > 0 ? crossover
+		: max_calibration_size * max_calibration_size + 1;
+}
+
+int dispatch_calibrate()
+{
+	if (opencl_load() < 0 || opencl_num_active_devices() <= 0) { return -1; }
+	std::lock_guard<std::mutex> lock(profile.mutex);
+	return calibrate();
+}
+
+/* dispatch_calibrate, with the profile already locked. */
+static int calibrate()
+{
+	const int max_n = (int) max_calibration_size;
+	const VortFuncType all_3D[] = { VORTFUNC_SINGULAR, VORTFUNC_WINCKELMANS,
+		VORTFUNC_PLANETARY, VORTFUNC_GAUSSIAN };
+	const VortFuncType viscous[] = { VORTFUNC_WINCKELMANS, VORTFUNC_GAUSSIAN };
+	std::vector<cvtx_P3D> p3ds(max_n);
+	std::vector<const cvtx_P3D*> p3d_ptrs(max_n);
+	std::vector<cvtx_P2D> p2ds(max_n);
+	std::vector<const cvtx_P2D*> p2d_ptrs(max_n);
+	std::vector<cvtx_F3D> f3ds(max_n);
+	std::vector<const cvtx_F3D*> f3d_ptrs(max_n);
+	std::vector<bsv_V3f> points(max_n), res3(3 * max_n);
+	std::vector<bsv_V2f> points2(max_n), res2(max_n);
+	std::vector<float> resf(max_n);
+	cvtx_VortFunc funcs[CVTX_NUM_VORTFUNC_TYPES];
+	unsigned int seed = 1;
+	const float reg_rad = 0.3f;
+	int i, j;
+
+	if (opencl_num_active_devices() <= 0) { return -1; }
+	/* Not rand(), so as not to disturb the user's sequence. */
+	auto random = [&]() {
+		seed = seed * 1103515245u + 12345u;
+		return (float)((seed >> 8) & 0xFFFF) / 6553.6f;
+	};
+	for (i = 0; i < max_n; ++i) {
+		for (j = 0; j < 3; ++j) {
+			p3ds[i].coord.x[j] = random();
+			p3ds[i].vorticity.x[j] = random();
+			f3ds[i].start.x[j] = random();
+			f3ds[i].end.x[j] = random();
+		}
+		p3ds[i].volume = 0.01f;
+		p3d_ptrs[i] = &p3ds[i];
+		points[i] = p3ds[i].coord;
+		p2ds[i].coord.x[0] = random();
+		p2ds[i].coord.x[1] = random();
+		p2ds[i].vorticity = random();
+		p2ds[i].area = 0.01f;
+		p2d_ptrs[i] = &p2ds[i];
+		points2[i] = p2ds[i].coord;
+		f3ds[i].strength = random();
+		f3d_ptrs[i] = &f3ds[i];
+	}
+	funcs[VORTFUNC_SINGULAR] = cvtx_VortFunc_singular();
+	funcs[VORTFUNC_WINCKELMANS] = cvtx_VortFunc_winckelmans();
+	funcs[VORTFUNC_PLANETARY] = cvtx_VortFunc_planetary();
+	funcs[VORTFUNC_GAUSSIAN] = cvtx_VortFunc_gaussian();
+
+	/* The user's default algorithm might not be brute force. */
+	const cvtx_Algorithm brute_force = cvtx_Algorithm_brute_force();
+	std::atomic<long long> 
+		(&crossover)[DISPATCH_NUM_FUNCTIONS][CVTX_NUM_VORTFUNC_TYPES] 
+		= profile.crossover;
+	const cvtx_P3D **p3 = p3d_ptrs.data();
+	const cvtx_P2D **p2 = p2d_ptrs.data();
+	const cvtx_F3D **f3 = f3d_ptrs.data();
+	bsv_V3f *r3 = res3.data();
+	for (VortFuncType t : all_3D) {
+		const cvtx_VortFunc *f = funcs + t;
+		crossover[DISPATCH_P3D_M2M_VEL][t] = measure_crossover([&](int n) {
+			cvtx_P3D_M2M_vel_algorithm(p3, n, points.data(), n, r3, f, reg_rad,
+				&brute_force); });
+		crossover[DISPATCH_P3D_M2M_DVORT][t] = measure_crossover([&](int n) {
+			cvtx_P3D_M2M_dvort_algorithm(p3, n, p3, n, r3, f, reg_rad,
+				&brute_force); });
+		crossover[DISPATCH_P2D_M2M_VEL][t] = measure_crossover([&](int n) {
+			cvtx_P2D_M2M_vel_algorithm(p2, n, points2.data(), n, res2.data(), f, 
+				reg_rad, &brute_force); });
+	}
+	/* The self dvort goes to the FMM instead if it is the default. */
+	if (cvtx_Algorithm_default().type != CVTX_ALGORITHM_FMM) {
+		for (VortFuncType t : all_3D) {
+			const cvtx_VortFunc *f = funcs + t;
+			crossover[DISPATCH_P3D_SELF_DVORT][t] = measure_crossover(
+				[&](int n) { cvtx_P3D_self_dvort(p3, n, r3, f, reg_rad); });
+		}
+	}
+	for (VortFuncType t : viscous) {
+		const cvtx_VortFunc *f = funcs + t;
+		crossover[DISPATCH_P3D_SELF_VISC_DVORT][t] = measure_crossover(
+			[&](int n) { cvtx_P3D_self_visc_dvort(p3, n, r3, f, reg_rad, 
+				0.1f); });
+		crossover[DISPATCH_P3D_M2M_VISC_DVORT][t] = measure_crossover([&](int n) {
+			cvtx_P3D_M2M_visc_dvort(p3, n, p3, n, r3, f, reg_rad, 0.1f); });
+		crossover[DISPATCH_P3D_M2M_VEL_DVORT_VISC][t] = measure_crossover(
+			[&](int n) { cvtx_P3D_M2M_vel_dvort_visc(p3, n, p3, n, r3, 
+				r3 + max_n, r3 + 2 * max_n, f, reg_rad, 0.1f); });
+		crossover[DISPATCH_P2D_M2M_VISC_DVORT][t] = measure_crossover([&](int n) {
+			cvtx_P2D_M2M_visc_dvort(p2, n, p2, n, resf.data(), f, reg_rad, 0.1f); });
+	}
+	/* The filaments have only the singular kernel. P3D_M2M_vort isn't 
+	measured: it prefers the cell list so rarely reaches the accelerators. */
+	crossover[DISPATCH_F3D_M2M_VEL][VORTFUNC_OTHER] = measure_crossover(
+		[&](int n) { cvtx_F3D_M2M_vel(f3, n, points.data(), n, r3); });
+	crossover[DISPATCH_F3D_M2M_DVORT][VORTFUNC_OTHER] = measure_crossover(
+		[&](int n) { cvtx_F3D_M2M_dvort(f3, n, p3, n, r3); });
+	save_profile();
+	return 0;
+}
+
+#endif /* CVTX_USING_OPENCL */
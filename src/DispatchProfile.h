@@ -0,0 +1,77 @@
+#ifndef CVTX_DISPATCHPROFILE_H
+#define CVTX_DISPATCHPROFILE_H
+#include "libcvtx.h"
+/*============================================================================
+DispatchProfile.h
+
+Chooses between the CPU and the accelerators for brute force interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+#include "VortFunc.h"
+
+/* The brute force functions that can run on the CPU or the accelerators. */
+enum DispatchFunction {
+	DISPATCH_P3D_M2M_VEL,
+	DISPATCH_P3D_M2M_DVORT,
+	DISPATCH_P3D_M2M_VISC_DVORT,
+	DISPATCH_P3D_M2M_VEL_DVORT_VISC,
+	DISPATCH_P3D_M2M_VORT,
+	DISPATCH_P2D_M2M_VEL,
+	DISPATCH_P2D_M2M_VISC_DVORT,
+	DISPATCH_F3D_M2M_VEL,
+	DISPATCH_F3D_M2M_DVORT,
+	/* The self interactions run the M2M kernels on the accelerators, but
+	evaluate each pair once on the CPU, so cross over later. */
+	DISPATCH_P3D_SELF_DVORT,
+	DISPATCH_P3D_SELF_VISC_DVORT,
+	DISPATCH_NUM_FUNCTIONS
+};
+
+/* Whether num_sources acting on num_targets should be given to the 
+accelerators rather than the CPU. Uses the crossover measured by 
+dispatch_calibrate where there is one, and a rule of thumb otherwise. 
+The calibration only times square problems, so neither dimension may be 
+too small to fill the accelerator. */
+bool dispatch_to_accelerator(
+	DispatchFunction function,
+	VortFuncType regularisation,
+	long long num_sources,
+	long long num_targets);
+
+/* Read the profile saved for the enabled accelerators, or make one if
+CVTX_ACCELERATOR_CALIBRATE=1. Called by opencl_load once the accelerators 
+are ready. */
+void dispatch_load_profile();
+
+/* Time the CPU and the enabled accelerators over a range of problem sizes
+to find where the accelerators become faster. The crossovers are used from
+then on, and saved to the accelerator cache directory if there is one.
+Returns 0 on success, or -1 if no accelerator is enabled. */
+int dispatch_calibrate();
+
+/* True while this thread's dispatch_calibrate is timing a single backend,
+so work shouldn't be shared between them. */
+bool dispatch_calibrating();
+
+#endif /* CVTX_USING_OPENCL */
+#endif /* CVTX_DISPATCHPROFILE_H */
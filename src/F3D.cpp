@@ -27,6 +27,8 @@ SOFTWARE.
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include "DispatchProfile.h"
+#include "ParticleView.h"
 #include "ocl_F3D.h"
 
 static const float pi_f = 3.14159265359f;
@@ -84,19 +86,18 @@ CVTX_EXPORT bsv_V3f cvtx_F3D_S2S_dvort(
 	return ret;
 };
 
-CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_vel(
-	const cvtx_F3D **array_start,
+static bsv_V3f F3D_M2S_vel(
+	const F3DView &array_start,
 	const int num_particles,
 	const bsv_V3f mes_point) 
 {
 	assert(num_particles >= 0);
-	assert(array_start != NULL);
 	bsv_V3f vel;
 	/* Using Neumaier summation has no effect on result. */
 	double rx = 0, ry = 0, rz = 0;
 	long i;
 	for (i = 0; i < num_particles; ++i) {
-		vel = cvtx_F3D_S2S_vel(array_start[i],
+		vel = cvtx_F3D_S2S_vel(&array_start[i],
 			mes_point);
 		rx += vel.x[0];
 		ry += vel.x[1];
@@ -106,18 +107,26 @@ CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_vel(
 	return ret;
 }
 
-CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_dvort(
+CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_vel(
 	const cvtx_F3D **array_start,
 	const int num_particles,
+	const bsv_V3f mes_point)
+{
+	assert(array_start != NULL);
+	return F3D_M2S_vel(array_start, num_particles, mes_point);
+}
+
+static bsv_V3f F3D_M2S_dvort(
+	const F3DView &array_start,
+	const int num_particles,
 	const cvtx_P3D *induced_particle) 
 {
 	assert(num_particles >= 0);
-	assert(array_start != NULL);
 	bsv_V3f dvort;
 	double rx = 0, ry = 0, rz = 0;
 	long i;
 	for (i = 0; i < num_particles; ++i) {
-		dvort = cvtx_F3D_S2S_dvort(array_start[i],
+		dvort = cvtx_F3D_S2S_dvort(&array_start[i],
 			induced_particle);
 		rx += dvort.x[0];
 		ry += dvort.x[1];
@@ -127,9 +136,18 @@ CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_dvort(
 	return ret;
 }
 
-void cpu_brute_force_StraightVortFilArr_Arr_ind_vel(
+CVTX_EXPORT bsv_V3f cvtx_F3D_M2S_dvort(
 	const cvtx_F3D **array_start,
 	const int num_particles,
+	const cvtx_P3D *induced_particle)
+{
+	assert(array_start != NULL);
+	return F3D_M2S_dvort(array_start, num_particles, induced_particle);
+}
+
+static void cpu_brute_force_StraightVortFilArr_Arr_ind_vel(
+	const F3DView &array_start,
+	const int num_particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array) 
@@ -137,37 +155,39 @@ void cpu_brute_force_StraightVortFilArr_Arr_ind_vel(
 	long i;
 #pragma omp parallel for schedule(static)
 	for (i = 0; i < num_mes; ++i) {
-		result_array[i] = cvtx_F3D_M2S_vel(
+		result_array[i] = F3D_M2S_vel(
 			array_start, num_particles, mes_start[i]);
 	}
 	return;
 }
 
-void cpu_brute_force_StraightVortFilArr_Arr_ind_dvort(
-	const cvtx_F3D **array_start,
+static void cpu_brute_force_StraightVortFilArr_Arr_ind_dvort(
+	const F3DView &array_start,
 	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array) 
 {
 	long i;
 #pragma omp parallel for schedule(static)
 	for (i = 0; i < num_induced; ++i) {
-		result_array[i] = cvtx_F3D_M2S_dvort(
-			array_start, num_particles, induced_start[i]);
+		result_array[i] = F3D_M2S_dvort(
+			array_start, num_particles, &induced_start[i]);
 	}
 	return;
 }
 
-CVTX_EXPORT void cvtx_F3D_M2M_vel(
-	const cvtx_F3D **array_start,
+static void F3D_M2M_vel_impl(
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array)
 {
 #ifdef CVTX_USING_OPENCL
-	if (opencl_brute_force_F3D_M2M_vel(
+	if (!dispatch_to_accelerator(DISPATCH_F3D_M2M_VEL, VORTFUNC_OTHER,
+			num_filaments, num_mes)
+		|| opencl_brute_force_F3D_M2M_vel(
 			array_start, num_filaments, mes_start,
 			num_mes, result_array) != 0)
 #endif
@@ -179,16 +199,41 @@ CVTX_EXPORT void cvtx_F3D_M2M_vel(
 	return;
 }
 
-CVTX_EXPORT void cvtx_F3D_M2M_dvort(
+CVTX_EXPORT void cvtx_F3D_M2M_vel(
 	const cvtx_F3D **array_start,
+	const int num_filaments,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array)
+{
+	F3D_M2M_vel_impl(array_start, num_filaments, mes_start, num_mes,
+		result_array);
+	return;
+}
+
+CVTX_EXPORT void cvtx_F3D_M2M_vel_strided(
+	const cvtx_F3D *filaments,
+	size_t stride,
+	const int num_filaments,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array)
+{
+	F3D_M2M_vel_impl(F3DView(filaments, stride), num_filaments, mes_start,
+		num_mes, result_array);
+	return;
+}
+
+static void F3D_M2M_dvort_impl(
+	const F3DView &array_start,
 	const int num_fil,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array)
 {
 #ifdef CVTX_USING_OPENCL
-	if (num_fil < 256
-		|| num_induced < 256
+	if (!dispatch_to_accelerator(DISPATCH_F3D_M2M_DVORT, VORTFUNC_OTHER,
+			num_fil, num_induced)
 		|| opencl_brute_force_F3D_M2M_dvort(
 			array_start, num_fil, induced_start,
 			num_induced, result_array) != 0)
@@ -201,6 +246,32 @@ CVTX_EXPORT void cvtx_F3D_M2M_dvort(
 	return;
 }
 
+CVTX_EXPORT void cvtx_F3D_M2M_dvort(
+	const cvtx_F3D **array_start,
+	const int num_fil,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array)
+{
+	F3D_M2M_dvort_impl(array_start, num_fil, induced_start, num_induced,
+		result_array);
+	return;
+}
+
+CVTX_EXPORT void cvtx_F3D_M2M_dvort_strided(
+	const cvtx_F3D *filaments,
+	size_t stride,
+	const int num_fil,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array)
+{
+	F3D_M2M_dvort_impl(F3DView(filaments, stride), num_fil,
+		P3DView(induced, induced_stride), num_induced, result_array);
+	return;
+}
+
 CVTX_EXPORT void cvtx_F3D_inf_mtrx(
 	const cvtx_F3D **array_start,
 	const int num_filaments,
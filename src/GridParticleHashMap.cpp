@@ -0,0 +1,170 @@
+#include "GridParticleHashMap.h"
+/*============================================================================
+GridParticleHashMap.cpp
+
+A set of vortex particles on a grid accumulated in an open addressing
+hash map.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <algorithm>
+#include <cassert>
+
+/* The map is rehashed to double the slots once it is half full. */
+static const size_t min_slots = 64;
+
+/* Whether the highest set bit of a is lower than that of b. */
+static inline bool less_msb(uint32_t a, uint32_t b)
+{
+	return a < b && a < (a ^ b);
+}
+
+/* Morton order, interleaving the bits of the keys as z, y, x. */
+static bool morton_less(const UIntKey96 &a, const UIntKey96 &b)
+{
+	uint32_t ak[3] = { a.k.x, a.k.y, a.k.z };
+	uint32_t bk[3] = { b.k.x, b.k.y, b.k.z };
+	int dim = 2, d;
+	for (d = 1; d >= 0; --d) {
+		if (less_msb(ak[dim] ^ bk[dim], ak[d] ^ bk[d])) { dim = d; }
+	}
+	return ak[dim] < bk[dim];
+}
+
+GridParticleHashMap::GridParticleHashMap()
+	: m_slots(), m_size(0)
+{
+}
+
+UIntKey96 GridParticleHashMap::empty_key()
+{
+	return UIntKey96(UINT32_MAX, UINT32_MAX, UINT32_MAX);
+}
+
+uint64_t GridParticleHashMap::hash(const UIntKey96 &key)
+{
+	/* Neighbouring grid points differ in their low bits, so mix them 
+	into the high bits that select a slot. */
+	uint64_t h = key.v.lo * 0x9E3779B97F4A7C15ull
+		^ (uint64_t)key.v.up * 0xC2B2AE3D27D4EB4Full;
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	return h ^ (h >> 33);
+}
+
+void GridParticleHashMap::add_particle(UIntKey96 key, bsv_V3f str)
+{
+	if (bsv_V3f_isequal(str, bsv_V3f_zero())) { return; }
+	if (2 * (m_size + 1) > m_slots.size()) {
+		rehash(std::max(min_slots, 2 * m_slots.size()));
+	}
+	insert(key, str);
+}
+
+void GridParticleHashMap::add_particles(
+	const std::vector<UIntKey96> &keys, const std::vector<bsv_V3f> &strs)
+{
+	assert(keys.size() == strs.size());
+	for (size_t i = 0; i < keys.size(); ++i) {
+		add_particle(keys[i], strs[i]);
+	}
+}
+
+void GridParticleHashMap::insert(const UIntKey96 &key, bsv_V3f str)
+{
+	assert(!(key == empty_key()));
+	size_t mask = m_slots.size() - 1;
+	size_t idx = hash(key) & mask;
+	/* Linear probing - there is always an empty slot to stop at. */
+	while (!(m_slots[idx].key == empty_key())) {
+		if (m_slots[idx].key == key) {
+			m_slots[idx].vorticity = bsv_V3f_plus(m_slots[idx].vorticity, str);
+			return;
+		}
+		idx = (idx + 1) & mask;
+	}
+	m_slots[idx].key = key;
+	m_slots[idx].vorticity = str;
+	m_size++;
+}
+
+void GridParticleHashMap::rehash(size_t num_slots)
+{
+	std::vector<Slot> slots(num_slots);
+	for (Slot &slot : slots) {
+		slot.key = empty_key();
+	}
+	/* Reinsert the old slots into the new. */
+	slots.swap(m_slots);
+	m_size = 0;
+	for (const Slot &slot : slots) {
+		if (!(slot.key == empty_key())) {
+			insert(slot.key, slot.vorticity);
+		}
+	}
+}
+
+size_t GridParticleHashMap::number_of_particles() const
+{
+	return m_size;
+}
+
+void GridParticleHashMap::flatten(
+	UIntKey96* idxs, bsv_V3f* strs, int max_particles) const
+{
+	std::vector<const Slot*> used;
+	size_t i;
+	used.reserve(m_size);
+	for (const Slot &slot : m_slots) {
+		if (!(slot.key == empty_key())) { used.push_back(&slot); }
+	}
+	std::sort(used.begin(), used.end(), 
+		[](const Slot *a, const Slot *b) { 
+			return morton_less(a->key, b->key); });
+	for (i = 0; i < used.size() && i < (size_t)max_particles; ++i) {
+		idxs[i] = used[i]->key;
+		strs[i] = used[i]->vorticity;
+	}
+}
+
+void GridParticleHashMap::merge_in(const GridParticleHashMap &other)
+{
+	reserve(m_size + other.m_size);
+	for (const Slot &slot : other.m_slots) {
+		if (!(slot.key == empty_key())) {
+			insert(slot.key, slot.vorticity);
+		}
+	}
+}
+
+void GridParticleHashMap::reserve(size_t num_particles)
+{
+	size_t num_slots = std::max(min_slots, m_slots.size());
+	while (2 * num_particles > num_slots) { num_slots *= 2; }
+	if (num_slots > m_slots.size()) { rehash(num_slots); }
+}
+
+void GridParticleHashMap::clear()
+{
+	m_slots.clear();
+	m_size = 0;
+}
@@ -0,0 +1,81 @@
+#ifndef CVTX_GRIDPARTICLEHASHMAP_H
+#define CVTX_GRIDPARTICLEHASHMAP_H
+/*============================================================================
+GridParticleHashMap.h
+
+A set of vortex particles on a grid accumulated in an open addressing
+hash map.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cstdint>
+#include <vector>
+
+#include <bsv/bsv_V3f.h>
+
+#include "UIntKey96.h"
+
+class GridParticleHashMap {
+public:
+	GridParticleHashMap();
+
+	/* Adds vorticity str at location given by key. 
+	It is added to any vorticity already at that grid point.*/
+	void add_particle(UIntKey96 key, bsv_V3f str);
+	void add_particles(
+		const std::vector<UIntKey96> &keys, const std::vector<bsv_V3f> &strs);
+
+	/* The number of grid points with vorticity. */
+	size_t number_of_particles() const;
+
+	/* Get up to max_particles index / strength pairs, ordered along the
+	Morton curve so that the output doesn't depend on insertion order. */
+	void flatten(UIntKey96* idxs, bsv_V3f* strs, int max_particles) const;
+
+	/* Merge another GridParticleHashMap into this one. */
+	void merge_in(const GridParticleHashMap&);
+
+	/* Make room for num_particles without rehashing. */
+	void reserve(size_t num_particles);
+
+	/* Empty the map of all particles. */
+	void clear();
+
+protected:
+	/* Keys and vorticities side by side so a probe touches one line. */
+	struct Slot {
+		UIntKey96 key;
+		bsv_V3f vorticity;
+	};
+	std::vector<Slot> m_slots;	/* Size is a power of two. */
+	size_t m_size;
+
+	/* A key of all ones marks an empty slot. Grid keys are offsets from
+	a corner near the particles, so never reach it. */
+	static UIntKey96 empty_key();
+	static uint64_t hash(const UIntKey96 &key);
+	void rehash(size_t num_slots);
+	/* Adds to key's slot, which there must be room for. */
+	void insert(const UIntKey96 &key, bsv_V3f str);
+};
+
+#endif /* CVTX_GRIDPARTICLEHASHMAP_H */
@@ -27,6 +27,7 @@ SOFTWARE.
 #ifdef CVTX_USING_OPENCL
 
 #include <cassert>
+#include "opencl_acc.h"
 
 OclDeviceState::OclDeviceState(cl_platform_id plat_id, cl_device_id dev_id)
 	:	m_device_id(dev_id),
@@ -36,12 +37,19 @@ OclDeviceState::OclDeviceState(cl_platform_id plat_id, cl_device_id dev_id)
 		m_device_queue_initialised(false),
 		m_device_info_initialised(false),
 		m_device_driver_version(""),
-		m_device_compute_units(-1)
+		m_device_compute_units(-1),
+		m_throughput(0.),
+		m_context(NULL),
+		m_program(NULL),
+		m_workgroup_size(CVTX_WORKGROUP_SIZE),
+		m_mutex(new std::mutex),
+		m_launch_mutex(new std::mutex)
 {
 }
 
 OclDeviceState::~OclDeviceState()
 {
+	release_caches();
 	if (m_device_queue != NULL) {
 		clReleaseCommandQueue(m_device_queue);
 	}
@@ -53,15 +61,32 @@ OclDeviceState::~OclDeviceState()
 OclDeviceState::OclDeviceState(OclDeviceState&& orig) noexcept
 	: m_good(orig.m_good), 
 	m_device_queue_initialised(orig.m_device_queue_initialised),
+	m_device_info_initialised(orig.m_device_info_initialised),
 	m_device_id(orig.m_device_id),
 	m_device_name(orig.m_device_name),
-	m_device_queue(orig.m_device_queue)
+	m_device_queue(orig.m_device_queue),
+	m_device_driver_version(orig.m_device_driver_version),
+	m_device_compute_units(orig.m_device_compute_units),
+	m_throughput(orig.m_throughput),
+	m_context(orig.m_context),
+	m_program(orig.m_program),
+	m_workgroup_size(orig.m_workgroup_size),
+	m_kernels(std::move(orig.m_kernels)),
+	m_free_buffers(std::move(orig.m_free_buffers)),
+	m_lent_buffers(std::move(orig.m_lent_buffers)),
+	m_mutex(std::move(orig.m_mutex)),
+	m_launch_mutex(std::move(orig.m_launch_mutex))
 {
 	orig.m_good = false;
 	orig.m_device_info_initialised = false;
 	orig.m_device_id = NULL;
 	orig.m_device_name = "";
 	orig.m_device_queue = NULL;
+	orig.m_context = NULL;
+	orig.m_program = NULL;
+	orig.m_kernels.clear();
+	orig.m_free_buffers.clear();
+	orig.m_lent_buffers.clear();
 }
 
 void OclDeviceState::initialise_device_info()
@@ -99,6 +124,7 @@ void OclDeviceState::initialise_device_queue(cl_context context)
 	if (status != CL_SUCCESS) {
 		m_good = 0;
 	}
+	m_context = context;
 	m_device_queue_initialised = true;
 }
 
@@ -112,10 +138,143 @@ const cl_command_queue OclDeviceState::queue()
 	return m_device_queue;
 }
 
+const cl_context OclDeviceState::context()
+{
+	return m_context;
+}
+
 std::string& OclDeviceState::name_ref()
 {
 	return m_device_name;
 }
 
+int OclDeviceState::compute_units()
+{
+	return m_device_compute_units;
+}
+
+double OclDeviceState::throughput()
+{
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	return m_throughput;
+}
+
+void OclDeviceState::record_throughput(double interactions, double seconds)
+{
+	double measured;
+	if (seconds <= 0.) { return; }
+	measured = interactions / seconds;
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	/* Average with the history so one noisy call doesn't swing the split. */
+	m_throughput = m_throughput == 0. ? measured 
+		: 0.5 * (m_throughput + measured);
+}
+
+cl_program OclDeviceState::program()
+{
+	return m_program;
+}
+
+int OclDeviceState::workgroup_size()
+{
+	return m_workgroup_size;
+}
+
+void OclDeviceState::use_program(cl_program program, int workgroup_size)
+{
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	/* Kernels are cached by name, so those of the old variant must go. */
+	if (program != m_program) {
+		for (auto &kernel : m_kernels) {
+			clReleaseKernel(kernel.second);
+		}
+		m_kernels.clear();
+	}
+	m_program = program;
+	m_workgroup_size = workgroup_size;
+}
+
+cl_kernel OclDeviceState::kernel(cl_program program, const std::string &name)
+{
+	cl_int status;
+	cl_kernel kernel;
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	auto found = m_kernels.find(name);
+	if (found != m_kernels.end()) {
+		return found->second;
+	}
+	kernel = clCreateKernel(program, name.c_str(), &status);
+	if (status != CL_SUCCESS) {
+		return NULL;
+	}
+	m_kernels[name] = kernel;
+	return kernel;
+}
+
+std::mutex &OclDeviceState::launch_mutex()
+{
+	return *m_launch_mutex;
+}
+
+cl_mem OclDeviceState::acquire_buffer(size_t size, cl_int *status)
+{
+	assert(m_context != NULL);
+	/* Power of two size classes, so a buffer can be reused for anything
+	up to twice the size of the request. */
+	size_t size_class = 1024;
+	cl_mem buffer;
+	while (size_class < size) { size_class *= 2; }
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	std::vector<cl_mem> &free_buffers = m_free_buffers[size_class];
+	if (free_buffers.size() > 0) {
+		buffer = free_buffers.back();
+		free_buffers.pop_back();
+		*status = CL_SUCCESS;
+	}
+	else {
+		buffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE, size_class,
+			NULL, status);
+		if (*status != CL_SUCCESS) {
+			return NULL;
+		}
+	}
+	m_lent_buffers[buffer] = size_class;
+	return buffer;
+}
+
+void OclDeviceState::release_buffer(cl_mem buffer)
+{
+	/* No point holding on to more than a few of any size. */
+	const size_t max_free_per_class = 8;
+	if (buffer == NULL) { return; }
+	std::lock_guard<std::mutex> lock(*m_mutex);
+	auto lent = m_lent_buffers.find(buffer);
+	assert(lent != m_lent_buffers.end());
+	std::vector<cl_mem> &free_buffers = m_free_buffers[lent->second];
+	m_lent_buffers.erase(lent);
+	if (free_buffers.size() < max_free_per_class) {
+		free_buffers.push_back(buffer);
+	}
+	else {
+		clReleaseMemObject(buffer);
+	}
+}
+
+void OclDeviceState::release_caches()
+{
+	for (auto &kernel : m_kernels) {
+		clReleaseKernel(kernel.second);
+	}
+	m_kernels.clear();
+	for (auto &size_class : m_free_buffers) {
+		for (cl_mem buffer : size_class.second) {
+			clReleaseMemObject(buffer);
+		}
+	}
+	m_free_buffers.clear();
+	/* Lent buffers belong to their borrower until returned. */
+	assert(m_lent_buffers.size() == 0);
+}
+
 #endif /*CVTX_USING_OPENCL*/
 
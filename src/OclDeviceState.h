@@ -27,7 +27,11 @@ SOFTWARE.
 #ifndef CVTX_OCLDEVICESTATE_H
 #define CVTX_OCLDEVICESTATE_H
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <CL/cl.h>
 
 class OclDeviceState {
@@ -41,6 +45,21 @@ protected:
 	cl_command_queue m_device_queue;
 	std::string m_device_driver_version;
 	int m_device_compute_units;
+	/* Measured interactions per second, or 0 before any measurement. */
+	double m_throughput;
+	cl_context m_context;
+	/* The program variant the device uses, and its workgroup size. */
+	cl_program m_program;
+	int m_workgroup_size;
+	/* Kernels are created once per device and reused. */
+	std::map<std::string, cl_kernel> m_kernels;
+	/* Free scratch buffers by size class, and the class of lent ones. */
+	std::map<size_t, std::vector<cl_mem>> m_free_buffers;
+	std::map<cl_mem, size_t> m_lent_buffers;
+	/* Guards the caches and throughput. Mutexes can't be moved, so they 
+	are held by pointer. */
+	std::unique_ptr<std::mutex> m_mutex;
+	std::unique_ptr<std::mutex> m_launch_mutex;
 
 public:
 	OclDeviceState(cl_platform_id, cl_device_id);
@@ -53,7 +72,37 @@ public:
 	void initialise_device_queue(cl_context context);
 	const cl_device_id device_id();
 	const cl_command_queue queue();
+	const cl_context context();
 	std::string& name_ref();
+	int compute_units();
+
+	/* Interactions per second, or 0 if it hasn't been measured. */
+	double throughput();
+	/* Fold a measurement of interactions taking seconds into the 
+	throughput. */
+	void record_throughput(double interactions, double seconds);
+
+	/* The program variant built for workgroup_size() work items. */
+	cl_program program();
+	int workgroup_size();
+	/* Use the variant of program built for workgroup_size. The platform
+	owns the program. */
+	void use_program(cl_program program, int workgroup_size);
+
+	/* The named kernel of program, or NULL on failure. The device owns 
+	the kernel - don't release it. */
+	cl_kernel kernel(cl_program program, const std::string &name);
+	/* Every thread using the device shares its kernels, so hold this from
+	setting a kernel's arguments until it is enqueued. */
+	std::mutex &launch_mutex();
+	/* A read / write buffer of at least size bytes from the device's 
+	pool. Return it with release_buffer. NULL on failure. */
+	cl_mem acquire_buffer(size_t size, cl_int *status);
+	/* The queue is in order, so a buffer can be returned as soon as the 
+	commands using it are enqueued. Releasing NULL does nothing. */
+	void release_buffer(cl_mem buffer);
+protected:
+	void release_caches();
 };
 
 #endif
@@ -0,0 +1,189 @@
+#include "OclP3DBuffers.h"
+/*============================================================================
+OclP3DBuffers.cpp
+
+A copy of a cvtx_P3D_soa in OpenCL device memory.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+
+#include <cassert>
+
+#include "opencl_acc.h"
+#include "OclDeviceState.h"
+#include "P3D_soa.h"
+
+OclP3DBuffers::OclP3DBuffers()
+	: m_size(0), m_context(NULL), m_queue(NULL), m_pool(NULL),
+	m_coords(NULL), m_vorticities(NULL)
+{
+}
+
+OclP3DBuffers::~OclP3DBuffers()
+{
+	release();
+}
+
+void OclP3DBuffers::release()
+{
+	if (m_coords != NULL) { release_buffer(m_coords); }
+	if (m_vorticities != NULL) { release_buffer(m_vorticities); }
+	/* We hold a reference so the queue outlives opencl_finalise(). */
+	if (m_queue != NULL) { clReleaseCommandQueue(m_queue); }
+	if (m_context != NULL) { clReleaseContext(m_context); }
+	m_coords = m_vorticities = NULL;
+	m_queue = NULL;
+	m_context = NULL;
+	m_pool = NULL;
+	m_size = 0;
+}
+
+int OclP3DBuffers::upload(
+	const cvtx_P3D_soa &particles,
+	cl_context context,
+	cl_command_queue queue)
+{
+	return upload(particles, context, queue, NULL);
+}
+
+int OclP3DBuffers::upload(
+	const cvtx_P3D_soa &particles,
+	OclDeviceState &device)
+{
+	return upload(particles, device.context(), device.queue(), &device);
+}
+
+int OclP3DBuffers::upload(const cvtx_P3D_soa &particles)
+{
+	assert(m_context != NULL);
+	return upload(particles, m_context, m_queue, m_pool);
+}
+
+int OclP3DBuffers::upload(
+	const cvtx_P3D_soa &particles,
+	cl_context context,
+	cl_command_queue queue,
+	OclDeviceState *pool)
+{
+	cl_int status = CL_SUCCESS;
+	int num = particles.size();
+	if (context != m_context || queue != m_queue || num != m_size
+		|| pool != m_pool) {
+		/* Retain before release() in case context is m_context. */
+		clRetainContext(context);
+		clRetainCommandQueue(queue);
+		release();
+		m_context = context;
+		m_queue = queue;
+		m_pool = pool;
+		if (num == 0) {
+			release();
+			return -1;
+		}
+		m_coords = create_buffer(sizeof(cl_float4) * num, &status);
+		if (status == CL_SUCCESS) {
+			m_vorticities = create_buffer(sizeof(cl_float4) * num, &status);
+		}
+		if (status != CL_SUCCESS) {
+			release();
+			return -1;
+		}
+		m_size = num;
+	}
+	if (	update_coords(particles) != 0 
+		||	update_vorticities(particles) != 0) {
+		release();
+		return -1;
+	}
+	return 0;
+}
+
+int OclP3DBuffers::update_coords(const cvtx_P3D_soa &particles)
+{
+	assert(particles.size() == m_size);
+	const float *xyz[3] = { 
+		particles.coord(0), particles.coord(1), particles.coord(2) };
+	return write_float4s(m_coords, xyz, particles.volume());
+}
+
+int OclP3DBuffers::update_vorticities(const cvtx_P3D_soa &particles)
+{
+	assert(particles.size() == m_size);
+	const float *xyz[3] = { particles.vorticity(0), 
+		particles.vorticity(1), particles.vorticity(2) };
+	return write_float4s(m_vorticities, xyz, NULL);
+}
+
+int OclP3DBuffers::update_volumes(const cvtx_P3D_soa &particles)
+{
+	/* The volumes are packed with the coordinates. */
+	return update_coords(particles);
+}
+
+cl_mem OclP3DBuffers::create_buffer(size_t size, cl_int *status)
+{
+	if (m_pool != NULL) {
+		return m_pool->acquire_buffer(size, status);
+	}
+	return clCreateBuffer(m_context, CL_MEM_READ_ONLY, size, NULL, status);
+}
+
+void OclP3DBuffers::release_buffer(cl_mem buffer)
+{
+	if (m_pool != NULL) {
+		m_pool->release_buffer(buffer);
+	}
+	else {
+		clReleaseMemObject(buffer);
+	}
+}
+
+int OclP3DBuffers::write_float4s(
+	cl_mem buffer, 
+	const float * const *xyz, 
+	const float *w)
+{
+	int i;
+	cl_int status;
+	assert(buffer != NULL);
+	m_staging.resize(m_size);
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < m_size; ++i) {
+		m_staging[i].x = xyz[0][i];
+		m_staging[i].y = xyz[1][i];
+		m_staging[i].z = xyz[2][i];
+		m_staging[i].w = w != NULL ? w[i] : 0.f;
+	}
+	/* Buffers without a pool belong to a cvtx_P3D_soa. Kernels on any of 
+	the context's queues may still be reading them for a pending 
+	asynchronous request, and only m_queue is ordered with the write. */
+	if (m_pool == NULL) {
+		opencl_finish_context(m_context);
+	}
+	/* Blocking, so the staging buffer can be reused immediately and the
+	data is ready for kernels enqueued on any of the context's queues. */
+	status = clEnqueueWriteBuffer(m_queue, buffer, CL_TRUE, 0,
+		sizeof(cl_float4) * m_size, m_staging.data(), 0, NULL, NULL);
+	return status == CL_SUCCESS ? 0 : -1;
+}
+
+#endif /* CVTX_USING_OPENCL */
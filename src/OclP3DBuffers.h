@@ -0,0 +1,91 @@
+/*============================================================================
+OclP3DBuffers.h
+
+A copy of a cvtx_P3D_soa in OpenCL device memory.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+#ifndef CVTX_OCLP3DBUFFERS_H
+#define CVTX_OCLP3DBUFFERS_H
+
+#include <vector>
+#include <CL/cl.h>
+
+struct cvtx_P3D_soa;
+class OclDeviceState;
+
+/* The particles are stored in the packed float4 layout the nbody.cl
+kernels take: coordinates with the volume in w, and vorticities with w
+unused. The P3D kernels loop over the inducing particles themselves,
+so the buffers hold exactly size() particles with no padding. */
+class OclP3DBuffers {
+public:
+	OclP3DBuffers();
+	~OclP3DBuffers();
+
+	/* Copy the particles to the device, reusing the existing buffers 
+	if they are the right size. Returns 0 on success, -1 otherwise. */
+	int upload(const cvtx_P3D_soa &particles, cl_context context,
+		cl_command_queue queue);
+	/* As above, but with scratch buffers from the device's pool. The
+	device must outlive this. */
+	int upload(const cvtx_P3D_soa &particles, OclDeviceState &device);
+	/* As above, to the same device as last time. */
+	int upload(const cvtx_P3D_soa &particles);
+	/* Copy a single field of particles, which must be the same size as 
+	when uploaded. The coordinates and volumes share a buffer, so updating
+	either copies both. Without a pool, the buffers may be read by every
+	device of the context, so their queues are finished first. Returns 0
+	on success, -1 otherwise. */
+	int update_coords(const cvtx_P3D_soa &particles);
+	int update_vorticities(const cvtx_P3D_soa &particles);
+	int update_volumes(const cvtx_P3D_soa &particles);
+	void release();
+
+	int size() const { return m_size; }
+	cl_context context() const { return m_context; }
+	cl_mem coords() const { return m_coords; }
+	cl_mem vorticities() const { return m_vorticities; }
+
+protected:
+	int m_size;
+	cl_context m_context;
+	cl_command_queue m_queue;
+	OclDeviceState *m_pool;
+	cl_mem m_coords, m_vorticities;
+	std::vector<cl_float4> m_staging;
+
+	int upload(const cvtx_P3D_soa &particles, cl_context context,
+		cl_command_queue queue, OclDeviceState *pool);
+	cl_mem create_buffer(size_t size, cl_int *status);
+	void release_buffer(cl_mem buffer);
+	/* Write xyz, with w in the fourth component or 0 if w is NULL. */
+	int write_float4s(cl_mem buffer, const float * const *xyz, 
+		const float *w);
+
+	/* Not copyable. */
+	OclP3DBuffers(const OclP3DBuffers&);
+	OclP3DBuffers &operator=(const OclP3DBuffers&);
+};
+
+#endif /* CVTX_OCLP3DBUFFERS_H */
+#endif /* CVTX_USING_OPENCL */
@@ -26,13 +26,59 @@ SOFTWARE.
 ============================================================================*/
 #ifdef CVTX_USING_OPENCL
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
 #include "opencl_acc.h"
+#include "OclProgramCache.h"
+
+/* Workgroup sizes the program can be built for where the devices allow. */
+static const int candidate_workgroup_sizes[] = { 64, 128, 256, 512 };
+/* The fused vel_dvort_visc kernels need three float3s per work item. */
+static const size_t local_bytes_per_work_item = 3 * sizeof(cl_float3);
+/* The kernel timed to pick a variant, and the ones most likely to be 
+limited by registers to smaller workgroups. */
+static const char *tuning_kernel = "cvtx_nb_P3D_vel_winckelmans";
+static const char *limiting_kernels[] = { 
+	"cvtx_nb_P3D_vel_winckelmans",
+	"cvtx_nb_P3D_vel_dvort_visc_gaussian",
+	"cvtx_nb_Filament_ind_dvort_singular" };
+/* Building and timing variants stops after this long, keeping the best 
+so far. A variant's build can take seconds. */
+static const double tuning_budget_seconds = 2.;
+/* Workgroup sizes tuned by this process, so that reinitialising doesn't
+tune again. Keyed by device and the variants that were allowed. */
+static struct TunedSizes {
+	std::mutex mutex;
+	std::map<std::pair<cl_device_id, std::string>, int> sizes;
+} tuned_sizes;
+
+/* The size tuned for device by this process, or 0. */
+static int tuned_workgroup_size(cl_device_id device, 
+	const std::string &variants)
+{
+	std::lock_guard<std::mutex> lock(tuned_sizes.mutex);
+	auto found = tuned_sizes.sizes.find(std::make_pair(device, variants));
+	return found != tuned_sizes.sizes.end() ? found->second : 0;
+}
+
+static void remember_workgroup_size(cl_device_id device, 
+	const std::string &variants, int workgroup_size)
+{
+	std::lock_guard<std::mutex> lock(tuned_sizes.mutex);
+	tuned_sizes.sizes[std::make_pair(device, variants)] = workgroup_size;
+}
+static const std::string program_source =
+#	include "nbody.cl"
+	;	/* Including in source makes it easier to distribute a shared lib. */
 
 OclPlatformState::OclPlatformState(cl_platform_id plat_id)
 	: m_platform(plat_id),
-	m_platform_name(), m_program(NULL), m_context(NULL),
+	m_platform_name(), m_programs(), m_workgroup_sizes(), m_context(NULL),
 	m_program_build_log(), m_devices(), m_good(false), 
 	m_initialised_platform_and_program(false),
 	m_initialised_devices(false)
@@ -51,13 +97,14 @@ OclPlatformState::OclPlatformState(cl_platform_id plat_id)
 
 OclPlatformState::~OclPlatformState()
 {
-	if (m_program != NULL) {
-		clReleaseProgram(m_program);
+	/* Devices cache kernels of the programs, so go first. */
+	m_devices.clear();
+	for (auto &program : m_programs) {
+		clReleaseProgram(program.second);
 	}
 	if (m_context != NULL) { 
 		clReleaseContext(m_context); 
 	}
-	m_devices.clear();
 	/* These'll happen automatically
 	platform_name.clear();
 	program_build_log.clear(); */
@@ -68,7 +115,8 @@ OclPlatformState::OclPlatformState(OclPlatformState&& orig) noexcept
 	m_initialised_platform_and_program(orig.m_initialised_platform_and_program),
 	m_platform(orig.m_platform),
 	m_platform_name(orig.m_platform_name),
-	m_program(orig.m_program),
+	m_programs(std::move(orig.m_programs)),
+	m_workgroup_sizes(std::move(orig.m_workgroup_sizes)),
 	m_context(orig.m_context),
 	m_program_build_log(orig.m_program_build_log),
 	m_initialised_devices(orig.m_initialised_devices),
@@ -78,6 +126,8 @@ OclPlatformState::OclPlatformState(OclPlatformState&& orig) noexcept
 	orig.m_initialised_platform_and_program = false;
 	orig.m_platform = NULL;
 	orig.m_platform_name.clear();
+	orig.m_programs.clear();
+	orig.m_workgroup_sizes.clear();
 	orig.m_context = NULL;
 	orig.m_program_build_log = "";
 	orig.m_initialised_devices = false;
@@ -90,7 +140,7 @@ int OclPlatformState::initialise()
 	assert(m_good == true);
 	assert(m_program_build_log.size() == 0);
 	assert(m_context == NULL);
-	assert(m_program == NULL);
+	assert(m_programs.size() == 0);
 
 	/* Step 1. Find the devices. */
 	find_devices();
@@ -100,6 +150,8 @@ int OclPlatformState::initialise()
 	create_device_queues();
 	/* Step 4. Compile the program. */
 	build_program();
+	/* Step 5. Choose each device's workgroup size. */
+	if (m_good) { tune_devices(); }
 	return m_good;
 }
 
@@ -162,42 +214,26 @@ bool OclPlatformState::create_context()
 
 void OclPlatformState::build_program()
 {
-	cl_int status;
-	std::string compile_options;
-	char* tmp1;
-	const char* tmp2;
-	std::string program_source =
-#		include "nbody.cl"
-		;	/* Including in source makes it easier to distribute a shared lib. */
 	std::vector<cl_device_id> device_ids;
+	size_t max_workgroup_size = 0, local_mem_size = 0, tmp_size;
+	cl_ulong local_mem;
 	for (auto& device : m_devices) {
 		assert(device.device_id() != NULL);
-		if (device.m_good) { device_ids.push_back(device.device_id()); }
+		if (!device.m_good) { continue; }
+		device_ids.push_back(device.device_id());
+		/* Every device of the platform shares the programs. */
+		clGetDeviceInfo(device.device_id(), CL_DEVICE_MAX_WORK_GROUP_SIZE,
+			sizeof(size_t), &tmp_size, NULL);
+		clGetDeviceInfo(device.device_id(), CL_DEVICE_LOCAL_MEM_SIZE,
+			sizeof(cl_ulong), &local_mem, NULL);
+		max_workgroup_size = device_ids.size() == 1 ? tmp_size
+			: std::min(max_workgroup_size, tmp_size);
+		local_mem_size = device_ids.size() == 1 ? (size_t)local_mem
+			: std::min(local_mem_size, (size_t)local_mem);
 	}
 
-	/* -cl-fast-relaxed-math is too dangerous - it ruins our NaNs on Nvidia/ */
-	compile_options += " -D CVTX_CL_WORKGROUP_SIZE=" +
-		std::to_string(CVTX_WORKGROUP_SIZE);
-	compile_options += " -D CVTX_CL_LOG2_WORKGROUP_SIZE=" +
-		std::to_string((int)log2(CVTX_WORKGROUP_SIZE));
-	tmp2 = program_source.c_str();
-	m_program = clCreateProgramWithSource(
-		m_context, 1, (const char**)&tmp2, NULL, &status);
-	status = clBuildProgram(m_program, (cl_uint)device_ids.size(),
-		device_ids.data(), compile_options.c_str(), NULL, NULL);
-	if (status != CL_SUCCESS) {
-		m_good = 0;
-	}
-	/* It can be useful to have the buildlog even for good builds. */
-	size_t length;
-	status = clGetProgramBuildInfo(
-		m_program, device_ids[0], CL_PROGRAM_BUILD_LOG, 0,
-		NULL, &length);
-	tmp1 = (char*)malloc(sizeof(char) * (length + 1));
-	status = clGetProgramBuildInfo(
-		m_program, device_ids[0], CL_PROGRAM_BUILD_LOG, length,
-		tmp1, &length);
-	m_program_build_log = tmp1;
+	m_programs[CVTX_WORKGROUP_SIZE] = build_variant(CVTX_WORKGROUP_SIZE, 
+		program_source, device_ids, &m_program_build_log);
 #ifdef _DEBUG
 	if (!m_good) {
 		std::cout << "ERROR:\tFailed to build CVortex OpenCL kernel.\n"
@@ -208,10 +244,268 @@ void OclPlatformState::build_program()
 	/* If the platform isn't `good` its almost certainly a failing of the library
 	that ought to be fixed. */
 	assert(m_good);
-	free(tmp1);
+	if (!m_good) { return; }
+
+	/* Other variants are optional - the devices might not run them well. 
+	Each build costs as much as the default, so they're left until a 
+	device is going to use or time them. */
+	for (int workgroup_size : candidate_workgroup_sizes) {
+		if ((size_t)workgroup_size <= max_workgroup_size
+			&& workgroup_size * local_bytes_per_work_item <= local_mem_size) {
+			m_workgroup_sizes.push_back(workgroup_size);
+		}
+	}
 	return;
 }
 
+cl_program OclPlatformState::variant(int workgroup_size)
+{
+	std::vector<cl_device_id> device_ids;
+	cl_program program;
+	auto found = m_programs.find(workgroup_size);
+	if (found != m_programs.end()) { return found->second; }
+	if (std::find(m_workgroup_sizes.begin(), m_workgroup_sizes.end(),
+		workgroup_size) == m_workgroup_sizes.end()) {
+		return NULL;
+	}
+	for (auto& device : m_devices) {
+		if (device.m_good) { device_ids.push_back(device.device_id()); }
+	}
+	program = build_variant(workgroup_size, program_source, device_ids, NULL);
+	if (program != NULL) {
+		m_programs[workgroup_size] = program;
+	}
+	return program;
+}
+
+cl_program OclPlatformState::build_variant(
+	int workgroup_size,
+	const std::string &program_source,
+	const std::vector<cl_device_id> &device_ids,
+	std::string *build_log)
+{
+	cl_int status;
+	std::string compile_options;
+	cl_program program;
+	char* tmp1;
+	const char* tmp2;
+	bool good = true;
+
+	/* -cl-fast-relaxed-math is too dangerous - it ruins our NaNs on Nvidia/ */
+	compile_options += " -D CVTX_CL_WORKGROUP_SIZE=" +
+		std::to_string(workgroup_size);
+	compile_options += " -D CVTX_CL_LOG2_WORKGROUP_SIZE=" +
+		std::to_string((int)log2(workgroup_size));
+	/* Building from source can take seconds, so try the binaries of a 
+	previous build first. */
+	OclProgramCache cache(opencl_program_cache_dir(), m_platform_name,
+		program_source, compile_options);
+	program = cache.load(m_context, device_ids);
+	if (program == NULL) {
+		tmp2 = program_source.c_str();
+		program = clCreateProgramWithSource(
+			m_context, 1, (const char**)&tmp2, NULL, &status);
+		status = clBuildProgram(program, (cl_uint)device_ids.size(),
+			device_ids.data(), compile_options.c_str(), NULL, NULL);
+		if (status != CL_SUCCESS) {
+			good = false;
+		}
+		else {
+			cache.store(program);
+		}
+	}
+	/* It can be useful to have the buildlog even for good builds. */
+	if (build_log != NULL) {
+		size_t length;
+		status = clGetProgramBuildInfo(
+			program, device_ids[0], CL_PROGRAM_BUILD_LOG, 0,
+			NULL, &length);
+		tmp1 = (char*)malloc(sizeof(char) * (length + 1));
+		status = clGetProgramBuildInfo(
+			program, device_ids[0], CL_PROGRAM_BUILD_LOG, length,
+			tmp1, &length);
+		*build_log = tmp1;
+		free(tmp1);
+	}
+	if (!good) {
+		/* The default variant is kept for its build log. */
+		if (workgroup_size == CVTX_WORKGROUP_SIZE) {
+			m_good = 0;
+		}
+		else {
+			clReleaseProgram(program);
+			program = NULL;
+		}
+	}
+	return program;
+}
+
+/* Seconds for the best of a few runs of the tuning kernel of program over
+num_particles particles and num_mes measurement points, or -1 if the 
+variant can't be run on the device. */
+static double time_variant(
+	OclDeviceState &device,
+	cl_program program,
+	int workgroup_size,
+	cl_uint num_particles,
+	int num_mes)
+{
+	size_t global_work_size[2], local_work_size[2], kernel_workgroup_size;
+	std::vector<cl_float3> data;
+	cl_mem buffers[4] = { NULL, NULL, NULL, NULL };
+	cl_float recip_reg_rad = 1.f;
+	cl_kernel kernel;
+	cl_int status = CL_SUCCESS;
+	double best = -1., seconds;
+	int i, run;
+
+	/* Only the tuning kernel is created outside of the device's cache. */
+	for (const char *name : limiting_kernels) {
+		kernel = clCreateKernel(program, name, &status);
+		if (status != CL_SUCCESS) { return -1.; }
+		status = clGetKernelWorkGroupInfo(kernel, device.device_id(),
+			CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), 
+			&kernel_workgroup_size, NULL);
+		clReleaseKernel(kernel);
+		if (status != CL_SUCCESS 
+			|| kernel_workgroup_size < (size_t)workgroup_size) { 
+			return -1.;
+		}
+	}
+	kernel = clCreateKernel(program, tuning_kernel, &status);
+	if (status != CL_SUCCESS) { return -1.; }
+
+	/* Particles and measurement points spread over a unit cube. */
+	data.resize(std::max((int)num_particles, num_mes));
+	for (i = 0; i < (int)data.size(); ++i) {
+		data[i].x = (float)(i % 17) / 17.f;
+		data[i].y = (float)(i % 29) / 29.f;
+		data[i].z = (float)(i % 43) / 43.f;
+		data[i].w = 0.f;
+	}
+	for (i = 0; i < 4 && status == CL_SUCCESS; ++i) {
+		buffers[i] = device.acquire_buffer(sizeof(cl_float3) * data.size(),
+			&status);
+		if (i < 3 && status == CL_SUCCESS) {
+			status = clEnqueueWriteBuffer(device.queue(), buffers[i], CL_TRUE,
+				0, sizeof(cl_float3) * data.size(), data.data(), 0, NULL, NULL);
+		}
+	}
+	if (status == CL_SUCCESS) {
+		clSetKernelArg(kernel, 0, sizeof(cl_mem), buffers + 0);
+		clSetKernelArg(kernel, 1, sizeof(cl_mem), buffers + 1);
+		clSetKernelArg(kernel, 2, sizeof(cl_float), &recip_reg_rad);
+		clSetKernelArg(kernel, 3, sizeof(cl_mem), buffers + 2);
+		clSetKernelArg(kernel, 4, sizeof(cl_mem), buffers + 3);
+		clSetKernelArg(kernel, 5, sizeof(cl_uint), &num_particles);
+		local_work_size[0] = workgroup_size;
+		local_work_size[1] = 1;
+		global_work_size[0] = workgroup_size;
+		global_work_size[1] = num_mes;
+		/* The first run warms up the device and isn't counted. */
+		for (run = 0; run < 4 && status == CL_SUCCESS; ++run) {
+			auto start = std::chrono::steady_clock::now();
+			status = clEnqueueNDRangeKernel(device.queue(), kernel, 2, NULL,
+				global_work_size, local_work_size, 0, NULL, NULL);
+			if (status == CL_SUCCESS) { status = clFinish(device.queue()); }
+			seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count();
+			if (run > 0 && (best < 0. || seconds < best)) { best = seconds; }
+		}
+	}
+	for (i = 0; i < 4; ++i) {
+		if (buffers[i] != NULL) { device.release_buffer(buffers[i]); }
+	}
+	clReleaseKernel(kernel);
+	return status == CL_SUCCESS ? best : -1.;
+}
+
+void OclPlatformState::tune_devices()
+{
+	typedef std::chrono::steady_clock clock;
+	const char *env = getenv("CVTX_ACCELERATOR_WORKGROUP_SIZE");
+	int forced = env != NULL ? atoi(env) : 0;
+	const cl_uint num_particles = 4096;
+	int num_mes, best_size;
+	double seconds, best_seconds;
+	bool timed_all;
+	cl_program program;
+	std::vector<int> tuning_order(m_workgroup_sizes);
+	std::string variants = "workgroup sizes";
+	for (int workgroup_size : m_workgroup_sizes) {
+		variants += " " + std::to_string(workgroup_size);
+	}
+	/* Timing takes a while, so the choice is kept for later processes. It 
+	is redone if the device, driver, program or allowed variants change. */
+	OclProgramCache cache(opencl_program_cache_dir(), m_platform_name,
+		program_source, variants);
+	/* Each variant costs a build, so those nearest the default go first in
+	case the budget runs out. */
+	std::stable_sort(tuning_order.begin(), tuning_order.end(), 
+		[](int a, int b) {
+		return fabs(log2((double) a / CVTX_WORKGROUP_SIZE)) 
+			< fabs(log2((double) b / CVTX_WORKGROUP_SIZE));
+	});
+	const clock::time_point start = clock::now();
+
+	for (auto &device : m_devices) {
+		if (!device.m_good) { continue; }
+		device.use_program(m_programs[CVTX_WORKGROUP_SIZE], CVTX_WORKGROUP_SIZE);
+		program = forced > 0 ? variant(forced) : NULL;
+		if (program != NULL) {
+			device.use_program(program, forced);
+			continue;
+		}
+		best_size = tuned_workgroup_size(device.device_id(), variants);
+		if (best_size == 0) {
+			best_size = cache.load_workgroup_size(device.device_id());
+		}
+		program = best_size > 0 ? variant(best_size) : NULL;
+		if (program != NULL) {
+			device.use_program(program, best_size);
+			continue;
+		}
+		if (m_workgroup_sizes.size() < 2) { continue; }
+		/* Grow the problem until a launch is long enough to time. */
+		for (num_mes = 64; ; num_mes *= 2) {
+			best_seconds = time_variant(device, m_programs[CVTX_WORKGROUP_SIZE],
+				CVTX_WORKGROUP_SIZE, num_particles, num_mes);
+			if (best_seconds < 0. || best_seconds > 1e-3 || num_mes >= 16384) {
+				break;
+			}
+		}
+		if (best_seconds < 0.) { continue; }
+		best_size = CVTX_WORKGROUP_SIZE;
+		timed_all = true;
+		for (int workgroup_size : tuning_order) {
+			if (workgroup_size == CVTX_WORKGROUP_SIZE) { continue; }
+			/* Variants built for an earlier device cost nothing more. */
+			if (m_programs.count(workgroup_size) == 0 
+				&& std::chrono::duration<double>(clock::now() - start).count()
+					> tuning_budget_seconds) {
+				timed_all = false;
+				break;
+			}
+			program = variant(workgroup_size);
+			if (program == NULL) { continue; }
+			seconds = time_variant(device, program, workgroup_size,
+				num_particles, num_mes);
+			/* Only leave the default for a clear win, not timing noise. */
+			if (seconds > 0. && seconds < 0.95 * best_seconds) {
+				best_seconds = seconds;
+				best_size = workgroup_size;
+			}
+		}
+		device.use_program(m_programs[best_size], best_size);
+		remember_workgroup_size(device.device_id(), variants, best_size);
+		/* A cut short choice is redone by a later process, which can load 
+		the variants built so far from the cache. */
+		if (timed_all) {
+			cache.store_workgroup_size(device.device_id(), best_size);
+		}
+	}
+}
+
 int OclPlatformState::number_of_devices()
 {
 	return (int) m_devices.size();
@@ -224,7 +518,8 @@ OclDeviceState& OclPlatformState::device(int i)
 
 const cl_program OclPlatformState::program()
 {
-	return m_program;
+	auto found = m_programs.find(CVTX_WORKGROUP_SIZE);
+	return found != m_programs.end() ? found->second : NULL;
 }
 
 const cl_context OclPlatformState::context()
@@ -27,6 +27,7 @@ SOFTWARE.
 #ifndef CVTX_OCLPLATFORMSTATE_H
 #define CVTX_OCLPLATFORMSTATE_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include <CL/cl.h>
@@ -40,7 +41,11 @@ protected:
 	bool m_initialised_platform_and_program;
 	cl_platform_id m_platform;
 	std::string m_platform_name;
-	cl_program m_program;
+	/* Program variants by workgroup size. The CVTX_WORKGROUP_SIZE 
+	variant is always built, others only when chosen or tuned. */
+	std::map<int, cl_program> m_programs;
+	/* Workgroup sizes every device of the platform allows. */
+	std::vector<int> m_workgroup_sizes;
 	cl_context m_context;
 	std::string m_program_build_log;
 	bool m_initialised_devices;
@@ -58,6 +63,7 @@ public:
 	int initialise();
 	int number_of_devices();
 	OclDeviceState& device(int i);
+	/* The CVTX_WORKGROUP_SIZE variant of the program. */
 	const cl_program program();
 	const cl_context context();
 protected:
@@ -65,6 +71,15 @@ protected:
 	void create_device_queues();
 	bool create_context();
 	void build_program();
+	cl_program build_variant(
+		int workgroup_size, 
+		const std::string &program_source,
+		const std::vector<cl_device_id> &device_ids,
+		std::string *build_log);
+	/* The variant for workgroup_size, built if it isn't already. NULL if
+	the devices don't allow the size or the build fails. */
+	cl_program variant(int workgroup_size);
+	void tune_devices();
 };
 
 #endif
@@ -0,0 +1,261 @@
+/*============================================================================
+OclProgramCache.cpp
+
+Caches compiled OpenCL program binaries on disk.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+#include "OclProgramCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+static const char *cache_magic = "cvtx-clbin 1";
+static const char *workgroup_magic = "cvtx-clwg 1";
+
+/* FNV-1a. */
+static uint64_t hash_string(const std::string &str, uint64_t hash)
+{
+	for (unsigned char c : str) {
+		hash ^= c;
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+static uint64_t hash_string(const std::string &str)
+{
+	return hash_string(str, UINT64_C(14695981039346656037));
+}
+
+static std::string hex_string(uint64_t value)
+{
+	char tmp[17];
+	snprintf(tmp, sizeof(tmp), "%016llx", (unsigned long long)value);
+	return tmp;
+}
+
+/* A string property of the device, or "" if it can't be queried. */
+static std::string device_string(cl_device_id device, cl_device_info param)
+{
+	size_t length;
+	if (clGetDeviceInfo(device, param, 0, NULL, &length) != CL_SUCCESS) {
+		return "";
+	}
+	std::vector<char> tmp(length + 1, 0);
+	if (clGetDeviceInfo(device, param, length, tmp.data(), NULL) != CL_SUCCESS) {
+		return "";
+	}
+	return tmp.data();
+}
+
+OclProgramCache::OclProgramCache(const std::string &directory,
+	const std::string &platform_name,
+	const std::string &source,
+	const std::string &options)
+	: m_directory(directory), m_platform_name(platform_name),
+	m_options(options), m_source_hash(hash_string(source))
+{
+}
+
+bool OclProgramCache::enabled() const
+{
+	return m_directory.size() > 0;
+}
+
+cl_program OclProgramCache::load(
+	cl_context context, const std::vector<cl_device_id> &devices)
+{
+	cl_int status;
+	cl_program program;
+	std::vector<std::string> binaries;
+	std::vector<size_t> lengths;
+	std::vector<const unsigned char*> binary_ptrs;
+	std::vector<cl_int> binary_status(devices.size());
+	if (!enabled() || devices.size() == 0) { return NULL; }
+
+	for (cl_device_id device : devices) {
+		std::ifstream file(path(device, ".clbin"), std::ios::binary);
+		std::string magic, stored_key;
+		size_t length = 0;
+		std::getline(file, magic);
+		std::getline(file, stored_key);
+		file >> length;
+		file.get();
+		if (!file || magic != cache_magic 
+			|| stored_key != hex_string(key(device)) || length == 0) {
+			return NULL;
+		}
+		std::string binary(length, '\0');
+		file.read(&binary[0], length);
+		if ((size_t)file.gcount() != length) { return NULL; }
+		binaries.push_back(std::move(binary));
+	}
+	for (std::string &binary : binaries) {
+		lengths.push_back(binary.size());
+		binary_ptrs.push_back((const unsigned char*)binary.data());
+	}
+	program = clCreateProgramWithBinary(context, (cl_uint)devices.size(),
+		devices.data(), lengths.data(), binary_ptrs.data(), 
+		binary_status.data(), &status);
+	if (status != CL_SUCCESS) {
+		if (program != NULL) { clReleaseProgram(program); }
+		return NULL;
+	}
+	status = clBuildProgram(program, (cl_uint)devices.size(), devices.data(),
+		m_options.c_str(), NULL, NULL);
+	if (status != CL_SUCCESS) {
+		clReleaseProgram(program);
+		return NULL;
+	}
+	return program;
+}
+
+int OclProgramCache::store(cl_program program)
+{
+	cl_int status;
+	cl_uint i, num_devices;
+	std::vector<cl_device_id> devices;
+	std::vector<size_t> lengths;
+	std::vector<std::vector<unsigned char>> binaries;
+	std::vector<unsigned char*> binary_ptrs;
+	if (!enabled()) { return -1; }
+
+	status = clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES,
+		sizeof(cl_uint), &num_devices, NULL);
+	if (status != CL_SUCCESS || num_devices == 0) { return -1; }
+	devices.resize(num_devices);
+	lengths.resize(num_devices);
+	status = clGetProgramInfo(program, CL_PROGRAM_DEVICES,
+		sizeof(cl_device_id) * num_devices, devices.data(), NULL);
+	if (status != CL_SUCCESS) { return -1; }
+	status = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES,
+		sizeof(size_t) * num_devices, lengths.data(), NULL);
+	if (status != CL_SUCCESS) { return -1; }
+	for (i = 0; i < num_devices; ++i) {
+		binaries.emplace_back(lengths[i]);
+		binary_ptrs.push_back(binaries[i].data());
+	}
+	status = clGetProgramInfo(program, CL_PROGRAM_BINARIES,
+		sizeof(unsigned char*) * num_devices, binary_ptrs.data(), NULL);
+	if (status != CL_SUCCESS) { return -1; }
+
+	int retv = 0;
+	for (i = 0; i < num_devices; ++i) {
+		if (lengths[i] == 0) { retv = -1; continue; }
+		std::ostringstream header;
+		header << cache_magic << "\n" << hex_string(key(devices[i])) << "\n"
+			<< lengths[i] << "\n";
+		if (replace_file(path(devices[i], ".clbin"), header.str(),
+			(const char*)binaries[i].data(), lengths[i]) != 0) {
+			retv = -1;
+		}
+	}
+	return retv;
+}
+
+int OclProgramCache::load_workgroup_size(cl_device_id device)
+{
+	std::string magic, stored_key;
+	int workgroup_size = 0;
+	if (!enabled()) { return 0; }
+	std::ifstream file(path(device, ".clwg"));
+	std::getline(file, magic);
+	std::getline(file, stored_key);
+	file >> workgroup_size;
+	if (!file || magic != workgroup_magic 
+		|| stored_key != hex_string(key(device))) {
+		return 0;
+	}
+	return workgroup_size;
+}
+
+int OclProgramCache::store_workgroup_size(
+	cl_device_id device, int workgroup_size)
+{
+	if (!enabled()) { return -1; }
+	std::string contents = std::string(workgroup_magic) + "\n" 
+		+ hex_string(key(device)) + "\n" + std::to_string(workgroup_size) + "\n";
+	return replace_file(path(device, ".clwg"), contents, NULL, 0);
+}
+
+int OclProgramCache::replace_file(const std::string &final_path,
+	const std::string &header, const char *data, size_t length)
+{
+	/* Write to a temporary file first so that processes starting at the 
+	same time never read a partial file. */
+	std::random_device random;
+	std::string suffix = hex_string(
+		(uint64_t)std::chrono::steady_clock::now().time_since_epoch().count()
+		^ ((uint64_t)random() << 32));
+	std::string tmp_path = final_path + "." + suffix;
+	{
+		std::ofstream file(tmp_path, std::ios::binary);
+		file << header;
+		if (length > 0) { file.write(data, length); }
+		if (!file) {
+			file.close();
+			std::remove(tmp_path.c_str());
+			return -1;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+		/* Windows won't rename over an existing file. */
+		std::remove(final_path.c_str());
+		if (std::rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+			std::remove(tmp_path.c_str());
+			return -1;
+		}
+	}
+	return 0;
+}
+
+std::string OclProgramCache::path(cl_device_id device, const char *extension)
+{
+	/* Each set of build options, such as each workgroup size, needs its own 
+	file or the variants would keep replacing each other. */
+	uint64_t id = hash_string(m_platform_name);
+	id = hash_string(device_string(device, CL_DEVICE_VENDOR), id);
+	id = hash_string(device_string(device, CL_DEVICE_NAME), id);
+	id = hash_string(m_options, id);
+	std::string directory = m_directory;
+	char last = directory.back();
+	if (last != '/' && last != '\\') { directory += "/"; }
+	return directory + "cvtx_" + hex_string(id) + extension;
+}
+
+uint64_t OclProgramCache::key(cl_device_id device)
+{
+	uint64_t hash = hash_string(m_platform_name);
+	hash = hash_string(device_string(device, CL_DEVICE_VENDOR), hash);
+	hash = hash_string(device_string(device, CL_DEVICE_NAME), hash);
+	hash = hash_string(device_string(device, CL_DEVICE_VERSION), hash);
+	hash = hash_string(device_string(device, CL_DRIVER_VERSION), hash);
+	hash = hash_string(m_options, hash);
+	hash = hash_string(hex_string(m_source_hash), hash);
+	return hash;
+}
+
+#endif /*CVTX_USING_OPENCL*/
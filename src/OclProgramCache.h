@@ -0,0 +1,75 @@
+/*============================================================================
+OclProgramCache.h
+
+Caches compiled OpenCL program binaries on disk.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+#ifndef CVTX_OCLPROGRAMCACHE_H
+#define CVTX_OCLPROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <CL/cl.h>
+
+/* Program binaries are kept as one file per device and build options in a 
+directory. A file is named for the device and options, and holds a hash of 
+the device, driver, program source and build options - a file whose hash 
+doesn't match is stale and is replaced on the next store. The workgroup 
+size tuned for a device is kept alongside in the same way. */
+class OclProgramCache {
+protected:
+	std::string m_directory;
+	std::string m_platform_name;
+	std::string m_options;
+	uint64_t m_source_hash;
+
+public:
+	/* An empty directory disables the cache. */
+	OclProgramCache(const std::string &directory,
+		const std::string &platform_name,
+		const std::string &source,
+		const std::string &options);
+
+	bool enabled() const;
+	/* A program built from the cached binaries of all the devices, or 
+	NULL if any are missing, stale or rejected by the driver. */
+	cl_program load(cl_context context, const std::vector<cl_device_id> &devices);
+	/* Write the binaries of a built program. Returns 0 on success. */
+	int store(cl_program program);
+	/* The workgroup size stored for the device, or 0 if there isn't one
+	or it is stale. */
+	int load_workgroup_size(cl_device_id device);
+	/* Record the workgroup size tuned for the device. Returns 0 on success. */
+	int store_workgroup_size(cl_device_id device, int workgroup_size);
+
+protected:
+	std::string path(cl_device_id device, const char *extension);
+	uint64_t key(cl_device_id device);
+	/* Replace the file at final_path with header followed by data. */
+	int replace_file(const std::string &final_path, const std::string &header,
+		const char *data, size_t length);
+};
+
+#endif
+#endif
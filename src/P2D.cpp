@@ -31,11 +31,16 @@ SOFTWARE.
 #include <cstring>
 
 #include "GridParticleQuadtree.h"
+#include "ParticleView.h"
 #include "array_methods.h"
+#include "fmm_P2D.h"
 #include "redistribution_helper_funcs.h"
 #include "UIntKey64.h"
+#include "VortFuncPolicy.h"
+#include "tiled_M2M.h"
 
 #ifdef CVTX_USING_OPENCL
+#	include "DispatchProfile.h"
 #	include "ocl_P2D.h"
 #endif
 #ifdef CVTX_USING_OPENMP
@@ -45,11 +50,12 @@ SOFTWARE.
 #define NG_FOR_REDUCING_PARICLES 64
 
 /* The induced velocity for a particle excluding the constant
-coefficient 1 / 2pi */
+coefficient 1 / 2pi. VortFuncT is a policy from VortFuncPolicy.h. */
+template<typename VortFuncT>
 static inline bsv_V2f P2D_vel_inner(
 	const cvtx_P2D * self,
 	const bsv_V2f mes_point,
-	const cvtx_VortFunc * kernel,
+	const VortFuncT &kernel,
 	float recip_reg_rad)
 {
 	bsv_V2f rad, ret;
@@ -61,7 +67,7 @@ static inline bsv_V2f P2D_vel_inner(
 		rad = bsv_V2f_minus(mes_point, self->coord);
 		radd = bsv_V2f_abs(rad);
 		rho = radd * recip_reg_rad;
-		g = kernel->g_2D(rho);
+		g = kernel.g_2D(rho);
 		ret.x[0] = rad.x[1] * self->vorticity * g / (radd * radd);
 		ret.x[1] = -rad.x[0] * self->vorticity * g / (radd * radd);
 	}
@@ -75,7 +81,7 @@ CVTX_EXPORT bsv_V2f cvtx_P2D_S2S_vel(
 	float regularisation_radius)
 {
 	bsv_V2f ret;
-	ret = P2D_vel_inner(self, mes_point, kernel,
+	ret = P2D_vel_inner(self, mes_point, VortFuncPointers(kernel),
 		1.f / fabsf(regularisation_radius));
 	return bsv_V2f_mult(ret, 1.f / (2.f * acosf(-1.f)));
 }
@@ -96,11 +102,12 @@ CVTX_EXPORT void cvtx_P2D_S2M_vel(
 	return;
 }
 
-CVTX_EXPORT bsv_V2f cvtx_P2D_M2S_vel(
-	const cvtx_P2D **array_start,
+template<typename VortFuncT>
+static bsv_V2f P2D_M2S_vel_impl(
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f mes_point,
-	const cvtx_VortFunc *kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius)
 {
 	double rx = 0, ry = 0;
@@ -109,7 +116,7 @@ CVTX_EXPORT bsv_V2f cvtx_P2D_M2S_vel(
 	assert(num_particles >= 0);
 #pragma omp parallel for reduction(+:rx, ry)
 	for (i = 0; i < num_particles; ++i) {
-		bsv_V2f vel = P2D_vel_inner(array_start[i],
+		bsv_V2f vel = P2D_vel_inner(&array_start[i],
 			mes_point, kernel, recip_reg_rad);
 		rx += vel.x[0];
 		ry += vel.x[1];
@@ -118,23 +125,72 @@ CVTX_EXPORT bsv_V2f cvtx_P2D_M2S_vel(
 	return bsv_V2f_mult(ret, 1.f / (2.f * acosf(-1.f)));
 }
 
+static bsv_V2f P2D_M2S_vel(
+	const P2DView &array_start,
+	const int num_particles,
+	const bsv_V2f mes_point,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	bsv_V2f ret;
+	with_vortfunc_2D(kernel, [&](const auto &vortfunc) {
+		ret = P2D_M2S_vel_impl(array_start, num_particles, mes_point,
+			vortfunc, regularisation_radius);
+	});
+	return ret;
+}
 
-static void cpu_brute_force_P2D_M2M_vel(
+CVTX_EXPORT bsv_V2f cvtx_P2D_M2S_vel(
 	const cvtx_P2D **array_start,
 	const int num_particles,
+	const bsv_V2f mes_point,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	return P2D_M2S_vel(array_start, num_particles, mes_point, kernel,
+		regularisation_radius);
+}
+
+
+template<typename VortFuncT>
+static void cpu_brute_force_P2D_M2M_vel_impl(
+	const P2DView &array_start,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius)
+{
+	float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		for (int j = jb; j < je; ++j) {
+			bsv_V2f vel = P2D_vel_inner(&array_start[j],
+				mes_start[i], kernel, recip_reg_rad);
+			acc[0] += vel.x[0];
+			acc[1] += vel.x[1];
+		}
+	};
+	tiled_M2M<2>(num_mes, num_particles, tile, [&](int i, const double *acc) {
+		bsv_V2f ret = { (float)acc[0], (float)acc[1] };
+		result_array[i] = bsv_V2f_mult(ret, 1.f / (2.f * acosf(-1.f)));
+	});
+	return;
+}
+
+static void cpu_brute_force_P2D_M2M_vel(
+	const P2DView &array_start,
+	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
 	bsv_V2f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
 {
-	long i;
-#pragma omp parallel for schedule(static)
-	for (i = 0; i < num_mes; ++i) {
-		result_array[i] = cvtx_P2D_M2S_vel(
-			array_start, num_particles, mes_start[i],
-			kernel, regularisation_radius);
-	}
+	with_vortfunc_2D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P2D_M2M_vel_impl(array_start, num_particles,
+			mes_start, num_mes, result_array, vortfunc, regularisation_radius);
+	});
 	return;
 }
 
@@ -147,8 +203,33 @@ CVTX_EXPORT void cvtx_P2D_M2M_vel(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
 {
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	cvtx_P2D_M2M_vel_algorithm(array_start, num_particles, mes_start,
+		num_mes, result_array, kernel, regularisation_radius, &algorithm);
+	return;
+}
+
+static void P2D_M2M_vel_impl(
+	const P2DView &array_start,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm)
+{
+	if (algorithm->type == CVTX_ALGORITHM_FMM
+		&& fmm_P2D_M2M_vel(
+			array_start, num_particles, mes_start, num_mes, result_array,
+			kernel, regularisation_radius, 
+			algorithm->order, algorithm->theta) == 0) {
+		return;
+	}
 #ifdef CVTX_USING_OPENCL
 	if (!strcmp(kernel->cl_kernel_name_ext, "")
+		|| !dispatch_to_accelerator(DISPATCH_P2D_M2M_VEL, 
+			vortfunc_type_2D(kernel), num_particles, num_mes)
 		|| opencl_brute_force_P2D_M2M_vel(
 			array_start, num_particles, mes_start,
 			num_mes, result_array, kernel, regularisation_radius) != 0)
@@ -161,20 +242,50 @@ CVTX_EXPORT void cvtx_P2D_M2M_vel(
 	return;
 }
 
+CVTX_EXPORT void cvtx_P2D_M2M_vel_algorithm(
+	const cvtx_P2D **array_start,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm)
+{
+	P2D_M2M_vel_impl(array_start, num_particles, mes_start, num_mes,
+		result_array, kernel, regularisation_radius, algorithm);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P2D_M2M_vel_strided(
+	const cvtx_P2D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P2D_M2M_vel_impl(P2DView(particles, stride), num_particles, mes_start,
+		num_mes, result_array, kernel, regularisation_radius, &algorithm);
+	return;
+}
+
 
 /* Visous vorticity exchange methods ----------------------------------------*/
 
-CVTX_EXPORT float cvtx_P2D_S2S_visc_dvort(
+template<typename VortFuncT>
+static inline float P2D_visc_dvort_inner(
 	const cvtx_P2D * self,
 	const cvtx_P2D * induced_particle,
-	const cvtx_VortFunc * kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
 	bsv_V2f rad;
 	float radd, rho, ret, t1, t2, t22, t21, t211, t212;
-	assert(kernel->eta_2D != NULL && "Used vortex regularisation"
-		"that did have a defined eta function");
 	if (bsv_V2f_isequal(self->coord, induced_particle->coord)) {
 		ret = 0.f;
 	}
@@ -186,13 +297,26 @@ CVTX_EXPORT float cvtx_P2D_S2S_visc_dvort(
 		t211 = self->vorticity * induced_particle->area;
 		t212 = -induced_particle->vorticity * self->area;
 		t21 = t211 + t212;
-		t22 = kernel->eta_2D(rho);
+		t22 = kernel.eta_2D(rho);
 		t2 = t21* t22;
 		ret = t2 * t1;
 	}
 	return ret;
 }
 
+CVTX_EXPORT float cvtx_P2D_S2S_visc_dvort(
+	const cvtx_P2D * self,
+	const cvtx_P2D * induced_particle,
+	const cvtx_VortFunc * kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(kernel->eta_2D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	return P2D_visc_dvort_inner(self, induced_particle,
+		VortFuncPointers(kernel), regularisation_radius, kinematic_visc);
+}
+
 CVTX_EXPORT void cvtx_P2D_S2M_visc_dvort(
 	const cvtx_P2D* self,
 	const cvtx_P2D** induced_start,
@@ -211,11 +335,12 @@ CVTX_EXPORT void cvtx_P2D_S2M_visc_dvort(
 	return;
 }
 
-CVTX_EXPORT float cvtx_P2D_M2S_visc_dvort(
-	const cvtx_P2D **array_start,
+template<typename VortFuncT>
+static float P2D_M2S_visc_dvort_impl(
+	const P2DView &array_start,
 	const int num_particles,
 	const cvtx_P2D *induced_particle,
-	const cvtx_VortFunc *kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
@@ -224,35 +349,90 @@ CVTX_EXPORT float cvtx_P2D_M2S_visc_dvort(
 	assert(num_particles >= 0);
 #pragma omp parallel for reduction(+:dvort)
 	for (i = 0; i < num_particles; ++i) {
-		dvort += (double)cvtx_P2D_S2S_visc_dvort(array_start[i],
+		dvort += (double)P2D_visc_dvort_inner(&array_start[i],
 			induced_particle, kernel, regularisation_radius, kinematic_visc);
 	}
 	return (float)dvort;
 }
 
-void cpu_brute_force_P2D_M2M_visc_dvort(
+static float P2D_M2S_visc_dvort(
+	const P2DView &array_start,
+	const int num_particles,
+	const cvtx_P2D *induced_particle,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	float ret;
+	assert(kernel->eta_2D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	with_vortfunc_2D(kernel, [&](const auto &vortfunc) {
+		ret = P2D_M2S_visc_dvort_impl(array_start, num_particles,
+			induced_particle, vortfunc, regularisation_radius, kinematic_visc);
+	});
+	return ret;
+}
+
+CVTX_EXPORT float cvtx_P2D_M2S_visc_dvort(
 	const cvtx_P2D **array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const cvtx_P2D *induced_particle,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	return P2D_M2S_visc_dvort(array_start, num_particles,
+		induced_particle, kernel, regularisation_radius,
+		kinematic_visc);
+}
+
+template<typename VortFuncT>
+static void cpu_brute_force_P2D_M2M_visc_dvort_impl(
+	const P2DView &array_start,
+	const int num_particles,
+	const P2DView &induced_start,
+	const int num_induced,
+	float *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		for (int j = jb; j < je; ++j) {
+			acc[0] += (double)P2D_visc_dvort_inner(&array_start[j],
+				&induced_start[i], kernel, regularisation_radius, 
+				kinematic_visc);
+		}
+	};
+	tiled_M2M<1>(num_induced, num_particles, tile,
+		[&](int i, const double *acc) { result_array[i] = (float)acc[0]; });
+	return;
+}
+
+static void cpu_brute_force_P2D_M2M_visc_dvort(
+	const P2DView &array_start,
+	const int num_particles,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
-	long i;
-	for (i = 0; i < num_induced; ++i) {
-		result_array[i] = cvtx_P2D_M2S_visc_dvort(
-			array_start, num_particles, induced_start[i],
-			kernel, regularisation_radius, kinematic_visc);
-	}
+	assert(kernel->eta_2D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	with_vortfunc_2D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P2D_M2M_visc_dvort_impl(array_start, num_particles,
+			induced_start, num_induced, result_array, vortfunc,
+			regularisation_radius, kinematic_visc);
+	});
 	return;
 }
 
-CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort(
-	const cvtx_P2D **array_start,
+static void P2D_M2M_visc_dvort_impl(
+	const P2DView &array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
@@ -260,9 +440,9 @@ CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort(
 	float kinematic_visc)
 {
 #ifdef CVTX_USING_OPENCL
-	if (num_particles < 256
-		|| num_induced < 256
-		|| !strcmp(kernel->cl_kernel_name_ext, "")
+	if (!strcmp(kernel->cl_kernel_name_ext, "")
+		|| !dispatch_to_accelerator(DISPATCH_P2D_M2M_VISC_DVORT, 
+			vortfunc_type_2D(kernel), num_particles, num_induced)
 		|| opencl_brute_force_P2D_M2M_visc_dvort(
 			array_start, num_particles, induced_start,
 			num_induced, result_array, kernel, regularisation_radius, kinematic_visc) != 0)
@@ -275,6 +455,40 @@ CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort(
 	return;
 }
 
+CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort(
+	const cvtx_P2D **array_start,
+	const int num_particles,
+	const cvtx_P2D **induced_start,
+	const int num_induced,
+	float *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	P2D_M2M_visc_dvort_impl(array_start, num_particles, induced_start,
+		num_induced, result_array, kernel, regularisation_radius,
+		kinematic_visc);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P2D_M2M_visc_dvort_strided(
+	const cvtx_P2D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P2D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	float *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	P2D_M2M_visc_dvort_impl(P2DView(particles, stride), num_particles,
+		P2DView(induced, induced_stride), num_induced, result_array,
+		kernel, regularisation_radius, kinematic_visc);
+	return;
+}
+
 /* Particle redistribution -------------------------------------------------*/
 static int cvtx_remove_particles_under_str_threshold_2d(
 	cvtx_P2D* io_arr, float* strs, int n_inpt_partices, 
@@ -32,12 +32,24 @@ SOFTWARE.
 #include <cstring>
 #include <vector>
 
-#include "GridParticleOcttree.h"
+#include "GridParticleHashMap.h"
+#include "P3D_soa.h"
+#include "ParticleView.h"
+#include "Request.h"
 #include "array_methods.h"
+#include "bh_P3D.h"
+#include "celllist_P3D.h"
+#include "cpu_P3D.h"
+#include "fmm_P3D.h"
 #include "redistribution_helper_funcs.h"
+#include "self_P3D.h"
+#include "simd_P3D.h"
 #include "UIntKey96.h"
+#include "VortFuncPolicy.h"
 
 #ifdef CVTX_USING_OPENCL
+#	include "DispatchProfile.h"
+#	include "hybrid_P3D.h"
 #	include "ocl_P3D.h"
 #endif
 #ifdef CVTX_USING_OPENMP
@@ -47,11 +59,12 @@ SOFTWARE.
 #define CVTX_PI_F 3.14159265359f
 
 /* The induced velocity for a particle excluding the constant
-coefficient 1 / 4pi */
+coefficient 1 / 4pi. VortFuncT is a policy from VortFuncPolicy.h. */
+template<typename VortFuncT>
 static inline bsv_V3f P3D_vel_inner(
 	const cvtx_P3D * self,
 	const bsv_V3f mes_point,
-	const cvtx_VortFunc * kernel,
+	const VortFuncT &kernel,
 	float recip_reg_rad)
 {
 	bsv_V3f rad, num, ret;
@@ -63,7 +76,7 @@ static inline bsv_V3f P3D_vel_inner(
 		rad = bsv_V3f_minus(mes_point, self->coord);
 		radd = bsv_V3f_abs(rad);
 		rho = radd * recip_reg_rad; /* Assume positive. */
-		cor = -kernel->g_3D(rho);
+		cor = -kernel.g_3D(rho);
 		den = powf(radd, -3);
 		num = bsv_V3f_cross(rad, self->vorticity);
 		ret = bsv_V3f_mult(num, cor * den);
@@ -78,15 +91,16 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_vel(
 	float regularisation_radius)
 {
 	bsv_V3f ret;
-	ret = P3D_vel_inner(self, mes_point, kernel, 
+	ret = P3D_vel_inner(self, mes_point, VortFuncPointers(kernel), 
 		1.f/fabsf(regularisation_radius));
 	return bsv_V3f_mult(ret, 1.f / (4.f * CVTX_PI_F));
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_dvort(
+template<typename VortFuncT>
+static inline bsv_V3f P3D_dvort_inner(
 	const cvtx_P3D * self,
 	const cvtx_P3D * induced_particle,
-	const cvtx_VortFunc * kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius)
 {
 	bsv_V3f ret, rad, cross_om, t2, t21, t21n, t22;
@@ -97,7 +111,7 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_dvort(
 		rad = bsv_V3f_minus(induced_particle->coord, self->coord);
 		radd = bsv_V3f_abs(rad);
 		rho = fabsf(radd / regularisation_radius);
-		kernel->combined_3D(rho, &g, &f);
+		kernel.combined_3D(rho, &g, &f);
 		cross_om = bsv_V3f_cross(induced_particle->vorticity, self->vorticity);
 		t1 = 1.f / (4.f * CVTX_PI_F * powf(regularisation_radius, 3));
 		t21n = bsv_V3f_mult(cross_om, g);
@@ -113,17 +127,26 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_dvort(
 	return ret;
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_visc_dvort(
+CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_dvort(
 	const cvtx_P3D * self,
 	const cvtx_P3D * induced_particle,
 	const cvtx_VortFunc * kernel,
+	float regularisation_radius)
+{
+	return P3D_dvort_inner(self, induced_particle, VortFuncPointers(kernel),
+		regularisation_radius);
+}
+
+template<typename VortFuncT>
+static inline bsv_V3f P3D_visc_dvort_inner(
+	const cvtx_P3D * self,
+	const cvtx_P3D * induced_particle,
+	const VortFuncT &kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {	
 	bsv_V3f ret, rad, t211, t212, t21, t2;
 	float radd, rho, t1, t22;
-	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
-		"that did have a defined eta function");
 	if(bsv_V3f_isequal(self->coord, induced_particle->coord)){
 		ret = bsv_V3f_zero();
 	} else {
@@ -136,13 +159,26 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_visc_dvort(
 		t212 = bsv_V3f_mult(induced_particle->vorticity, 
 			-1 * self->volume);
 		t21 = bsv_V3f_plus(t211, t212);
-		t22 = kernel->eta_3D(rho);
+		t22 = kernel.eta_3D(rho);
 		t2 = bsv_V3f_mult(t21, t22);
 		ret = bsv_V3f_mult(t2, t1);
 	}
 	return ret;
 }
 
+CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_visc_dvort(
+	const cvtx_P3D * self,
+	const cvtx_P3D * induced_particle,
+	const cvtx_VortFunc * kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	return P3D_visc_dvort_inner(self, induced_particle,
+		VortFuncPointers(kernel), regularisation_radius, kinematic_visc);
+}
+
 CVTX_EXPORT bsv_V3f cvtx_P3D_S2S_vort(
 	const cvtx_P3D* self,
 	const bsv_V3f mes_point,
@@ -227,11 +263,12 @@ CVTX_EXPORT void cvtx_P3D_S2M_vort(
 	return;
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vel(
-	const cvtx_P3D **array_start,
+template<typename VortFuncT>
+static bsv_V3f P3D_M2S_vel_impl(
+	const P3DView &array_start,
 	const int num_particles,
 	const bsv_V3f mes_point,
-	const cvtx_VortFunc *kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius)
 {
 	double rx = 0, ry = 0, rz = 0;
@@ -240,7 +277,7 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vel(
 	assert(num_particles >= 0);
 #pragma omp parallel for reduction(+:rx, ry, rz)
 	for (i = 0; i < num_particles; ++i) {
-		bsv_V3f vel = P3D_vel_inner(array_start[i],
+		bsv_V3f vel = P3D_vel_inner(&array_start[i],
 			mes_point, kernel, recip_reg_rad);
 		rx += vel.x[0];
 		ry += vel.x[1];
@@ -250,19 +287,46 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vel(
 	return bsv_V3f_mult(ret, 1.f / (4.f * CVTX_PI_F));
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_dvort(
+static bsv_V3f P3D_M2S_vel(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f mes_point,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	bsv_V3f ret;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		ret = P3D_M2S_vel_impl(array_start, num_particles, mes_point,
+			vortfunc, regularisation_radius);
+	});
+	return ret;
+}
+
+CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vel(
 	const cvtx_P3D **array_start,
 	const int num_particles,
-	const cvtx_P3D *induced_particle,
+	const bsv_V3f mes_point,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
+{
+	return P3D_M2S_vel(array_start, num_particles, mes_point, kernel,
+		regularisation_radius);
+}
+
+template<typename VortFuncT>
+static bsv_V3f P3D_M2S_dvort_impl(
+	const P3DView &array_start,
+	const int num_particles,
+	const cvtx_P3D *induced_particle,
+	const VortFuncT &kernel,
+	float regularisation_radius)
 {
 	bsv_V3f dvort;
 	double rx = 0, ry = 0, rz = 0;
 	long i;
 	assert(num_particles >= 0);
 	for (i = 0; i < num_particles; ++i) {
-		dvort = cvtx_P3D_S2S_dvort(array_start[i],
+		dvort = P3D_dvort_inner(&array_start[i],
 			induced_particle, kernel, regularisation_radius);
 		rx += dvort.x[0];
 		ry += dvort.x[1];
@@ -272,11 +336,38 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_dvort(
 	return ret;
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_visc_dvort(
+static bsv_V3f P3D_M2S_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	const cvtx_P3D *induced_particle,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	bsv_V3f ret;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		ret = P3D_M2S_dvort_impl(array_start, num_particles,
+			induced_particle, vortfunc, regularisation_radius);
+	});
+	return ret;
+}
+
+CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_dvort(
 	const cvtx_P3D **array_start,
 	const int num_particles,
 	const cvtx_P3D *induced_particle,
 	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	return P3D_M2S_dvort(array_start, num_particles, induced_particle,
+		kernel, regularisation_radius);
+}
+
+template<typename VortFuncT>
+static bsv_V3f P3D_M2S_visc_dvort_impl(
+	const P3DView &array_start,
+	const int num_particles,
+	const cvtx_P3D *induced_particle,
+	const VortFuncT &kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
@@ -285,7 +376,7 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_visc_dvort(
 	long i;
 	assert(num_particles >= 0);
 	for (i = 0; i < num_particles; ++i) {
-		dvort = cvtx_P3D_S2S_visc_dvort(array_start[i],
+		dvort = P3D_visc_dvort_inner(&array_start[i],
 			induced_particle, kernel, regularisation_radius, kinematic_visc);
 		rx += dvort.x[0];
 		ry += dvort.x[1];
@@ -295,11 +386,44 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_visc_dvort(
 	return ret;
 }
 
-CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vort(
-	const cvtx_P3D** array_start,
+static bsv_V3f P3D_M2S_visc_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	const cvtx_P3D *induced_particle,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	bsv_V3f ret;
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		ret = P3D_M2S_visc_dvort_impl(array_start, num_particles,
+			induced_particle, vortfunc, regularisation_radius,
+			kinematic_visc);
+	});
+	return ret;
+}
+
+CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_visc_dvort(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D *induced_particle,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	return P3D_M2S_visc_dvort(array_start, num_particles,
+		induced_particle, kernel, regularisation_radius,
+		kinematic_visc);
+}
+
+template<typename VortFuncT>
+static bsv_V3f P3D_M2S_vort_impl(
+	const P3DView &array_start,
 	const int num_particles,
 	const bsv_V3f mes_point,
-	const cvtx_VortFunc* kernel,
+	const VortFuncT &kernel,
 	float regularisation_radius) {
 	float cutoff, rsigma, radd, coeff;
 	bsv_V3f rad, sum = bsv_V3f_zero();
@@ -308,12 +432,12 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vort(
 	rsigma = 1 / regularisation_radius;
 	assert(num_particles > 0);
 	for (i = 0; i < num_particles; ++i) {
-		rad = bsv_V3f_minus(array_start[i]->coord, mes_point);
+		rad = bsv_V3f_minus(array_start[i].coord, mes_point);
 		if (fabsf(rad.x[0]) < cutoff && fabsf(rad.x[1]) < cutoff
 			&& fabsf(rad.x[2]) < cutoff) {
 			radd = bsv_V3f_abs(rad);
-			coeff = kernel->zeta_3D(radd * rsigma);
-			sum = bsv_V3f_plus(bsv_V3f_mult(array_start[i] ->vorticity, coeff), sum);
+			coeff = kernel.zeta_3D(radd * rsigma);
+			sum = bsv_V3f_plus(bsv_V3f_mult(array_start[i].vorticity, coeff), sum);
 		}
 	}
 	sum = bsv_V3f_div(sum, 4.f * CVTX_PI_F 
@@ -321,7 +445,32 @@ CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vort(
 	return sum;
 } 
 
-static void cpu_brute_force_P3D_M2M_vel(
+static bsv_V3f P3D_M2S_vort(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f mes_point,
+	const cvtx_VortFunc* kernel,
+	float regularisation_radius) {
+	bsv_V3f ret;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		ret = P3D_M2S_vort_impl(array_start, num_particles, mes_point,
+			vortfunc, regularisation_radius);
+	});
+	return ret;
+}
+
+CVTX_EXPORT bsv_V3f cvtx_P3D_M2S_vort(
+	const cvtx_P3D** array_start,
+	const int num_particles,
+	const bsv_V3f mes_point,
+	const cvtx_VortFunc* kernel,
+	float regularisation_radius)
+{
+	return P3D_M2S_vort(array_start, num_particles, mes_point, kernel,
+		regularisation_radius);
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel(
 	const cvtx_P3D **array_start,
 	const int num_particles,
 	const bsv_V3f *mes_start,
@@ -330,60 +479,144 @@ static void cpu_brute_force_P3D_M2M_vel(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
 {
-	long i;
-#pragma omp parallel for schedule(static)
-	for(i = 0; i < num_mes; ++i){
-		result_array[i] = cvtx_P3D_M2S_vel(
-			array_start, num_particles, mes_start[i], 
-			kernel, regularisation_radius);
-	}
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	cvtx_P3D_M2M_vel_algorithm(array_start, num_particles, mes_start,
+		num_mes, result_array, kernel, regularisation_radius, &algorithm);
 	return;
 }
 
-CVTX_EXPORT void cvtx_P3D_M2M_vel(
-	const cvtx_P3D **array_start,
-	const int num_particles,
+static void P3D_M2M_vel_impl(
+	const P3DArray &particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
-	float regularisation_radius)
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm,
+	cvtx_Request *request)
 {
+	if (algorithm->type == CVTX_ALGORITHM_BARNES_HUT
+		&& barnes_hut_P3D_M2M_vel(
+			particles.view(), particles.size(), mes_start, num_mes,
+			result_array, kernel, regularisation_radius, algorithm->theta) == 0) {
+		return;
+	}
+	if (algorithm->type == CVTX_ALGORITHM_FMM
+		&& fmm_P3D_M2M_vel(
+			particles.view(), particles.size(), mes_start, num_mes,
+			result_array, kernel, regularisation_radius, 
+			algorithm->order, algorithm->theta) == 0) {
+		return;
+	}
 #ifdef CVTX_USING_OPENCL
-	if (num_particles < 256
-		|| num_mes < 256
-		|| !strcmp(kernel->cl_kernel_name_ext, "")
+	/* Asynchronous calls leave the CPU to the caller. */
+	if (request == NULL
+		&& strcmp(kernel->cl_kernel_name_ext, "")
+		&& dispatch_to_accelerator(DISPATCH_P3D_M2M_VEL, 
+			vortfunc_type_3D(kernel), particles.size(), num_mes)
+		&& hybrid_P3D_M2M_vel(particles, mes_start, num_mes, result_array,
+			kernel, regularisation_radius) == 0) {
+		return;
+	}
+	if (!strcmp(kernel->cl_kernel_name_ext, "")
+		|| !dispatch_to_accelerator(DISPATCH_P3D_M2M_VEL, 
+			vortfunc_type_3D(kernel), particles.size(), num_mes)
 		|| opencl_brute_force_P3D_M2M_vel(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius) != 0)
+			particles, mes_start, num_mes, result_array, kernel, 
+			regularisation_radius, request) != 0)
+#else
+	(void)request;	/* Only accelerated calls complete asynchronously. */
 #endif
 	{
-		cpu_brute_force_P3D_M2M_vel(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius);
+		if (simd_P3D_M2M_vel(particles.soa(), mes_start, num_mes,
+				result_array, kernel, regularisation_radius) != 0) {
+			cpu_brute_force_P3D_M2M_vel(particles.soa(), mes_start, num_mes,
+				result_array, kernel, regularisation_radius);
+		}
 	}
 	return;
 }
 
-void cpu_brute_force_P3D_M2M_dvort(
+CVTX_EXPORT void cvtx_P3D_M2M_vel_algorithm(
 	const cvtx_P3D **array_start,
 	const int num_particles,
-	const cvtx_P3D **induced_start,
-	const int num_induced,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm)
+{
+	P3D_M2M_vel_impl(P3DArray(array_start, num_particles), mes_start,
+		num_mes, result_array, kernel, regularisation_radius, algorithm, NULL);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
 {
-	long i;
-#pragma omp parallel for schedule(static)
-	for (i = 0; i < num_induced; ++i) {
-		result_array[i] = cvtx_P3D_M2S_dvort(
-			array_start, num_particles, induced_start[i], 
-			kernel, regularisation_radius);
-	}
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_vel_impl(P3DArray(P3DView(particles, stride), num_particles),
+		mes_start, num_mes, result_array, kernel, regularisation_radius,
+		&algorithm, NULL);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_soa(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(particles != NULL);
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_vel_impl(P3DArray(particles), mes_start, num_mes, 
+		result_array, kernel, regularisation_radius, &algorithm, NULL);
 	return;
 }
 
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_vel_async(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	cvtx_Request *request = new cvtx_Request;
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_vel_impl(P3DArray(array_start, num_particles), mes_start,
+		num_mes, result_array, kernel, regularisation_radius, &algorithm,
+		request);
+	return request;
+}
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_vel_soa_async(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(particles != NULL);
+	cvtx_Request *request = new cvtx_Request;
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_vel_impl(P3DArray(particles), mes_start, num_mes, 
+		result_array, kernel, regularisation_radius, &algorithm, request);
+	return request;
+}
+
 CVTX_EXPORT void cvtx_P3D_M2M_dvort(
 	const cvtx_P3D **array_start,
 	const int num_particles,
@@ -393,38 +626,161 @@ CVTX_EXPORT void cvtx_P3D_M2M_dvort(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius)
 {
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	cvtx_P3D_M2M_dvort_algorithm(array_start, num_particles, induced_start,
+		num_induced, result_array, kernel, regularisation_radius, &algorithm);
+	return;
+}
+
+static void P3D_M2M_dvort_impl(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm,
+	cvtx_Request *request)
+{
+	if (algorithm->type == CVTX_ALGORITHM_FMM
+		&& fmm_P3D_M2M_dvort(
+			particles.view(), particles.size(), induced.view(),
+			induced.size(), result_array, kernel, regularisation_radius,
+			algorithm->order, algorithm->theta) == 0) {
+		return;
+	}
 #ifdef CVTX_USING_OPENCL
-	if (	num_particles < 256
-		||	num_induced < 256
-		||	!strcmp(kernel->cl_kernel_name_ext, "")
-		||	opencl_brute_force_P3D_M2M_dvort(
-				array_start, num_particles, induced_start,
-				num_induced, result_array, kernel, regularisation_radius) != 0)
+	/* Asynchronous calls leave the CPU to the caller. */
+	if (	request == NULL
+		&&	strcmp(kernel->cl_kernel_name_ext, "")
+		&&	dispatch_to_accelerator(DISPATCH_P3D_M2M_DVORT, 
+				vortfunc_type_3D(kernel), particles.size(), induced.size())
+		&&	hybrid_P3D_M2M_dvort(particles, induced, result_array, kernel,
+				regularisation_radius) == 0) {
+		return;
+	}
+	if (	!strcmp(kernel->cl_kernel_name_ext, "")
+		||	!dispatch_to_accelerator(DISPATCH_P3D_M2M_DVORT, 
+				vortfunc_type_3D(kernel), particles.size(), induced.size())
+		||	opencl_brute_force_P3D_M2M_dvort(particles, induced, 
+				induced.size(), result_array, kernel, regularisation_radius,
+				request) != 0)
+#else
+	(void)request;	/* Only accelerated calls complete asynchronously. */
 #endif
 	{
-		cpu_brute_force_P3D_M2M_dvort(
-			array_start, num_particles, induced_start,
-			num_induced, result_array, kernel, regularisation_radius);
+		if (simd_P3D_M2M_dvort(particles.soa(), induced.soa(), 
+				result_array, kernel, regularisation_radius) != 0) {
+			cpu_brute_force_P3D_M2M_dvort(particles.soa(), induced.soa(),
+				result_array, kernel, regularisation_radius);
+		}
 	}
 	return;
 }
 
-void cpu_brute_force_P3D_M2M_visc_dvort(
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_algorithm(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	const cvtx_Algorithm *algorithm)
+{
+	P3D_M2M_dvort_impl(P3DArray(array_start, num_particles),
+		P3DArray(induced_start, num_induced), result_array, kernel, regularisation_radius,
+		algorithm, NULL);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_dvort_impl(P3DArray(P3DView(particles, stride), num_particles),
+		P3DArray(P3DView(induced, induced_stride), num_induced), result_array,
+		kernel, regularisation_radius, &algorithm, NULL);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_dvort_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(particles != NULL);
+	assert(induced != NULL);
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_dvort_impl(P3DArray(particles), P3DArray(induced), 
+		result_array, kernel, regularisation_radius, &algorithm, NULL);
+	return;
+}
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_dvort_async(
 	const cvtx_P3D **array_start,
 	const int num_particles,
 	const cvtx_P3D **induced_start,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	cvtx_Request *request = new cvtx_Request;
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_dvort_impl(P3DArray(array_start, num_particles),
+		P3DArray(induced_start, num_induced), result_array, kernel, 
+		regularisation_radius, &algorithm, request);
+	return request;
+}
+
+CVTX_EXPORT cvtx_Request *cvtx_P3D_M2M_dvort_soa_async(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(particles != NULL);
+	assert(induced != NULL);
+	cvtx_Request *request = new cvtx_Request;
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	P3D_M2M_dvort_impl(P3DArray(particles), P3DArray(induced), 
+		result_array, kernel, regularisation_radius, &algorithm, request);
+	return request;
+}
+
+static void P3D_M2M_visc_dvort_impl(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
-	long i;
-#pragma omp parallel for schedule(static)
-	for (i = 0; i < num_induced; ++i) {
-		result_array[i] = cvtx_P3D_M2S_visc_dvort(
-			array_start, num_particles, induced_start[i],
-			kernel, regularisation_radius, kinematic_visc);
+#ifdef CVTX_USING_OPENCL
+	if (	!strcmp(kernel->cl_kernel_name_ext, "")
+		||	!dispatch_to_accelerator(DISPATCH_P3D_M2M_VISC_DVORT, 
+				vortfunc_type_3D(kernel), particles.size(), induced.size())
+		||	opencl_brute_force_P3D_M2M_visc_dvort(particles, induced,
+				result_array, kernel, regularisation_radius, kinematic_visc) != 0)
+#endif
+	{
+		if (simd_P3D_M2M_visc_dvort(particles.soa(), induced.soa(), 
+				result_array, kernel, regularisation_radius, 
+				kinematic_visc) != 0) {
+			cpu_brute_force_P3D_M2M_visc_dvort(particles.soa(), induced.soa(),
+				result_array, kernel, regularisation_radius, kinematic_visc);
+		}
 	}
 	return;
 }
@@ -438,65 +794,271 @@ CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc)
+{
+	P3D_M2M_visc_dvort_impl(P3DArray(array_start, num_particles),
+		P3DArray(induced_start, num_induced), result_array, kernel, regularisation_radius,
+		kinematic_visc);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const cvtx_P3D *induced,
+	size_t induced_stride,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	P3D_M2M_visc_dvort_impl(
+		P3DArray(P3DView(particles, stride), num_particles),
+		P3DArray(P3DView(induced, induced_stride), num_induced), result_array,
+		kernel, regularisation_radius, kinematic_visc);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(particles != NULL);
+	assert(induced != NULL);
+	P3D_M2M_visc_dvort_impl(P3DArray(particles), P3DArray(induced), 
+		result_array, kernel, regularisation_radius, kinematic_visc);
+	return;
+}
+
+static void P3D_M2M_vel_dvort_visc_impl(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
 {
 #ifdef CVTX_USING_OPENCL
-	if (	num_particles < 256
-		||	num_induced < 256
-		||	!strcmp(kernel->cl_kernel_name_ext, "")
-		||	opencl_brute_force_P3D_M2M_visc_dvort(
-				array_start, num_particles, induced_start,
-				num_induced, result_array, kernel, regularisation_radius, kinematic_visc) != 0)
+	if (	!strcmp(kernel->cl_kernel_name_ext, "")
+		||	!dispatch_to_accelerator(DISPATCH_P3D_M2M_VEL_DVORT_VISC, 
+				vortfunc_type_3D(kernel), particles.size(), induced.size())
+		||	opencl_brute_force_P3D_M2M_vel_dvort_visc(particles, induced,
+				vel_result, dvort_result, visc_dvort_result, kernel, 
+				regularisation_radius, kinematic_visc) != 0)
 #endif
 	{
-		cpu_brute_force_P3D_M2M_visc_dvort(
+		if (simd_P3D_M2M_vel_dvort_visc(particles.soa(), induced.soa(), 
+				vel_result, dvort_result, visc_dvort_result, kernel,
+				regularisation_radius, kinematic_visc) != 0) {
+			cpu_brute_force_P3D_M2M_vel_dvort_visc(particles.soa(), 
+				induced.soa(), vel_result, dvort_result, visc_dvort_result,
+				kernel, regularisation_radius, kinematic_visc);
+		}
+	}
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_dvort_visc(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	P3D_M2M_vel_dvort_visc_impl(P3DArray(array_start, num_particles),
+		P3DArray(induced_start, num_induced), vel_result, dvort_result,
+		visc_dvort_result, kernel, regularisation_radius, kinematic_visc);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vel_dvort_visc_soa(
+	const cvtx_P3D_soa *particles,
+	const cvtx_P3D_soa *induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(particles != NULL);
+	assert(induced != NULL);
+	P3D_M2M_vel_dvort_visc_impl(P3DArray(particles), P3DArray(induced), 
+		vel_result, dvort_result, visc_dvort_result, kernel,
+		regularisation_radius, kinematic_visc);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_visc_dvort_truncated(
+	const cvtx_P3D **array_start,
+	const int num_particles,
+	const cvtx_P3D **induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc,
+	float truncation)
+{
+	assert(truncation >= 0.f);
+	if (truncation == 0.f
+		|| celllist_P3D_M2M_visc_dvort(
+			array_start, num_particles, induced_start,
+			num_induced, result_array, kernel, regularisation_radius, 
+			kinematic_visc, truncation * regularisation_radius) != 0)
+	{
+		cvtx_P3D_M2M_visc_dvort(
 			array_start, num_particles, induced_start,
 			num_induced, result_array, kernel, regularisation_radius, kinematic_visc);
 	}
 	return;
 }
 
-void cpu_brute_force_P3D_M2M_vort(
-	const cvtx_P3D** array_start,
+CVTX_EXPORT void cvtx_P3D_self_dvort(
+	const cvtx_P3D **array_start,
 	const int num_particles,
-	const bsv_V3f* mes_start,
-	const int num_mes,
-	bsv_V3f* result_array,
-	const cvtx_VortFunc* kernel,
-	float regularisation_radius) {
-	long i;
-#pragma omp parallel for schedule(guided)
-	for (i = 0; i < num_mes; ++i) {
-		result_array[i] = cvtx_P3D_M2S_vort(
-			array_start, num_particles, mes_start[i],
-			kernel, regularisation_radius);
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	/* Only the FMM has a dvort path that beats evaluating each pair once. */
+	const cvtx_Algorithm algorithm = cvtx_Algorithm_default();
+	const P3DArray particles(array_start, num_particles);
+	if (algorithm.type == CVTX_ALGORITHM_FMM
+		&& fmm_P3D_M2M_dvort(
+			particles.view(), num_particles, particles.view(),
+			num_particles, result_array, kernel, regularisation_radius,
+			algorithm.order, algorithm.theta) == 0) {
+		return;
+	}
+#ifdef CVTX_USING_OPENCL
+	if (	!strcmp(kernel->cl_kernel_name_ext, "")
+		||	!dispatch_to_accelerator(DISPATCH_P3D_SELF_DVORT, 
+				vortfunc_type_3D(kernel), num_particles, num_particles)
+		||	opencl_brute_force_P3D_M2M_dvort(particles, particles,
+				num_particles, result_array, kernel, regularisation_radius, 
+				NULL) != 0)
+#endif
+	{
+		if (simd_P3D_self_dvort(particles.soa(), result_array, kernel, 
+				regularisation_radius) != 0) {
+			cpu_pairwise_P3D_self_dvort(array_start, num_particles,
+				result_array, kernel, regularisation_radius);
+		}
 	}
 	return;
 }
 
-CVTX_EXPORT void cvtx_P3D_M2M_vort(
-	const cvtx_P3D** array_start,
+CVTX_EXPORT void cvtx_P3D_self_visc_dvort(
+	const cvtx_P3D **array_start,
 	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const P3DArray particles(array_start, num_particles);
+#ifdef CVTX_USING_OPENCL
+	if (	!strcmp(kernel->cl_kernel_name_ext, "")
+		||	!dispatch_to_accelerator(DISPATCH_P3D_SELF_VISC_DVORT, 
+				vortfunc_type_3D(kernel), num_particles, num_particles)
+		||	opencl_brute_force_P3D_M2M_visc_dvort(particles, particles,
+				result_array, kernel, regularisation_radius, kinematic_visc) != 0)
+#endif
+	{
+		if (simd_P3D_self_visc_dvort(particles.soa(), result_array, kernel,
+				regularisation_radius, kinematic_visc) != 0) {
+			cpu_pairwise_P3D_self_visc_dvort(array_start, num_particles,
+				result_array, kernel, regularisation_radius, kinematic_visc);
+		}
+	}
+	return;
+}
+
+static void P3D_M2M_vort_impl(
+	const P3DArray &particles,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
 	const cvtx_VortFunc* kernel,
 	float regularisation_radius) {
+	/* Only particles within the cutoff contribute: a cell list makes 
+	this O(N + M) so is preferred even to the accelerators. */
+	if (celllist_P3D_M2M_vort(
+			particles.view(), particles.size(), mes_start,
+			num_mes, result_array, kernel, regularisation_radius) == 0) {
+		return;
+	}
 #ifdef CVTX_USING_OPENCL
-	if (num_particles < 256
-		|| num_mes < 256
-		|| !strcmp(kernel->cl_kernel_name_ext, "")
+	if (!strcmp(kernel->cl_kernel_name_ext, "")
+		|| !dispatch_to_accelerator(DISPATCH_P3D_M2M_VORT, 
+			vortfunc_type_3D(kernel), particles.size(), num_mes)
 		|| opencl_brute_force_P3D_M2M_vort(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius) != 0)
+			particles, mes_start, num_mes, result_array, kernel, 
+			regularisation_radius) != 0)
 #endif
 	{
 		cpu_brute_force_P3D_M2M_vort(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius);
+			particles.soa(), mes_start, num_mes, result_array, kernel, regularisation_radius);
 	}
 	return;
 }
 
+CVTX_EXPORT void cvtx_P3D_M2M_vort(
+	const cvtx_P3D** array_start,
+	const int num_particles,
+	const bsv_V3f* mes_start,
+	const int num_mes,
+	bsv_V3f* result_array,
+	const cvtx_VortFunc* kernel,
+	float regularisation_radius)
+{
+	P3D_M2M_vort_impl(P3DArray(array_start, num_particles), mes_start,
+		num_mes, result_array, kernel, regularisation_radius);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vort_strided(
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	P3D_M2M_vort_impl(P3DArray(P3DView(particles, stride), num_particles),
+		mes_start, num_mes, result_array, kernel, regularisation_radius);
+	return;
+}
+
+CVTX_EXPORT void cvtx_P3D_M2M_vort_soa(
+	const cvtx_P3D_soa *particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(particles != NULL);
+	P3D_M2M_vort_impl(P3DArray(particles), mes_start, num_mes,
+		result_array, kernel, regularisation_radius);
+	return;
+}
+
 
 /* Particle redistribution -------------------------------------------------*/
 
@@ -547,9 +1109,9 @@ CVTX_EXPORT int cvtx_P3D_redistribute_on_grid(
 	dcorner.x[2] = roundf(dcorner.x[2]) + 5;
 	min = bsv_V3f_minus(mean, bsv_V3f_mult(dcorner, grid_density));
 
-	/* Create an octtree on a grid and add all the new particles to it. 
+	/* Accumulate the new particles' vorticity at their grid points. 
 	We spread the work across multiple threads and then merge the results. */
-	std::vector<GridParticleOcttree> ptree(nthreads);
+	std::vector<GridParticleHashMap> pmap(nthreads);
 #pragma omp parallel for schedule(static)
 	for (long long  threadid = 0; threadid < nthreads; threadid++) {
 		std::vector<UIntKey96> key_buffer;
@@ -578,20 +1140,20 @@ CVTX_EXPORT int cvtx_P3D_redistribute_on_grid(
 					* redistributor->func(V);
 				str_buffer[j] = bsv_V3f_mult(tparticle_str, vortfrac);
 			}
-			ptree[threadid].add_particles(key_buffer, str_buffer);
+			pmap[threadid].add_particles(key_buffer, str_buffer);
 		}
 	}
 	for (int threadid = 1; threadid < (int)nthreads; threadid++) {
-		ptree[0].merge_in(ptree[threadid]);
+		pmap[0].merge_in(pmap[threadid]);
+		pmap[threadid].clear();
 	}
-	ptree.resize(1);
-	GridParticleOcttree &tree = ptree[0];
+	GridParticleHashMap &grid = pmap[0];
 	/* Go back to array of particles. */
-	n_created_particles = tree.number_of_particles();
+	n_created_particles = grid.number_of_particles();
 	std::vector<UIntKey96> new_particle_keys(n_created_particles);
 	std::vector<bsv_V3f> new_particle_strs(n_created_particles);
 	std::vector<cvtx_P3D> new_particles(n_created_particles);
-	tree.flatten_tree(new_particle_keys.data(), 
+	grid.flatten(new_particle_keys.data(), 
 		new_particle_strs.data(), (int)n_created_particles);
 	float np_vol = grid_density * grid_density * grid_density;
 	for (int i = 0; i < n_created_particles; ++i) {
@@ -0,0 +1,329 @@
+#include "P3D_soa.h"
+/*============================================================================
+P3D_soa.cpp
+
+Structure of arrays storage of 3D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#	include <malloc.h>
+#endif
+
+#include "OclP3DBuffers.h"
+#include "opencl_acc.h"
+
+static float *aligned_float_alloc(size_t n, size_t alignment)
+{
+	void *ret;
+#ifdef _WIN32
+	ret = _aligned_malloc(n * sizeof(float), alignment);
+#else
+	if (posix_memalign(&ret, alignment, n * sizeof(float)) != 0) {
+		ret = NULL;
+	}
+#endif
+	return (float*)ret;
+}
+
+static void aligned_float_free(float *ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+cvtx_P3D_soa::cvtx_P3D_soa()
+	: m_size(0), m_capacity(0), m_data(NULL), m_volume(NULL), 
+	m_device(NULL)
+{
+	for (int i = 0; i < 3; ++i) {
+		m_coord[i] = NULL;
+		m_vorticity[i] = NULL;
+	}
+}
+
+cvtx_P3D_soa::~cvtx_P3D_soa()
+{
+	release_device();
+	aligned_float_free(m_data);
+}
+
+int cvtx_P3D_soa::padded_size() const
+{
+	return ((m_size + padding - 1) / padding) * padding;
+}
+
+void cvtx_P3D_soa::resize(int n)
+{
+	assert(n >= 0);
+	m_size = n;
+	int padded = padded_size();
+	if (padded > m_capacity || m_data == NULL) {
+		aligned_float_free(m_data);
+		m_capacity = padded > 0 ? padded : padding;
+		m_data = aligned_float_alloc(7 * (size_t)m_capacity, alignment);
+		assert(m_data != NULL);
+		for (int i = 0; i < 3; ++i) {
+			m_coord[i] = m_data + i * (size_t)m_capacity;
+			m_vorticity[i] = m_data + (3 + i) * (size_t)m_capacity;
+		}
+		m_volume = m_data + 6 * (size_t)m_capacity;
+	}
+	/* Padding particles do nothing. */
+	for (int i = m_size; i < padded; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			m_coord[j][i] = 0.f;
+			m_vorticity[j][i] = 0.f;
+		}
+		m_volume[i] = 0.f;
+	}
+}
+
+void cvtx_P3D_soa::fill(const P3DView &particles, int n)
+{
+	resize(n);
+	int i;
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < n; ++i) {
+		const cvtx_P3D &p = particles[i];
+		for (int j = 0; j < 3; ++j) {
+			m_coord[j][i] = p.coord.x[j];
+			m_vorticity[j][i] = p.vorticity.x[j];
+		}
+		m_volume[i] = p.volume;
+	}
+#ifdef CVTX_USING_OPENCL
+	if (m_device != NULL && m_device->upload(*this) != 0) {
+		release_device();
+	}
+#endif
+}
+
+int cvtx_P3D_soa::to_device()
+{
+#ifdef CVTX_USING_OPENCL
+	cl_program program;
+	cl_context context;
+	cl_command_queue queue;
+	/* The copy is made in the first active device's context. Buffers are 
+	shared by a context, so other devices of its platform use it too. Those
+	of other platforms can't, and are sent the particles each call. */
+	if (	opencl_load() >= 0 && opencl_num_active_devices() > 0
+		&&	opencl_get_device_state(0, &program, &context, &queue) == 0) {
+		if (m_device == NULL) {
+			m_device = new OclP3DBuffers;
+		}
+		if (m_device->upload(*this, context, queue) == 0) {
+			return 0;
+		}
+		release_device();
+	}
+#endif
+	return -1;
+}
+
+void cvtx_P3D_soa::release_device()
+{
+#ifdef CVTX_USING_OPENCL
+	delete m_device;
+#endif
+	m_device = NULL;
+}
+
+cvtx_P3D cvtx_P3D_soa::particle(int i) const
+{
+	assert(i >= 0 && i < m_size);
+	cvtx_P3D ret;
+	for (int j = 0; j < 3; ++j) {
+		ret.coord.x[j] = m_coord[j][i];
+		ret.vorticity.x[j] = m_vorticity[j][i];
+	}
+	ret.volume = m_volume[i];
+	return ret;
+}
+
+P3DArray::P3DArray(const P3DView &particles, int num_particles)
+	: m_size(num_particles), m_soa(NULL), m_view(particles),
+	m_have_view(true), m_have_soa(false)
+{
+}
+
+P3DArray::P3DArray(const cvtx_P3D_soa *particles)
+	: m_size(particles->size()), m_soa(particles), 
+	m_view((const cvtx_P3D*)NULL, 0), m_have_view(false), m_have_soa(true)
+{
+}
+
+const P3DView &P3DArray::view() const
+{
+	if (!m_have_view) {
+		m_aos_copy.resize(m_size);
+		int i;
+#pragma omp parallel for schedule(static)
+		for (i = 0; i < m_size; ++i) {
+			m_aos_copy[i] = m_soa->particle(i);
+		}
+		m_view = P3DView(m_aos_copy.data(), 0);
+		m_have_view = true;
+	}
+	return m_view;
+}
+
+const OclP3DBuffers *P3DArray::device() const
+{
+	return m_have_soa ? m_soa->device() : NULL;
+}
+
+const cvtx_P3D_soa &P3DArray::soa() const
+{
+	if (!m_have_soa) {
+		m_soa_copy.fill(m_view, m_size);
+		m_soa = &m_soa_copy;
+		m_have_soa = true;
+	}
+	return *m_soa;
+}
+
+/* Keep the accelerator copy in step with the host. If that fails the
+copy is dropped and the OpenCL functions copy the particles each call. */
+enum { SOA_COORDS, SOA_VORTICITIES, SOA_VOLUMES };
+#ifdef CVTX_USING_OPENCL
+static void update_device(cvtx_P3D_soa *soa, int field)
+{
+	OclP3DBuffers *dev = soa->device();
+	int status = 0;
+	if (dev == NULL) { return; }
+	switch (field) {
+	case SOA_COORDS: status = dev->update_coords(*soa); break;
+	case SOA_VORTICITIES: status = dev->update_vorticities(*soa); break;
+	case SOA_VOLUMES: status = dev->update_volumes(*soa); break;
+	}
+	if (status != 0) {
+		soa->release_device();
+	}
+}
+#else
+static inline void update_device(cvtx_P3D_soa *, int) {}
+#endif
+
+/* The public interface -----------------------------------------------------*/
+
+CVTX_EXPORT cvtx_P3D_soa *cvtx_P3D_soa_create(void)
+{
+	return new cvtx_P3D_soa;
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_destroy(cvtx_P3D_soa *soa)
+{
+	delete soa;
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_fill(
+	cvtx_P3D_soa *soa,
+	const cvtx_P3D **array_start,
+	const int num_particles)
+{
+	assert(soa != NULL);
+	assert(num_particles >= 0);
+	soa->fill(P3DView(array_start), num_particles);
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_fill_strided(
+	cvtx_P3D_soa *soa,
+	const cvtx_P3D *particles,
+	size_t stride,
+	const int num_particles)
+{
+	assert(soa != NULL);
+	assert(num_particles >= 0);
+	soa->fill(P3DView(particles, stride), num_particles);
+}
+
+CVTX_EXPORT int cvtx_P3D_soa_size(const cvtx_P3D_soa *soa)
+{
+	assert(soa != NULL);
+	return soa->size();
+}
+
+CVTX_EXPORT cvtx_P3D cvtx_P3D_soa_get(const cvtx_P3D_soa *soa, int index)
+{
+	assert(soa != NULL);
+	return soa->particle(index);
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_update_coords(
+	cvtx_P3D_soa *soa,
+	const bsv_V3f *coords)
+{
+	assert(soa != NULL);
+	int i;
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < soa->size(); ++i) {
+		for (int j = 0; j < 3; ++j) {
+			soa->coord(j)[i] = coords[i].x[j];
+		}
+	}
+	update_device(soa, SOA_COORDS);
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_update_vorticities(
+	cvtx_P3D_soa *soa,
+	const bsv_V3f *vorticities)
+{
+	assert(soa != NULL);
+	int i;
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < soa->size(); ++i) {
+		for (int j = 0; j < 3; ++j) {
+			soa->vorticity(j)[i] = vorticities[i].x[j];
+		}
+	}
+	update_device(soa, SOA_VORTICITIES);
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_update_volumes(
+	cvtx_P3D_soa *soa,
+	const float *volumes)
+{
+	assert(soa != NULL);
+	memcpy(soa->volume(), volumes, sizeof(float) * soa->size());
+	update_device(soa, SOA_VOLUMES);
+}
+
+CVTX_EXPORT int cvtx_P3D_soa_to_accelerator(cvtx_P3D_soa *soa)
+{
+	assert(soa != NULL);
+	return soa->to_device();
+}
+
+CVTX_EXPORT void cvtx_P3D_soa_release_accelerator(cvtx_P3D_soa *soa)
+{
+	assert(soa != NULL);
+	soa->release_device();
+}
@@ -0,0 +1,113 @@
+#ifndef CVTX_P3D_SOA_H
+#define CVTX_P3D_SOA_H
+#include "libcvtx.h"
+/*============================================================================
+P3D_soa.h
+
+Structure of arrays storage of 3D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <vector>
+
+#include <bsv/bsv.h>
+
+#include "ParticleView.h"
+
+class OclP3DBuffers;
+
+/* The particles' coordinates, vorticities and volumes are stored in
+separate arrays aligned to alignment bytes. The arrays are padded to a
+multiple of padding elements with particles of zero vorticity and volume
+at the origin, so vectorised loops can run past size(). */
+struct cvtx_P3D_soa {
+public:
+	cvtx_P3D_soa();
+	~cvtx_P3D_soa();
+
+	/* Make space for n particles. Contents are not kept. */
+	void resize(int n);
+	/* Copy n particles in. */
+	void fill(const P3DView &particles, int n);
+	cvtx_P3D particle(int i) const;
+
+	int size() const { return m_size; }
+	/* size() rounded up to a multiple of padding. */
+	int padded_size() const;
+
+	float *coord(int dim) { return m_coord[dim]; }
+	float *vorticity(int dim) { return m_vorticity[dim]; }
+	float *volume() { return m_volume; }
+	const float *coord(int dim) const { return m_coord[dim]; }
+	const float *vorticity(int dim) const { return m_vorticity[dim]; }
+	const float *volume() const { return m_volume; }
+
+	/* The copy kept on an accelerator by cvtx_P3D_soa_to_accelerator, 
+	or NULL. fill() and the update functions keep it up to date. */
+	OclP3DBuffers *device() const { return m_device; }
+	/* Returns 0 on success, -1 if there is no usable accelerator. */
+	int to_device();
+	void release_device();
+
+	static const int alignment = 64;
+	static const int padding = alignment / sizeof(float);
+
+protected:
+	int m_size, m_capacity;
+	float *m_data;
+	float *m_coord[3], *m_vorticity[3], *m_volume;
+	OclP3DBuffers *m_device;
+
+	/* Not copyable. */
+	cvtx_P3D_soa(const cvtx_P3D_soa&);
+	cvtx_P3D_soa &operator=(const cvtx_P3D_soa&);
+};
+
+/* Particles passed to the API, either as a view of cvtx_P3Ds or as a 
+cvtx_P3D_soa. Either form can be obtained, and is copied into on first
+use if the particles weren't given in that form. */
+class P3DArray {
+public:
+	P3DArray(const P3DView &particles, int num_particles);
+	P3DArray(const cvtx_P3D_soa *particles);
+
+	int size() const { return m_size; }
+	const P3DView &view() const;
+	const cvtx_P3D_soa &soa() const;
+	/* The accelerator copy if the particles were given as a 
+	cvtx_P3D_soa kept on an accelerator, NULL otherwise. */
+	const OclP3DBuffers *device() const;
+
+protected:
+	int m_size;
+	mutable const cvtx_P3D_soa *m_soa;
+	mutable P3DView m_view;
+	mutable std::vector<cvtx_P3D> m_aos_copy;
+	mutable cvtx_P3D_soa m_soa_copy;
+	mutable bool m_have_view, m_have_soa;
+
+	/* Not copyable. */
+	P3DArray(const P3DArray&);
+	P3DArray &operator=(const P3DArray&);
+};
+
+#endif /* CVTX_P3D_SOA_H */
@@ -0,0 +1,104 @@
+#include "ParticleCellList.h"
+/*============================================================================
+ParticleCellList.cpp
+
+A hashed uniform grid (cell list) over a set of points, used for
+short ranged interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <algorithm>
+#include <cassert>
+
+ParticleCellList::ParticleCellList()
+	: m_cell_width(0.f), m_rcell_width(0.f), m_origin(bsv_V3f_zero()),
+	m_num_cells{ 0, 0, 0 }
+{
+}
+
+int ParticleCellList::build(
+	const bsv_V3f* points, int n_points, float cell_width)
+{
+	assert(n_points >= 0);
+	clear();
+	if (!(cell_width > 0.f) || n_points == 0) { return -1; }
+
+	bsv_V3f min = points[0], max = points[0];
+	for (int i = 1; i < n_points; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			min.x[j] = std::min(min.x[j], points[i].x[j]);
+			max.x[j] = std::max(max.x[j], points[i].x[j]);
+		}
+	}
+	for (int j = 0; j < 3; ++j) {
+		float n = (max.x[j] - min.x[j]) / cell_width + 1.f;
+		if (!(n < (float)max_cells)) { return -1; }
+		m_num_cells[j] = (int)n;
+	}
+	m_cell_width = cell_width;
+	m_rcell_width = 1.f / cell_width;
+	m_origin = min;
+
+	/* Sort the points by cell key. */
+	std::vector<std::pair<uint64_t, int>> keyed(n_points);
+	for (int i = 0; i < n_points; ++i) {
+		int64_t c[3];
+		for (int j = 0; j < 3; ++j) {
+			c[j] = (int64_t)((points[i].x[j] - min.x[j]) * m_rcell_width);
+			c[j] = std::min(c[j], (int64_t)m_num_cells[j] - 1);
+		}
+		keyed[i] = std::make_pair(key(c[0], c[1], c[2]), i);
+	}
+	std::sort(keyed.begin(), keyed.end());
+
+	m_permutation.resize(n_points);
+	m_cells.reserve(n_points);
+	int begin = 0;
+	for (int i = 0; i < n_points; ++i) {
+		m_permutation[i] = keyed[i].second;
+		if (i + 1 == n_points || keyed[i + 1].first != keyed[i].first) {
+			m_cells[keyed[i].first] = std::make_pair(begin, i + 1);
+			begin = i + 1;
+		}
+	}
+	return 0;
+}
+
+float ParticleCellList::cell_width() const
+{
+	return m_cell_width;
+}
+
+const std::vector<int>& ParticleCellList::permutation() const
+{
+	return m_permutation;
+}
+
+void ParticleCellList::clear()
+{
+	m_cell_width = 0.f;
+	m_rcell_width = 0.f;
+	m_origin = bsv_V3f_zero();
+	m_num_cells[0] = m_num_cells[1] = m_num_cells[2] = 0;
+	m_permutation.clear();
+	m_cells.clear();
+}
@@ -0,0 +1,106 @@
+#ifndef CVTX_PARTICLECELLLIST_H
+#define CVTX_PARTICLECELLLIST_H
+/*============================================================================
+ParticleCellList.h
+
+A hashed uniform grid (cell list) over a set of points, used for
+short ranged interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <bsv/bsv_V3f.h>
+
+class ParticleCellList {
+public:
+	ParticleCellList();
+
+	/* Bin n_points points into cubic cells of edge length cell_width.
+	Returns 0 on success, or non-zero if cell_width isn't usable for the
+	extent of the points (in which case the list is empty). */
+	int build(const bsv_V3f* points, int n_points, float cell_width);
+
+	float cell_width() const;
+
+	/* Points are grouped by cell: the points of a cell are the original
+	points permutation()[begin] to permutation()[end - 1]. */
+	const std::vector<int>& permutation() const;
+
+	/* Call func(begin, end) for each non-empty cell in the 3x3x3 block
+	of cells around point. Every point within cell_width of point in each
+	coordinate is visited. */
+	template<typename Func>
+	void for_each_neighbour_cell(const bsv_V3f& point, Func func) const;
+
+	/* Empty the list. */
+	void clear();
+
+	/* Maximum number of cells in each direction. */
+	static const int max_cells = 1 << 20;
+
+protected:
+	static uint64_t key(int64_t i, int64_t j, int64_t k);
+
+	float m_cell_width, m_rcell_width;
+	bsv_V3f m_origin;
+	int m_num_cells[3];
+	std::vector<int> m_permutation;
+	std::unordered_map<uint64_t, std::pair<int, int>> m_cells;
+};
+
+inline uint64_t ParticleCellList::key(int64_t i, int64_t j, int64_t k)
+{
+	return ((uint64_t)i << 42) | ((uint64_t)j << 21) | (uint64_t)k;
+}
+
+template<typename Func>
+void ParticleCellList::for_each_neighbour_cell(
+	const bsv_V3f& point, Func func) const
+{
+	if (m_cells.empty()) { return; }
+	int64_t lo[3], hi[3];
+	for (int d = 0; d < 3; ++d) {
+		float c = (point.x[d] - m_origin.x[d]) * m_rcell_width;
+		/* Points far outside the grid have no neighbours. NaN is too. */
+		if (!(c >= -1.f && c < (float)m_num_cells[d] + 1.f)) { return; }
+		int64_t ic = (int64_t)floorf(c);
+		lo[d] = ic > 0 ? ic - 1 : 0;
+		hi[d] = ic + 1 < m_num_cells[d] - 1 ? ic + 1 : m_num_cells[d] - 1;
+	}
+	for (int64_t i = lo[0]; i <= hi[0]; ++i) {
+		for (int64_t j = lo[1]; j <= hi[1]; ++j) {
+			for (int64_t k = lo[2]; k <= hi[2]; ++k) {
+				auto it = m_cells.find(key(i, j, k));
+				if (it != m_cells.end()) {
+					func(it->second.first, it->second.second);
+				}
+			}
+		}
+	}
+}
+
+#endif /* CVTX_PARTICLECELLLIST_H */
@@ -0,0 +1,84 @@
+#ifndef CVTX_PARTICLEOCTTREE_H
+#define CVTX_PARTICLEOCTTREE_H
+/*============================================================================
+ParticleOcttree.h
+
+An adaptive octtree over a set of points, used by the tree based methods.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <bsv/bsv_V3f.h>
+
+/* A node of a ParticleOcttree. Nodes refer to their children by index. */
+class ParticleOcttreeNode {
+public:
+	ParticleOcttreeNode();
+
+	bsv_V3f centre;			/* Geometric centre of the node's cube. */
+	float half_width;		/* Half the edge length of the node's cube. */
+	int level;				/* Root is level 0. */
+	int parent;				/* -1 for the root. */
+	int begin, end;			/* Range of the tree's point permutation. */
+	std::array<int, 8> child_idxs;	/* -1 where there is no child. */
+	int num_children;
+
+	bool is_leaf() const { return num_children == 0; }
+	int num_points() const { return end - begin; }
+};
+
+class ParticleOcttree {
+public:
+	ParticleOcttree();
+
+	/* Build the tree over n_points points. A node is split if it contains
+	more than max_leaf_size points and the maximum depth is not reached. */
+	void build(const bsv_V3f* points, int n_points, int max_leaf_size);
+
+	/* The number of nodes in the tree. The root is node 0. */
+	int number_of_nodes() const;
+	const ParticleOcttreeNode& node(int idx) const;
+
+	/* Points are grouped by node: the points of node n are the
+	original points permutation()[node(n).begin] to 
+	permutation()[node(n).end - 1]. */
+	const std::vector<int>& permutation() const;
+
+	/* Node indexes of the given level. Level 0 is the root. */
+	const std::vector<int>& level_nodes(int level) const;
+	int number_of_levels() const;
+
+	/* Empty the tree. */
+	void clear();
+
+	static const int max_depth = 21;
+
+protected:
+	std::vector<ParticleOcttreeNode> m_nodes;
+	std::vector<int> m_permutation;
+	std::vector<std::vector<int>> m_levels;
+};
+
+#endif /* CVTX_PARTICLEOCTTREE_H */
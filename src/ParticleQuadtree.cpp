@@ -0,0 +1,159 @@
+#include "ParticleQuadtree.h"
+/*============================================================================
+ParticleQuadtree.cpp
+
+An adaptive quadtree over a set of points, used by the tree based methods.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <algorithm>
+#include <cassert>
+
+ParticleQuadtreeNode::ParticleQuadtreeNode()
+	: centre(bsv_V2f_zero()), half_width(0.f), level(0), parent(-1),
+	begin(0), end(0), num_children(0)
+{
+	child_idxs.fill(-1);
+}
+
+ParticleQuadtree::ParticleQuadtree()
+{
+}
+
+void ParticleQuadtree::build(
+	const bsv_V2f* points, int n_points, int max_leaf_size)
+{
+	assert(n_points >= 0);
+	assert(max_leaf_size > 0);
+	clear();
+	m_permutation.resize(n_points);
+	for (int i = 0; i < n_points; ++i) { m_permutation[i] = i; }
+	if (n_points == 0) { return; }
+
+	/* The root is the bounding square of all the points. */
+	bsv_V2f min = points[0], max = points[0];
+	for (int i = 1; i < n_points; ++i) {
+		for (int j = 0; j < 2; ++j) {
+			min.x[j] = std::min(min.x[j], points[i].x[j]);
+			max.x[j] = std::max(max.x[j], points[i].x[j]);
+		}
+	}
+	ParticleQuadtreeNode root;
+	float width = 0.f;
+	for (int j = 0; j < 2; ++j) {
+		root.centre.x[j] = 0.5f * (min.x[j] + max.x[j]);
+		width = std::max(width, max.x[j] - min.x[j]);
+	}
+	/* Pad slightly so that no point lies on the boundary. */
+	root.half_width = 0.5f * width * 1.0001f + 1e-30f;
+	root.begin = 0;
+	root.end = n_points;
+	m_nodes.push_back(root);
+
+	/* Breadth first, so nodes of a level are contiguous. */
+	std::vector<int> buffer(n_points);
+	std::vector<unsigned char> quadrants(n_points);
+	for (size_t ni = 0; ni < m_nodes.size(); ++ni) {
+		ParticleQuadtreeNode nd = m_nodes[ni];
+		if ((int)m_levels.size() <= nd.level) { m_levels.emplace_back(); }
+		m_levels[nd.level].push_back((int)ni);
+		if (nd.num_points() <= max_leaf_size || nd.level >= max_depth) {
+			continue;
+		}
+		/* Counting sort of the node's points by quadrant. */
+		std::array<int, 5> counts;
+		counts.fill(0);
+		for (int i = nd.begin; i < nd.end; ++i) {
+			const bsv_V2f& p = points[m_permutation[i]];
+			int quad = (p.x[0] > nd.centre.x[0] ? 1 : 0)
+				+ (p.x[1] > nd.centre.x[1] ? 2 : 0);
+			quadrants[i] = (unsigned char)quad;
+			counts[quad + 1]++;
+		}
+		for (int i = 1; i < 5; ++i) { counts[i] += counts[i - 1]; }
+		std::array<int, 4> offsets;
+		for (int i = 0; i < 4; ++i) { offsets[i] = nd.begin + counts[i]; }
+		for (int i = nd.begin; i < nd.end; ++i) {
+			buffer[offsets[quadrants[i]]++] = m_permutation[i];
+		}
+		std::copy(buffer.begin() + nd.begin, buffer.begin() + nd.end,
+			m_permutation.begin() + nd.begin);
+		/* Create the children. */
+		int num_children = 0;
+		for (int quad = 0; quad < 4; ++quad) {
+			if (counts[quad + 1] == counts[quad]) { continue; }
+			ParticleQuadtreeNode child;
+			child.half_width = nd.half_width * 0.5f;
+			child.centre.x[0] = nd.centre.x[0] 
+				+ (quad & 1 ? child.half_width : -child.half_width);
+			child.centre.x[1] = nd.centre.x[1]
+				+ (quad & 2 ? child.half_width : -child.half_width);
+			child.level = nd.level + 1;
+			child.parent = (int)ni;
+			child.begin = nd.begin + counts[quad];
+			child.end = nd.begin + counts[quad + 1];
+			m_nodes.push_back(child);
+			/* m_nodes may have been reallocated. */
+			m_nodes[ni].child_idxs[quad] = (int)m_nodes.size() - 1;
+			num_children++;
+		}
+		m_nodes[ni].num_children = num_children;
+	}
+	return;
+}
+
+int ParticleQuadtree::number_of_nodes() const
+{
+	return (int)m_nodes.size();
+}
+
+const ParticleQuadtreeNode& ParticleQuadtree::node(int idx) const
+{
+	assert(idx >= 0);
+	assert(idx < (int)m_nodes.size());
+	return m_nodes[idx];
+}
+
+const std::vector<int>& ParticleQuadtree::permutation() const
+{
+	return m_permutation;
+}
+
+const std::vector<int>& ParticleQuadtree::level_nodes(int level) const
+{
+	assert(level >= 0);
+	assert(level < (int)m_levels.size());
+	return m_levels[level];
+}
+
+int ParticleQuadtree::number_of_levels() const
+{
+	return (int)m_levels.size();
+}
+
+void ParticleQuadtree::clear()
+{
+	m_nodes.clear();
+	m_permutation.clear();
+	m_levels.clear();
+	return;
+}
@@ -0,0 +1,84 @@
+#ifndef CVTX_PARTICLEVIEW_H
+#define CVTX_PARTICLEVIEW_H
+#include "libcvtx.h"
+/*============================================================================
+ParticleView.h
+
+Read only access to a set of particles (or filaments) given either as
+an array of pointers or as a strided array.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cstddef>
+
+#include <bsv/bsv.h>
+
+/* The library's API mostly takes arrays of pointers to particles, but
+also accepts a pointer to the first of a strided array of particles. 
+This lets the internals treat both the same. */
+template<typename ParticleT>
+class ParticleView {
+public:
+	/* View of pointers[0] to pointers[n-1]. */
+	ParticleView(const ParticleT **pointers)
+		: m_pointers(pointers), m_base(NULL), m_stride(0)
+	{
+	}
+
+	/* View of the particles at (char*)particles + i * stride. A stride
+	of 0 means a contiguous array. */
+	ParticleView(const ParticleT *particles, size_t stride)
+		: m_pointers(NULL), m_base((const char*)particles),
+		m_stride(stride == 0 ? sizeof(ParticleT) : stride)
+	{
+	}
+
+	const ParticleT &operator[](long i) const
+	{
+		return m_pointers != NULL ? *m_pointers[i]
+			: *(const ParticleT*)(m_base + i * m_stride);
+	}
+
+	/* View of the particles from first onwards. */
+	ParticleView offset(long first) const
+	{
+		ParticleView view(*this);
+		if (m_pointers != NULL) {
+			view.m_pointers += first;
+		}
+		else {
+			view.m_base += first * m_stride;
+		}
+		return view;
+	}
+
+protected:
+	const ParticleT **m_pointers;
+	const char *m_base;
+	size_t m_stride;
+};
+
+typedef ParticleView<cvtx_P3D> P3DView;
+typedef ParticleView<cvtx_P2D> P2DView;
+typedef ParticleView<cvtx_F3D> F3DView;
+
+#endif /* CVTX_PARTICLEVIEW_H */
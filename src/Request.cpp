@@ -0,0 +1,127 @@
+#include "Request.h"
+/*============================================================================
+Request.cpp
+
+Completion handles for asynchronous many-to-many evaluations.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+cvtx_Request::cvtx_Request()
+#ifdef CVTX_USING_OPENCL
+	: m_reads()
+#endif
+{
+}
+
+cvtx_Request::~cvtx_Request()
+{
+	/* The results would otherwise be read into freed memory. */
+	wait();
+}
+
+bool cvtx_Request::test()
+{
+#ifdef CVTX_USING_OPENCL
+	cl_int execution_status;
+	for (PendingRead &read : m_reads) {
+		clGetEventInfo(read.event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+			sizeof(cl_int), &execution_status, NULL);
+		if (execution_status != CL_COMPLETE) { return false; }
+	}
+#endif
+	return true;
+}
+
+int cvtx_Request::wait()
+{
+	int good = 0;
+#ifdef CVTX_USING_OPENCL
+	cl_int status;
+	size_t i;
+	for (PendingRead &read : m_reads) {
+		status = clWaitForEvents(1, &read.event);
+		clReleaseEvent(read.event);
+		/* The staging data of a failed read is garbage. */
+		if (status != CL_SUCCESS) {
+			good = -1;
+			continue;
+		}
+		for (i = 0; i < read.data.size(); ++i) {
+			read.result[i].x[0] = read.data[i].x * read.multiplyer;
+			read.result[i].x[1] = read.data[i].y * read.multiplyer;
+			read.result[i].x[2] = read.data[i].z * read.multiplyer;
+		}
+	}
+	m_reads.clear();
+#endif
+	return good;
+}
+
+#ifdef CVTX_USING_OPENCL
+cl_int cvtx_Request::enqueue_read(
+	cl_command_queue queue,
+	cl_mem buffer,
+	int num,
+	float multiplyer,
+	bsv_V3f *result_array)
+{
+	cl_int status;
+	PendingRead read;
+	read.data.resize(num);
+	read.multiplyer = multiplyer;
+	read.result = result_array;
+	status = clEnqueueReadBuffer(queue, buffer, CL_FALSE, 0,
+		sizeof(cl_float3) * num, read.data.data(), 0, NULL, &read.event);
+	if (status != CL_SUCCESS) { return status; }
+	/* Make sure the work is submitted before the user waits on it. */
+	clFlush(queue);
+	/* Moving the vector keeps the pointer the read was given. */
+	m_reads.push_back(std::move(read));
+	return status;
+}
+
+cl_int cvtx_Request::set_callback(
+	void (CL_CALLBACK *callback)(cl_event, cl_int, void*),
+	void *data)
+{
+	if (m_reads.empty()) { return CL_INVALID_EVENT; }
+	return clSetEventCallback(m_reads.back().event, CL_COMPLETE, 
+		callback, data);
+}
+#endif
+
+/* The C API ---------------------------------------------------------------*/
+
+CVTX_EXPORT int cvtx_test(cvtx_Request *request)
+{
+	return request == NULL || request->test() ? 1 : 0;
+}
+
+CVTX_EXPORT int cvtx_wait(cvtx_Request *request)
+{
+	int good = 0;
+	if (request != NULL) {
+		good = request->wait();
+		delete request;
+	}
+	return good;
+}
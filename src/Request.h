@@ -0,0 +1,88 @@
+#ifndef CVTX_REQUEST_H
+#define CVTX_REQUEST_H
+#include "libcvtx.h"
+/*============================================================================
+Request.h
+
+Completion handles for asynchronous many-to-many evaluations.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <vector>
+
+#include <bsv/bsv.h>
+#ifdef CVTX_USING_OPENCL
+#	include "opencl_acc.h"
+#endif
+
+/* A request is complete once its results are in the user's array. Work
+done on the CPU completes before the request is returned. Work on 
+accelerators completes when the read backs of its results, one per 
+device used, are waited on. */
+struct cvtx_Request {
+public:
+	cvtx_Request();
+	~cvtx_Request();
+
+	/* True if wait() won't block. */
+	bool test();
+	/* Block until the results have been written. Returns 0 on success, 
+	or -1 if an accelerator failed, in which case its results are left 
+	unwritten. */
+	int wait();
+
+#ifdef CVTX_USING_OPENCL
+	/* Read num results from buffer without blocking. They are multiplied
+	by multiplyer and written to result_array when the request is waited 
+	on. Returns the status of the enqueue. */
+	cl_int enqueue_read(
+		cl_command_queue queue,
+		cl_mem buffer,
+		int num,
+		float multiplyer,
+		bsv_V3f *result_array);
+	/* Have callback(event, status, data) called, possibly on another 
+	thread, once the last read enqueued so far is complete. Reads from one
+	in order queue complete in order, so this is once they all are. 
+	Returns the status of setting the callback. */
+	cl_int set_callback(
+		void (CL_CALLBACK *callback)(cl_event, cl_int, void*), 
+		void *data);
+#endif
+
+protected:
+#ifdef CVTX_USING_OPENCL
+	struct PendingRead {
+		cl_event event;
+		std::vector<cl_float3> data;
+		float multiplyer;
+		bsv_V3f *result;
+	};
+	std::vector<PendingRead> m_reads;
+#endif
+
+	/* Not copyable. */
+	cvtx_Request(const cvtx_Request&) = delete;
+	cvtx_Request &operator=(const cvtx_Request&) = delete;
+};
+
+#endif /* CVTX_REQUEST_H */
@@ -1,4 +1,4 @@
-#include "libcvtx.h"
+#include "VortFunc.h"
 /*============================================================================
 VortFunc.c
 
@@ -46,10 +46,9 @@ SOFTWARE.
 #include <stdio.h>
 #include <string.h>
 
-#define SQRTF_2_OVER_PI 0.7978845608028654f
-#define RECIP_SQRTF_2 0.7071067811865475f
+#include "VortFuncPolicy.h"
 
-static float warn_bad_eta_fn(float rho) {
+float vortfunc_no_eta(float rho) {
 	static int warned = 0;
 	assert(0 && "Vortex regularisation function had no viscous method!");
 	if (warned == 0) {
@@ -61,192 +60,72 @@ static float warn_bad_eta_fn(float rho) {
 	return 0.f;
 }
 
-static float g_singular_3D(float rho) {
-	return 1.f;
-}
-
-static float zeta_singular_3D(float rho) {
-	return 0.f;
-}
-
-static void combined_singular_3D(float rho, float* g, float* zeta) {
-	*g = 1.f;
-	*zeta = 0.f;
-	return;
-}
-
-static float g_singular_2D(float rho) {
-	return 1.f;
-}
-
-static float g_winckel_3D(float rho) {
-	float a, b, c, d;
-	assert(rho >= 0 && "Rho should not be -ve");
-	a = (rho * rho) + 2.5f;
-	b = a * rho * (rho * rho);
-	c = (rho * rho) + 1.f;
-	d = b * powf(c, -2.5f);
-	return d;
-}
-
-static float zeta_winckel_3D(float rho) {
-	float a, b, c;
-	assert(rho >= 0 && "Rho should not be -ve");
-	a = rho * rho + 1.f;
-	b = powf(a, -3.5f);
-	c = 7.5f * b;
-	return c;
-}
-
-static float eta_winckel_3D(float rho) {
-	float a, b, c;
-	assert(rho >= 0 && "Rho should not be -ve");
-	a = 52.5f;
-	b = rho * rho + 1.f;
-	c = powf(b, -4.5f);
-	return a * c;
-}
-
-static void combined_winckel_3D(float rho, float* g, float* zeta) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	*g = g_winckel_3D(rho);
-	*zeta = zeta_winckel_3D(rho);
-	return;
-}
-
-static float g_winckel_2D(float rho) {
-	float num, denom;
-	num = (rho * rho) * (rho * rho) + (rho * rho) * 2.f;
-	denom = (rho * rho) * (rho * rho) + 2.f * (rho * rho) + 1.f;
-	return num / denom;
-}
-
-static float eta_winckel_2D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	float a, a2, c;
-	a = rho * rho + 1.f;
-	a2 = 1.f / (a * a);
-	c = 24.f * expf(4.f * a * (a2 * a2));
-	return c * (a2 * a2);
-}
-
-static float g_planetary_3D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	return rho < 1.f ? rho * rho * rho : 1.f;
-}
-
-static float zeta_planetary_3D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	return rho < 1.f ? 3.f : 0.f;
-}
-
-static void combined_planetary_3D(float rho, float* g, float* zeta) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	*g = g_planetary_3D(rho);
-	*zeta = zeta_planetary_3D(rho);
-	return;
-}
-
-static float g_planetary_2D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	return rho < 1.f ? rho * rho : 1.f;
-}
-
-static float g_gaussian_3D(float rho) {
-	/* = 1 to 8sf for rho ~>6. Taylor expansion otherwise */
-	assert(rho >= 0 && "Rho should not be -ve");
-	const float pi = 3.14159265359f;
-	float ret;
-	if (rho > 6.f) {
-		ret = 1.f;
-	}
-	else {
-		/* Approximate erf using Abramowitz and Stegan 1.7.26 */
-		float a1 = 0.254829592f, a2 = -0.284496736f, a3 = 1.421413741f;
-		float a4 = -1.453152027f, a5 = 1.061405429f, p = 0.3275911f;
-		float rho_sr2 = rho * RECIP_SQRTF_2;
-		float t = 1.f / (1.f + p * rho_sr2);
-		float t2 = t * t;	float t3 = t2 * t; float t4 = t2 * t2; float t5 = t3 * t2;
-		float erf = 1.f - (a1 * t + a2 * t2 + a3 * t3 + a4 * t4 + a5 * t5) *
-			expf(-rho_sr2 * rho_sr2);
-		float term2 = rho * SQRTF_2_OVER_PI * expf(-rho_sr2 * rho_sr2);
-		ret = erf - term2;
-	}
+/* The functions themselves are the policies in VortFuncPolicy.h. */
+template<typename Policy>
+static cvtx_VortFunc make_vortfunc(const char *cl_kernel_name_ext)
+{
+	cvtx_VortFunc ret;
+	ret.g_3D = &Policy::g_3D;
+	ret.g_2D = &Policy::g_2D;
+	ret.zeta_3D = &Policy::zeta_3D;
+	ret.eta_3D = &Policy::eta_3D;
+	ret.eta_2D = &Policy::eta_2D;
+	ret.combined_3D = &Policy::combined_3D;
+	strcpy(ret.cl_kernel_name_ext, cl_kernel_name_ext);
 	return ret;
 }
 
-static float zeta_gaussian_3D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	const float pi = 3.14159265359f;
-	return SQRTF_2_OVER_PI * expf(-rho * rho * 0.5f);
+CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_singular(void)
+{
+	/* Not possible for singular vortex to have eta functions. */
+	return make_vortfunc<VortFuncSingular>("singular");
 }
 
-static void combined_gaussian_3D(float rho, float* g, float* zeta) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	*g = g_gaussian_3D(rho);
-	*zeta = zeta_gaussian_3D(rho);
-	return;
+CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_winckelmans(void)
+{
+	return make_vortfunc<VortFuncWinckelmans>("winckelmans");
 }
 
-static float g_gaussian_2D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	return 1.f - expf(-rho * rho * 0.5f);
+CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_planetary(void)
+{
+	/* Not possible for planetary vortex to have eta functions. */
+	return make_vortfunc<VortFuncPlanetary>("planetary");
 }
 
-static float zeta_gaussian_2D(float rho) {
-	assert(rho >= 0 && "Rho should not be -ve");
-	return expf(-rho * rho * 0.5f);
+CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_gaussian(void) {
+	return make_vortfunc<VortFuncGaussian>("gaussian");
 }
 
-CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_singular(void)
+template<typename Policy>
+static bool is_policy_3D(const cvtx_VortFunc *kernel)
 {
-	cvtx_VortFunc ret;
-	ret.g_3D = &g_singular_3D;
-	ret.g_2D = &g_singular_2D;
-	ret.zeta_3D = &zeta_singular_3D;
-	ret.eta_3D = &warn_bad_eta_fn;	/* Not possible for singular vortex */
-	ret.eta_2D = &warn_bad_eta_fn;
-	ret.combined_3D = &combined_singular_3D;
-	strcpy(ret.cl_kernel_name_ext, "singular");
-	return ret;
+	return kernel->g_3D == &Policy::g_3D
+		&& kernel->zeta_3D == &Policy::zeta_3D
+		&& kernel->combined_3D == &Policy::combined_3D
+		&& kernel->eta_3D == &Policy::eta_3D;
 }
 
-CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_winckelmans(void)
+template<typename Policy>
+static bool is_policy_2D(const cvtx_VortFunc *kernel)
 {
-	cvtx_VortFunc ret;
-	ret.g_3D = &g_winckel_3D;
-	ret.g_2D = &g_winckel_2D;
-	ret.zeta_3D = &zeta_winckel_3D;
-	ret.eta_3D = &eta_winckel_3D;
-	ret.eta_2D = &eta_winckel_2D;
-	ret.combined_3D = &combined_winckel_3D;
-	strcpy(ret.cl_kernel_name_ext, "winckelmans");
-	return ret;
+	return kernel->g_2D == &Policy::g_2D
+		&& kernel->eta_2D == &Policy::eta_2D;
 }
 
-CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_planetary(void)
+VortFuncType vortfunc_type_3D(const cvtx_VortFunc *kernel)
 {
-	cvtx_VortFunc ret;
-	ret.g_3D = &g_planetary_3D;
-	ret.g_2D = &g_planetary_2D;
-	ret.zeta_3D = &zeta_planetary_3D;
-	ret.eta_3D = &warn_bad_eta_fn; /* Not possible for planetary vortex */
-	ret.eta_2D = &warn_bad_eta_fn;
-	ret.combined_3D = &combined_planetary_3D;
-	strcpy(ret.cl_kernel_name_ext, "planetary");
-	return ret;
+	if (is_policy_3D<VortFuncSingular>(kernel)) { return VORTFUNC_SINGULAR; }
+	if (is_policy_3D<VortFuncWinckelmans>(kernel)) { return VORTFUNC_WINCKELMANS; }
+	if (is_policy_3D<VortFuncPlanetary>(kernel)) { return VORTFUNC_PLANETARY; }
+	if (is_policy_3D<VortFuncGaussian>(kernel)) { return VORTFUNC_GAUSSIAN; }
+	return VORTFUNC_OTHER;
 }
 
-CVTX_EXPORT const cvtx_VortFunc cvtx_VortFunc_gaussian(void) {
-	cvtx_VortFunc ret;
-	ret.g_3D = &g_gaussian_3D;
-	ret.g_2D = &g_gaussian_2D;
-	ret.zeta_3D = &zeta_gaussian_3D;
-	ret.eta_3D = &zeta_gaussian_3D;
-	ret.eta_2D = &zeta_gaussian_2D;
-	/* See Winckelmans et al., C. R. Physique 6 (2005), around eq (28) */
-	ret.combined_3D = &combined_gaussian_3D;
-	strcpy(ret.cl_kernel_name_ext, "gaussian");
-	return ret;
+VortFuncType vortfunc_type_2D(const cvtx_VortFunc *kernel)
+{
+	if (is_policy_2D<VortFuncSingular>(kernel)) { return VORTFUNC_SINGULAR; }
+	if (is_policy_2D<VortFuncWinckelmans>(kernel)) { return VORTFUNC_WINCKELMANS; }
+	if (is_policy_2D<VortFuncPlanetary>(kernel)) { return VORTFUNC_PLANETARY; }
+	if (is_policy_2D<VortFuncGaussian>(kernel)) { return VORTFUNC_GAUSSIAN; }
+	return VORTFUNC_OTHER;
 }
-
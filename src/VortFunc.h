@@ -0,0 +1,50 @@
+#ifndef CVTX_VORTFUNC_H
+#define CVTX_VORTFUNC_H
+#include "libcvtx.h"
+/*============================================================================
+VortFunc.h
+
+Identification of the built in vortex regularisation functions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/* The regularisations created by cvtx_VortFunc_xxx(). Code specialised for
+these can be used instead of calling through the function pointers. */
+enum VortFuncType {
+	VORTFUNC_OTHER,
+	VORTFUNC_SINGULAR,
+	VORTFUNC_WINCKELMANS,
+	VORTFUNC_PLANETARY,
+	VORTFUNC_GAUSSIAN
+};
+#define CVTX_NUM_VORTFUNC_TYPES 5
+
+/* Which built in 3D regularisation kernel is, or VORTFUNC_OTHER if its
+3D functions are not all those of a single built in regularisation. */
+VortFuncType vortfunc_type_3D(const cvtx_VortFunc *kernel);
+/* As vortfunc_type_3D, for the 2D functions. */
+VortFuncType vortfunc_type_2D(const cvtx_VortFunc *kernel);
+
+/* Used as the eta functions of regularisations that have none. */
+float vortfunc_no_eta(float rho);
+
+#endif /* CVTX_VORTFUNC_H */
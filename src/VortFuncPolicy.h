@@ -0,0 +1,237 @@
+#ifndef CVTX_VORTFUNCPOLICY_H
+#define CVTX_VORTFUNCPOLICY_H
+#include "libcvtx.h"
+/*============================================================================
+VortFuncPolicy.h
+
+The built in vortex regularisation functions as compile time policies.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cmath>
+
+#include "VortFunc.h"
+
+/* Each policy has static member functions with the signatures of the
+cvtx_VortFunc function pointers. The cvtx_VortFunc_xxx() functions point
+at these, and templated kernels call them directly so that they can be
+inlined. VortFuncPointers calls through the pointers of any other
+cvtx_VortFunc, with the same interface. */
+
+#define CVTX_SQRTF_2_OVER_PI 0.7978845608028654f
+#define CVTX_RECIP_SQRTF_2 0.7071067811865475f
+
+struct VortFuncSingular {
+	static float g_3D(float rho) {
+		(void)rho;
+		return 1.f;
+	}
+	static float zeta_3D(float rho) {
+		(void)rho;
+		return 0.f;
+	}
+	static void combined_3D(float rho, float* g, float* zeta) {
+		(void)rho;
+		*g = 1.f;
+		*zeta = 0.f;
+		return;
+	}
+	static float eta_3D(float rho) {
+		return vortfunc_no_eta(rho);
+	}
+	static float g_2D(float rho) {
+		(void)rho;
+		return 1.f;
+	}
+	static float eta_2D(float rho) {
+		return vortfunc_no_eta(rho);
+	}
+};
+
+struct VortFuncWinckelmans {
+	static float g_3D(float rho) {
+		float a, b, c, d;
+		assert(rho >= 0 && "Rho should not be -ve");
+		a = (rho * rho) + 2.5f;
+		b = a * rho * (rho * rho);
+		c = (rho * rho) + 1.f;
+		d = b * powf(c, -2.5f);
+		return d;
+	}
+	static float zeta_3D(float rho) {
+		float a, b, c;
+		assert(rho >= 0 && "Rho should not be -ve");
+		a = rho * rho + 1.f;
+		b = powf(a, -3.5f);
+		c = 7.5f * b;
+		return c;
+	}
+	static void combined_3D(float rho, float* g, float* zeta) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		*g = g_3D(rho);
+		*zeta = zeta_3D(rho);
+		return;
+	}
+	static float eta_3D(float rho) {
+		float a, b, c;
+		assert(rho >= 0 && "Rho should not be -ve");
+		a = 52.5f;
+		b = rho * rho + 1.f;
+		c = powf(b, -4.5f);
+		return a * c;
+	}
+	static float g_2D(float rho) {
+		float num, denom;
+		num = (rho * rho) * (rho * rho) + (rho * rho) * 2.f;
+		denom = (rho * rho) * (rho * rho) + 2.f * (rho * rho) + 1.f;
+		return num / denom;
+	}
+	static float eta_2D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		float a, a2, c;
+		a = rho * rho + 1.f;
+		a2 = 1.f / (a * a);
+		c = 24.f * expf(4.f * a * (a2 * a2));
+		return c * (a2 * a2);
+	}
+};
+
+struct VortFuncPlanetary {
+	static float g_3D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return rho < 1.f ? rho * rho * rho : 1.f;
+	}
+	static float zeta_3D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return rho < 1.f ? 3.f : 0.f;
+	}
+	static void combined_3D(float rho, float* g, float* zeta) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		*g = g_3D(rho);
+		*zeta = zeta_3D(rho);
+		return;
+	}
+	static float eta_3D(float rho) {
+		return vortfunc_no_eta(rho);
+	}
+	static float g_2D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return rho < 1.f ? rho * rho : 1.f;
+	}
+	static float eta_2D(float rho) {
+		return vortfunc_no_eta(rho);
+	}
+};
+
+struct VortFuncGaussian {
+	static float g_3D(float rho) {
+		/* = 1 to 8sf for rho ~>6. Taylor expansion otherwise */
+		assert(rho >= 0 && "Rho should not be -ve");
+		float ret;
+		if (rho > 6.f) {
+			ret = 1.f;
+		}
+		else {
+			/* Approximate erf using Abramowitz and Stegan 1.7.26 */
+			float a1 = 0.254829592f, a2 = -0.284496736f, a3 = 1.421413741f;
+			float a4 = -1.453152027f, a5 = 1.061405429f, p = 0.3275911f;
+			float rho_sr2 = rho * CVTX_RECIP_SQRTF_2;
+			float t = 1.f / (1.f + p * rho_sr2);
+			float t2 = t * t;	float t3 = t2 * t; float t4 = t2 * t2; float t5 = t3 * t2;
+			float erf = 1.f - (a1 * t + a2 * t2 + a3 * t3 + a4 * t4 + a5 * t5) *
+				expf(-rho_sr2 * rho_sr2);
+			float term2 = rho * CVTX_SQRTF_2_OVER_PI * expf(-rho_sr2 * rho_sr2);
+			ret = erf - term2;
+		}
+		return ret;
+	}
+	static float zeta_3D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return CVTX_SQRTF_2_OVER_PI * expf(-rho * rho * 0.5f);
+	}
+	static void combined_3D(float rho, float* g, float* zeta) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		*g = g_3D(rho);
+		*zeta = zeta_3D(rho);
+		return;
+	}
+	/* See Winckelmans et al., C. R. Physique 6 (2005), around eq (28) */
+	static float eta_3D(float rho) {
+		return zeta_3D(rho);
+	}
+	static float g_2D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return 1.f - expf(-rho * rho * 0.5f);
+	}
+	static float eta_2D(float rho) {
+		assert(rho >= 0 && "Rho should not be -ve");
+		return expf(-rho * rho * 0.5f);
+	}
+};
+
+class VortFuncPointers {
+public:
+	VortFuncPointers(const cvtx_VortFunc *kernel) : m_kernel(kernel) {}
+	float g_3D(float rho) const { return m_kernel->g_3D(rho); }
+	float zeta_3D(float rho) const { return m_kernel->zeta_3D(rho); }
+	void combined_3D(float rho, float* g, float* zeta) const {
+		m_kernel->combined_3D(rho, g, zeta);
+	}
+	float eta_3D(float rho) const { return m_kernel->eta_3D(rho); }
+	float g_2D(float rho) const { return m_kernel->g_2D(rho); }
+	float eta_2D(float rho) const { return m_kernel->eta_2D(rho); }
+
+protected:
+	const cvtx_VortFunc *m_kernel;
+};
+
+/* Calls func(policy) with the policy matching kernel's 3D functions. func
+is typically a generic lambda, instantiated for each policy. */
+template<typename Func>
+void with_vortfunc_3D(const cvtx_VortFunc *kernel, Func func)
+{
+	switch (vortfunc_type_3D(kernel)) {
+	case VORTFUNC_SINGULAR: func(VortFuncSingular()); break;
+	case VORTFUNC_WINCKELMANS: func(VortFuncWinckelmans()); break;
+	case VORTFUNC_PLANETARY: func(VortFuncPlanetary()); break;
+	case VORTFUNC_GAUSSIAN: func(VortFuncGaussian()); break;
+	default: func(VortFuncPointers(kernel)); break;
+	}
+	return;
+}
+
+/* As with_vortfunc_3D, for the 2D functions. */
+template<typename Func>
+void with_vortfunc_2D(const cvtx_VortFunc *kernel, Func func)
+{
+	switch (vortfunc_type_2D(kernel)) {
+	case VORTFUNC_SINGULAR: func(VortFuncSingular()); break;
+	case VORTFUNC_WINCKELMANS: func(VortFuncWinckelmans()); break;
+	case VORTFUNC_PLANETARY: func(VortFuncPlanetary()); break;
+	case VORTFUNC_GAUSSIAN: func(VortFuncGaussian()); break;
+	default: func(VortFuncPointers(kernel)); break;
+	}
+	return;
+}
+
+#endif /* CVTX_VORTFUNCPOLICY_H */
@@ -28,17 +28,33 @@ SOFTWARE.
 #include <stdio.h>
 #include <stdlib.h>	/* Required for not CVTX_USING_OPENCL */
 #include <string>
+#include <string.h>
 #include "opencl_acc.h"
+#include "DispatchProfile.h"
+#include "hybrid_P3D.h"
 
 static void cvtx_info_init(void);
 static void cvtx_info_finalise(void);
 static std::string compiler_name_string(void);
+#ifdef CVTX_USING_OPENCL
+static cvtx_AcceleratorInit accelerator_init_mode(void);
+#endif
 
 static std::string cvtx_info_string;
+static int accelerator_init_mode_set = 0;
+static cvtx_AcceleratorInit accelerator_init_mode_value;
 
 CVTX_EXPORT void cvtx_initialise() {
 #ifdef CVTX_USING_OPENCL
-	opencl_init();
+	switch (accelerator_init_mode()) {
+	case CVTX_ACCELERATOR_INIT_BACKGROUND:
+		opencl_load_in_background();
+		break;
+	case CVTX_ACCELERATOR_INIT_ON_DEMAND:
+		break;
+	default:
+		opencl_init();
+	}
 #endif
 	cvtx_info_init();
 }
@@ -57,7 +73,7 @@ CVTX_EXPORT const char* cvtx_information() {
 CVTX_EXPORT int cvtx_num_accelerators() {
 	int num_accelerators = 0;
 #ifdef CVTX_USING_OPENCL
-	assert(opencl_is_init() == 1);
+	opencl_load();
 	num_accelerators = opencl_num_devices();
 #endif
 	return num_accelerators;
@@ -66,6 +82,7 @@ CVTX_EXPORT int cvtx_num_accelerators() {
 CVTX_EXPORT int cvtx_num_enabled_accelerators() {
 	int num = 0;
 #ifdef CVTX_USING_OPENCL
+	opencl_load();
 	num = opencl_num_active_devices();
 #endif
 	return num;
@@ -73,6 +90,7 @@ CVTX_EXPORT int cvtx_num_enabled_accelerators() {
 
 CVTX_EXPORT const char* cvtx_accelerator_name(int accelerator_id) {
 #ifdef CVTX_USING_OPENCL
+	opencl_load();
 	const char *res = opencl_accelerator_name(accelerator_id);
 #else
 	char* res = NULL;
@@ -83,7 +101,7 @@ CVTX_EXPORT const char* cvtx_accelerator_name(int accelerator_id) {
 CVTX_EXPORT int cvtx_accelerator_enabled(int accelerator_id) {
 	int res = -1;
 #ifdef CVTX_USING_OPENCL
-	assert(opencl_is_init() == 1);
+	opencl_load();
 	int pidx, didx;
 	std::tie(pidx, didx) = opencl_deindex_device(accelerator_id);
 	res = opencl_device_in_active_list(pidx, didx);
@@ -93,7 +111,7 @@ CVTX_EXPORT int cvtx_accelerator_enabled(int accelerator_id) {
 
 CVTX_EXPORT void cvtx_accelerator_enable(int accelerator_id) {
 #ifdef CVTX_USING_OPENCL
-	assert(opencl_is_init() == 1);
+	opencl_load();
 	assert(accelerator_id < cvtx_num_accelerators());
 	int pidx, didx;
 	std::tie(pidx, didx) = opencl_deindex_device(accelerator_id);
@@ -106,7 +124,7 @@ CVTX_EXPORT void cvtx_accelerator_enable(int accelerator_id) {
 
 CVTX_EXPORT void cvtx_accelerator_disable(int accelerator_id) {
 #ifdef CVTX_USING_OPENCL
-	assert(opencl_is_init() == 1);
+	opencl_load();
 	assert(accelerator_id < cvtx_num_accelerators());
 	int pidx, didx;
 	std::tie(pidx, didx) = opencl_deindex_device(accelerator_id);
@@ -117,6 +135,56 @@ CVTX_EXPORT void cvtx_accelerator_disable(int accelerator_id) {
 	return;
 }
 
+CVTX_EXPORT void cvtx_accelerator_cache_directory(const char *directory) {
+#ifdef CVTX_USING_OPENCL
+	opencl_set_program_cache_dir(directory);
+#else
+	(void)directory;
+#endif
+	return;
+}
+
+CVTX_EXPORT int cvtx_accelerator_calibrate() {
+	int res = -1;
+#ifdef CVTX_USING_OPENCL
+	res = dispatch_calibrate();
+#endif
+	return res;
+}
+
+CVTX_EXPORT void cvtx_accelerator_share_with_cpu(int share) {
+#ifdef CVTX_USING_OPENCL
+	hybrid_P3D_share_with_cpu(share);
+#else
+	(void)share;
+#endif
+	return;
+}
+
+CVTX_EXPORT void cvtx_accelerator_initialisation(cvtx_AcceleratorInit mode) {
+	accelerator_init_mode_set = 1;
+	accelerator_init_mode_value = mode;
+	return;
+}
+
+#ifdef CVTX_USING_OPENCL
+static cvtx_AcceleratorInit accelerator_init_mode(void)
+{
+	const char *env;
+	if (accelerator_init_mode_set) {
+		return accelerator_init_mode_value;
+	}
+	env = getenv("CVTX_ACCELERATOR_INIT");
+	if (env != NULL && !strcmp(env, "background")) {
+		return CVTX_ACCELERATOR_INIT_BACKGROUND;
+	}
+	if (env != NULL && !strcmp(env, "on_demand")) {
+		return CVTX_ACCELERATOR_INIT_ON_DEMAND;
+	}
+	return CVTX_ACCELERATOR_INIT_IMMEDIATE;
+}
+#endif
+
 void cvtx_info_init(void)
 {
 	const int initial_alloc = 1024 * 16;
@@ -0,0 +1,237 @@
+#include "bh_P3D.h"
+/*============================================================================
+bh_P3D.cpp
+
+Barnes-Hut treecode methods for 3D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "ParticleOcttree.h"
+
+#ifdef CVTX_USING_OPENMP
+#	include <omp.h>
+#endif
+
+#define CVTX_PI_F 3.14159265359f
+/* Maximum number of particles in a leaf of the tree. */
+#define CVTX_BH_LEAF_SIZE 32
+/* Expansions are only used when all the particles of a node are at 
+least this many regularisation radii from the measurement point. */
+#define CVTX_BH_NEAR_FIELD_RHO 5.f
+
+/* Multipole expansion of the vector potential of a node's particles
+about centre. For offsets d of the particles from the centre:
+	m0[a] = sum alpha_a
+	m1[3a + i] = sum alpha_a d_i
+	m2[6a + ij] = sum alpha_a d_i d_j, ij = {xx, xy, xz, yy, yz, zz} */
+typedef struct {
+	bsv_V3f centre;
+	float radius;	/* Max distance from centre to a particle. */
+	float m0[3];
+	float m1[9];
+	float m2[18];
+} BHExpansion;
+
+static void compute_expansion(
+	const P3DView &array_start,
+	const int *perm_begin,
+	const int *perm_end,
+	BHExpansion *expansion)
+{
+	double c[3] = { 0, 0, 0 }, m0[3] = { 0, 0, 0 };
+	double m1[9] = { 0 }, m2[18] = { 0 };
+	double n = (double)(perm_end - perm_begin), radius2 = 0;
+	const int *p;
+	for (p = perm_begin; p != perm_end; ++p) {
+		for (int i = 0; i < 3; ++i) {
+			c[i] += array_start[*p].coord.x[i];
+		}
+	}
+	for (int i = 0; i < 3; ++i) { c[i] /= n; }
+	for (p = perm_begin; p != perm_end; ++p) {
+		const cvtx_P3D *particle = &array_start[*p];
+		double d[3], dd[6];
+		for (int i = 0; i < 3; ++i) { d[i] = particle->coord.x[i] - c[i]; }
+		dd[0] = d[0] * d[0]; dd[1] = d[0] * d[1]; dd[2] = d[0] * d[2];
+		dd[3] = d[1] * d[1]; dd[4] = d[1] * d[2]; dd[5] = d[2] * d[2];
+		radius2 = fmax(radius2, dd[0] + dd[3] + dd[5]);
+		for (int a = 0; a < 3; ++a) {
+			double alpha = particle->vorticity.x[a];
+			m0[a] += alpha;
+			for (int i = 0; i < 3; ++i) { m1[3 * a + i] += alpha * d[i]; }
+			for (int i = 0; i < 6; ++i) { m2[6 * a + i] += alpha * dd[i]; }
+		}
+	}
+	for (int i = 0; i < 3; ++i) {
+		expansion->centre.x[i] = (float)c[i];
+		expansion->m0[i] = (float)m0[i];
+	}
+	for (int i = 0; i < 9; ++i) { expansion->m1[i] = (float)m1[i]; }
+	for (int i = 0; i < 18; ++i) { expansion->m2[i] = (float)m2[i]; }
+	expansion->radius = (float)sqrt(radius2);
+	return;
+}
+
+/* The velocity induced by an expansion at offset R from its centre
+excluding the 1 / 4pi coefficient. The vector potential is 
+	psi_a = m0_a phi - m1_ai d_i phi + 1/2 m2_aij d_i d_j phi
+where phi = 1/|R|, and the velocity is curl(psi). */
+static inline bsv_V3f expansion_vel(
+	const BHExpansion *ex,
+	const float R[3],
+	float recip_r)
+{
+	float ir2 = recip_r * recip_r;
+	float ir3 = ir2 * recip_r, ir5 = ir3 * ir2, ir7 = ir5 * ir2;
+	float J[3][3]; /* J[a][p] = d_p psi_a */
+	for (int a = 0; a < 3; ++a) {
+		const float *m1 = ex->m1 + 3 * a, *m2 = ex->m2 + 6 * a;
+		float m1R = m1[0] * R[0] + m1[1] * R[1] + m1[2] * R[2];
+		float m2R[3] = {
+			m2[0] * R[0] + m2[1] * R[1] + m2[2] * R[2],
+			m2[1] * R[0] + m2[3] * R[1] + m2[4] * R[2],
+			m2[2] * R[0] + m2[4] * R[1] + m2[5] * R[2] };
+		float m2RR = m2R[0] * R[0] + m2R[1] * R[1] + m2R[2] * R[2];
+		float trace = m2[0] + m2[3] + m2[5];
+		float radial = -ex->m0[a] * ir3 - 3.f * m1R * ir5
+			- 7.5f * m2RR * ir7 + 1.5f * trace * ir5;
+		for (int p = 0; p < 3; ++p) {
+			J[a][p] = R[p] * radial + m1[p] * ir3 + 3.f * m2R[p] * ir5;
+		}
+	}
+	bsv_V3f ret = { 
+		J[2][1] - J[1][2], 
+		J[0][2] - J[2][0], 
+		J[1][0] - J[0][1] };
+	return ret;
+}
+
+/* As P3D_vel_inner in P3D.cpp. */
+static inline void direct_vel(
+	const cvtx_P3D *self,
+	const bsv_V3f mes_point,
+	const cvtx_VortFunc *kernel,
+	float recip_reg_rad,
+	double *acc)
+{
+	bsv_V3f rad, num;
+	float radd, cor;
+	if (bsv_V3f_isequal(self->coord, mes_point)) { return; }
+	rad = bsv_V3f_minus(mes_point, self->coord);
+	radd = bsv_V3f_abs(rad);
+	cor = -kernel->g_3D(radd * recip_reg_rad) / (radd * radd * radd);
+	num = bsv_V3f_cross(rad, self->vorticity);
+	acc[0] += num.x[0] * cor;
+	acc[1] += num.x[1] * cor;
+	acc[2] += num.x[2] * cor;
+	return;
+}
+
+int barnes_hut_P3D_M2M_vel(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float theta)
+{
+	assert(num_particles >= 0);
+	assert(num_mes >= 0);
+	if (theta <= 0.f || kernel->g_3D == NULL) { return -1; }
+	if (num_mes == 0) { return 0; }
+	if (num_particles == 0) {
+		for (int i = 0; i < num_mes; ++i) { result_array[i] = bsv_V3f_zero(); }
+		return 0;
+	}
+	float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	float near_field = CVTX_BH_NEAR_FIELD_RHO * fabsf(regularisation_radius);
+
+	std::vector<bsv_V3f> coords(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		coords[i] = array_start[i].coord;
+	}
+	ParticleOcttree tree;
+	tree.build(coords.data(), num_particles, CVTX_BH_LEAF_SIZE);
+	const int *perm = tree.permutation().data();
+	int num_nodes = tree.number_of_nodes();
+	std::vector<BHExpansion> expansions(num_nodes);
+	int n;
+#pragma omp parallel for schedule(dynamic, 16)
+	for (n = 0; n < num_nodes; ++n) {
+		const ParticleOcttreeNode &nd = tree.node(n);
+		compute_expansion(array_start, perm + nd.begin, perm + nd.end,
+			&expansions[n]);
+	}
+
+	long i;
+#pragma omp parallel for schedule(dynamic, 64)
+	for (i = 0; i < num_mes; ++i) {
+		/* Depth first traversal. */
+		std::array<int, 8 * (ParticleOcttree::max_depth + 1)> stack;
+		int stack_size = 1;
+		double acc[3] = { 0, 0, 0 };
+		bsv_V3f mes = mes_start[i];
+		stack[0] = 0;
+		while (stack_size > 0) {
+			int ni = stack[--stack_size];
+			const BHExpansion &ex = expansions[ni];
+			float R[3] = {
+				mes.x[0] - ex.centre.x[0],
+				mes.x[1] - ex.centre.x[1],
+				mes.x[2] - ex.centre.x[2] };
+			float r = sqrtf(R[0] * R[0] + R[1] * R[1] + R[2] * R[2]);
+			if (ex.radius < theta * r && r - ex.radius > near_field) {
+				/* Correct the far field for regularisation at the centre. */
+				float g = kernel->g_3D(r * recip_reg_rad);
+				bsv_V3f v = expansion_vel(&ex, R, 1.f / r);
+				acc[0] += v.x[0] * g;
+				acc[1] += v.x[1] * g;
+				acc[2] += v.x[2] * g;
+				continue;
+			}
+			const ParticleOcttreeNode &nd = tree.node(ni);
+			if (nd.is_leaf()) {
+				for (int j = nd.begin; j < nd.end; ++j) {
+					direct_vel(&array_start[perm[j]], mes, kernel,
+						recip_reg_rad, acc);
+				}
+			}
+			else {
+				for (int c = 0; c < 8; ++c) {
+					if (nd.child_idxs[c] != -1) {
+						stack[stack_size++] = nd.child_idxs[c];
+					}
+				}
+			}
+		}
+		bsv_V3f ret = { (float)acc[0], (float)acc[1], (float)acc[2] };
+		result_array[i] = bsv_V3f_mult(ret, 1.f / (4.f * CVTX_PI_F));
+	}
+	return 0;
+}
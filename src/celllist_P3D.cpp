@@ -0,0 +1,166 @@
+#include "celllist_P3D.h"
+/*============================================================================
+celllist_P3D.cpp
+
+Cell list methods for short ranged 3D vortex particle interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "ParticleCellList.h"
+#include "VortFuncPolicy.h"
+
+#ifdef CVTX_USING_OPENMP
+#	include <omp.h>
+#endif
+
+#define CVTX_PI_F 3.14159265359f
+
+/* The planetary kernel's zeta is zero outside rho = 1, so a smaller
+cutoff gives the same result. */
+static float vort_cutoff(
+	const cvtx_VortFunc *kernel, float regularisation_radius)
+{
+	if (vortfunc_type_3D(kernel) == VORTFUNC_PLANETARY) {
+		return regularisation_radius;
+	}
+	return 5.f * regularisation_radius;
+}
+
+int celllist_P3D_M2M_vort(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	if (num_particles == 0 || !(regularisation_radius > 0.f)) { return -1; }
+	float cutoff = vort_cutoff(kernel, regularisation_radius);
+	float rsigma = 1.f / regularisation_radius;
+
+	std::vector<bsv_V3f> coords(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		coords[i] = array_start[i].coord;
+	}
+	ParticleCellList cells;
+	if (cells.build(coords.data(), num_particles, cutoff) != 0) { return -1; }
+	/* Gather the particles in cell order. */
+	const std::vector<int> &perm = cells.permutation();
+	std::vector<bsv_V3f> pcoords(num_particles), pvorts(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		pcoords[i] = coords[perm[i]];
+		pvorts[i] = array_start[perm[i]].vorticity;
+	}
+
+	float divisor = 4.f * CVTX_PI_F * 
+		regularisation_radius * regularisation_radius * regularisation_radius;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		long i;
+	#pragma omp parallel for schedule(guided)
+		for (i = 0; i < num_mes; ++i) {
+			const bsv_V3f mes_point = mes_start[i];
+			float sx = 0.f, sy = 0.f, sz = 0.f;
+			cells.for_each_neighbour_cell(mes_point, [&](int begin, int end) {
+				for (int j = begin; j < end; ++j) {
+					bsv_V3f rad = bsv_V3f_minus(pcoords[j], mes_point);
+					if (fabsf(rad.x[0]) < cutoff && fabsf(rad.x[1]) < cutoff
+						&& fabsf(rad.x[2]) < cutoff) {
+						float coeff = vortfunc.zeta_3D(
+							bsv_V3f_abs(rad) * rsigma);
+						sx += pvorts[j].x[0] * coeff;
+						sy += pvorts[j].x[1] * coeff;
+						sz += pvorts[j].x[2] * coeff;
+					}
+				}
+			});
+			bsv_V3f sum = { sx, sy, sz };
+			result_array[i] = bsv_V3f_div(sum, divisor);
+		}
+	});
+	return 0;
+}
+
+int celllist_P3D_M2M_visc_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	const P3DView &induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc,
+	float cutoff)
+{
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	if (num_particles == 0 || !(regularisation_radius > 0.f)) { return -1; }
+	float rsigma = 1.f / regularisation_radius;
+	float cutoff2 = cutoff * cutoff;
+
+	std::vector<bsv_V3f> coords(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		coords[i] = array_start[i].coord;
+	}
+	ParticleCellList cells;
+	if (cells.build(coords.data(), num_particles, cutoff) != 0) { return -1; }
+	const std::vector<int> &perm = cells.permutation();
+	std::vector<bsv_V3f> pcoords(num_particles), pvorts(num_particles);
+	std::vector<float> pvols(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		pcoords[i] = coords[perm[i]];
+		pvorts[i] = array_start[perm[i]].vorticity;
+		pvols[i] = array_start[perm[i]].volume;
+	}
+
+	float coeff = 2.f * kinematic_visc * rsigma * rsigma;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		long i;
+	#pragma omp parallel for schedule(guided)
+		for (i = 0; i < num_induced; ++i) {
+			const bsv_V3f coord = induced_start[i].coord;
+			const bsv_V3f vort = induced_start[i].vorticity;
+			const float vol = induced_start[i].volume;
+			double rx = 0, ry = 0, rz = 0;
+			cells.for_each_neighbour_cell(coord, [&](int begin, int end) {
+				for (int j = begin; j < end; ++j) {
+					bsv_V3f rad = bsv_V3f_minus(pcoords[j], coord);
+					float r2 = bsv_V3f_dot(rad, rad);
+					/* Coincident particles don't interact. */
+					if (r2 < cutoff2 && !bsv_V3f_isequal(pcoords[j], coord)) {
+						float eta = vortfunc.eta_3D(sqrtf(r2) * rsigma);
+						rx += (pvorts[j].x[0] * vol - vort.x[0] * pvols[j]) * eta;
+						ry += (pvorts[j].x[1] * vol - vort.x[1] * pvols[j]) * eta;
+						rz += (pvorts[j].x[2] * vol - vort.x[2] * pvols[j]) * eta;
+					}
+				}
+			});
+			bsv_V3f ret = { (float)rx * coeff, (float)ry * coeff, (float)rz * coeff };
+			result_array[i] = ret;
+		}
+	});
+	return 0;
+}
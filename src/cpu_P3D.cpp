@@ -0,0 +1,377 @@
+#include "cpu_P3D.h"
+/*============================================================================
+cpu_P3D.cpp
+
+Brute force CPU evaluation of 3D vortex particle interactions
+over particles stored as a structure of arrays.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cmath>
+
+#include "VortFuncPolicy.h"
+#include "tiled_M2M.h"
+
+#define CVTX_PI_F 3.14159265359f
+
+/* Each function gives tiled_M2M the sum for one measurement point / induced
+particle over a range of the particle arrays. */
+
+template<typename VortFuncT>
+static void cpu_brute_force_P3D_M2M_vel_impl(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius)
+{
+	const int n = particles.size();
+	const float *px = particles.coord(0), *py = particles.coord(1),
+		*pz = particles.coord(2);
+	const float *wx = particles.vorticity(0), *wy = particles.vorticity(1),
+		*wz = particles.vorticity(2);
+	const float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	const float coeff = 1.f / (4.f * CVTX_PI_F);
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		const float mx = mes_start[i].x[0], my = mes_start[i].x[1],
+			mz = mes_start[i].x[2];
+		double rx = 0, ry = 0, rz = 0;
+		for (int j = jb; j < je; ++j) {
+			float dx = mx - px[j], dy = my - py[j], dz = mz - pz[j];
+			if (dx == 0.f && dy == 0.f && dz == 0.f) { continue; }
+			float radd = sqrtf(dx * dx + dy * dy + dz * dz);
+			float cor = -kernel.g_3D(radd * recip_reg_rad);
+			float den = powf(radd, -3);
+			float c = cor * den;
+			rx += (dy * wz[j] - dz * wy[j]) * c;
+			ry += (dz * wx[j] - dx * wz[j]) * c;
+			rz += (dx * wy[j] - dy * wx[j]) * c;
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(num_mes, n, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * coeff;
+		result_array[i].x[1] = (float)acc[1] * coeff;
+		result_array[i].x[2] = (float)acc[2] * coeff;
+	});
+	return;
+}
+
+void cpu_brute_force_P3D_M2M_vel(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P3D_M2M_vel_impl(particles, mes_start, num_mes,
+			result_array, vortfunc, regularisation_radius);
+	});
+	return;
+}
+
+template<typename VortFuncT>
+static void cpu_brute_force_P3D_M2M_dvort_impl(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius)
+{
+	const int n = particles.size();
+	const float *px = particles.coord(0), *py = particles.coord(1),
+		*pz = particles.coord(2);
+	const float *wx = particles.vorticity(0), *wy = particles.vorticity(1),
+		*wz = particles.vorticity(2);
+	const float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	const float t1 = 1.f / (4.f * CVTX_PI_F * 
+		powf(regularisation_radius, 3));
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		const float ix = induced.coord(0)[i], iy = induced.coord(1)[i],
+			iz = induced.coord(2)[i];
+		const float iwx = induced.vorticity(0)[i], 
+			iwy = induced.vorticity(1)[i], iwz = induced.vorticity(2)[i];
+		double rx = 0, ry = 0, rz = 0;
+		for (int j = jb; j < je; ++j) {
+			float dx = ix - px[j], dy = iy - py[j], dz = iz - pz[j];
+			if (dx == 0.f && dy == 0.f && dz == 0.f) { continue; }
+			float g, f;
+			float radd = sqrtf(dx * dx + dy * dy + dz * dz);
+			float rho = radd * recip_reg_rad;
+			kernel.combined_3D(rho, &g, &f);
+			float cx = iwy * wz[j] - iwz * wy[j];
+			float cy = iwz * wx[j] - iwx * wz[j];
+			float cz = iwx * wy[j] - iwy * wx[j];
+			float rho3 = rho * rho * rho;
+			float t21 = g / rho3;
+			float t22 = -1.f / (radd * radd) * ((3 * g) / rho3 - f)
+				* (dx * cx + dy * cy + dz * cz);
+			rx += cx * t21 + dx * t22;
+			ry += cy * t21 + dy * t22;
+			rz += cz * t21 + dz * t22;
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(induced.size(), n, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * t1;
+		result_array[i].x[1] = (float)acc[1] * t1;
+		result_array[i].x[2] = (float)acc[2] * t1;
+	});
+	return;
+}
+
+void cpu_brute_force_P3D_M2M_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P3D_M2M_dvort_impl(particles, induced, result_array,
+			vortfunc, regularisation_radius);
+	});
+	return;
+}
+
+template<typename VortFuncT>
+static void cpu_brute_force_P3D_M2M_visc_dvort_impl(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const int n = particles.size();
+	const float *px = particles.coord(0), *py = particles.coord(1),
+		*pz = particles.coord(2);
+	const float *wx = particles.vorticity(0), *wy = particles.vorticity(1),
+		*wz = particles.vorticity(2);
+	const float *vol = particles.volume();
+	const float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	const float t1 = 2 * kinematic_visc / powf(regularisation_radius, 2);
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		const float ix = induced.coord(0)[i], iy = induced.coord(1)[i],
+			iz = induced.coord(2)[i];
+		const float iwx = induced.vorticity(0)[i], 
+			iwy = induced.vorticity(1)[i], iwz = induced.vorticity(2)[i];
+		const float ivol = induced.volume()[i];
+		double rx = 0, ry = 0, rz = 0;
+		for (int j = jb; j < je; ++j) {
+			float dx = px[j] - ix, dy = py[j] - iy, dz = pz[j] - iz;
+			if (dx == 0.f && dy == 0.f && dz == 0.f) { continue; }
+			float radd = sqrtf(dx * dx + dy * dy + dz * dz);
+			float eta = kernel.eta_3D(radd * recip_reg_rad);
+			rx += (wx[j] * ivol - iwx * vol[j]) * eta;
+			ry += (wy[j] * ivol - iwy * vol[j]) * eta;
+			rz += (wz[j] * ivol - iwz * vol[j]) * eta;
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(induced.size(), n, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * t1;
+		result_array[i].x[1] = (float)acc[1] * t1;
+		result_array[i].x[2] = (float)acc[2] * t1;
+	});
+	return;
+}
+
+void cpu_brute_force_P3D_M2M_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P3D_M2M_visc_dvort_impl(particles, induced,
+			result_array, vortfunc, regularisation_radius, kinematic_visc);
+	});
+	return;
+}
+
+/* As the vel, dvort and visc_dvort functions above, sharing the distance
+and regularisation evaluations. */
+template<typename VortFuncT>
+static void cpu_brute_force_P3D_M2M_vel_dvort_visc_impl(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const VortFuncT &kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const int n = particles.size();
+	const float *px = particles.coord(0), *py = particles.coord(1),
+		*pz = particles.coord(2);
+	const float *wx = particles.vorticity(0), *wy = particles.vorticity(1),
+		*wz = particles.vorticity(2);
+	const float *vol = particles.volume();
+	const float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	const float vel_coeff = 1.f / (4.f * CVTX_PI_F);
+	const float dvort_coeff = 1.f / (4.f * CVTX_PI_F * 
+		powf(regularisation_radius, 3));
+	const float visc_coeff = 2 * kinematic_visc / 
+		powf(regularisation_radius, 2);
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		const float ix = induced.coord(0)[i], iy = induced.coord(1)[i],
+			iz = induced.coord(2)[i];
+		const float iwx = induced.vorticity(0)[i], 
+			iwy = induced.vorticity(1)[i], iwz = induced.vorticity(2)[i];
+		const float ivol = induced.volume()[i];
+		double r[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+		for (int j = jb; j < je; ++j) {
+			float dx = ix - px[j], dy = iy - py[j], dz = iz - pz[j];
+			if (dx == 0.f && dy == 0.f && dz == 0.f) { continue; }
+			float g, f;
+			float radd = sqrtf(dx * dx + dy * dy + dz * dz);
+			float rho = radd * recip_reg_rad;
+			kernel.combined_3D(rho, &g, &f);
+			float eta = kernel.eta_3D(rho);
+			/* Velocity */
+			float c = -g * powf(radd, -3);
+			r[0] += (dy * wz[j] - dz * wy[j]) * c;
+			r[1] += (dz * wx[j] - dx * wz[j]) * c;
+			r[2] += (dx * wy[j] - dy * wx[j]) * c;
+			/* Vortex stretching */
+			float cx = iwy * wz[j] - iwz * wy[j];
+			float cy = iwz * wx[j] - iwx * wz[j];
+			float cz = iwx * wy[j] - iwy * wx[j];
+			float rho3 = rho * rho * rho;
+			float t21 = g / rho3;
+			float t22 = -1.f / (radd * radd) * ((3 * g) / rho3 - f)
+				* (dx * cx + dy * cy + dz * cz);
+			r[3] += cx * t21 + dx * t22;
+			r[4] += cy * t21 + dy * t22;
+			r[5] += cz * t21 + dz * t22;
+			/* Viscous */
+			r[6] += (wx[j] * ivol - iwx * vol[j]) * eta;
+			r[7] += (wy[j] * ivol - iwy * vol[j]) * eta;
+			r[8] += (wz[j] * ivol - iwz * vol[j]) * eta;
+		}
+		for (int k = 0; k < 9; ++k) { acc[k] += r[k]; }
+	};
+	tiled_M2M<9>(induced.size(), n, tile, [&](int i, const double *acc) {
+		for (int k = 0; k < 3; ++k) {
+			vel_result[i].x[k] = (float)acc[k] * vel_coeff;
+			dvort_result[i].x[k] = (float)acc[3 + k] * dvort_coeff;
+			visc_dvort_result[i].x[k] = (float)acc[6 + k] * visc_coeff;
+		}
+	});
+	return;
+}
+
+void cpu_brute_force_P3D_M2M_vel_dvort_visc(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P3D_M2M_vel_dvort_visc_impl(particles, induced,
+			vel_result, dvort_result, visc_dvort_result, vortfunc,
+			regularisation_radius, kinematic_visc);
+	});
+	return;
+}
+
+template<typename VortFuncT>
+static void cpu_brute_force_P3D_M2M_vort_impl(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const VortFuncT &kernel,
+	float regularisation_radius)
+{
+	const int n = particles.size();
+	const float *px = particles.coord(0), *py = particles.coord(1),
+		*pz = particles.coord(2);
+	const float *wx = particles.vorticity(0), *wy = particles.vorticity(1),
+		*wz = particles.vorticity(2);
+	const float cutoff = 5.f * regularisation_radius;
+	const float rsigma = 1.f / regularisation_radius;
+	const float coeff = 1.f / (4.f * CVTX_PI_F * regularisation_radius
+		* regularisation_radius * regularisation_radius);
+	auto tile = [&](int i, int jb, int je, double *acc) {
+		const float mx = mes_start[i].x[0], my = mes_start[i].x[1],
+			mz = mes_start[i].x[2];
+		double rx = 0, ry = 0, rz = 0;
+		for (int j = jb; j < je; ++j) {
+			float dx = px[j] - mx, dy = py[j] - my, dz = pz[j] - mz;
+			if (fabsf(dx) < cutoff && fabsf(dy) < cutoff 
+				&& fabsf(dz) < cutoff) {
+				float radd = sqrtf(dx * dx + dy * dy + dz * dz);
+				float zeta = kernel.zeta_3D(radd * rsigma);
+				rx += wx[j] * zeta;
+				ry += wy[j] * zeta;
+				rz += wz[j] * zeta;
+			}
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(num_mes, n, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * coeff;
+		result_array[i].x[1] = (float)acc[1] * coeff;
+		result_array[i].x[2] = (float)acc[2] * coeff;
+	});
+	return;
+}
+
+void cpu_brute_force_P3D_M2M_vort(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		cpu_brute_force_P3D_M2M_vort_impl(particles, mes_start, num_mes,
+			result_array, vortfunc, regularisation_radius);
+	});
+	return;
+}
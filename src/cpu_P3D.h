@@ -0,0 +1,78 @@
+#ifndef CVTX_CPU_P3D_H
+#define CVTX_CPU_P3D_H
+#include "libcvtx.h"
+/*============================================================================
+cpu_P3D.h
+
+Brute force CPU evaluation of 3D vortex particle interactions
+over particles stored as a structure of arrays.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <bsv/bsv.h>
+
+#include "P3D_soa.h"
+
+void cpu_brute_force_P3D_M2M_vel(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+void cpu_brute_force_P3D_M2M_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+void cpu_brute_force_P3D_M2M_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+/* The velocity at the induced particles, and their dvort and viscous
+dvort, in a single pass. */
+void cpu_brute_force_P3D_M2M_vel_dvort_visc(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+void cpu_brute_force_P3D_M2M_vort(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+#endif /* CVTX_CPU_P3D_H */
@@ -0,0 +1,350 @@
+#include "fmm_P2D.h"
+/*============================================================================
+fmm_P2D.cpp
+
+Fast multipole methods for 2D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "ParticleQuadtree.h"
+
+#ifdef CVTX_USING_OPENMP
+#	include <omp.h>
+#endif
+
+#define CVTX_PI_F 3.14159265359f
+/* Maximum number of particles in a leaf of the trees. */
+#define CVTX_FMM_LEAF_SIZE 32
+/* Expansions are only used between cells separated by at least this
+many regularisation radii, where the regularisation is negligible. */
+#define CVTX_FMM_NEAR_FIELD_RHO 6.f
+#define CVTX_FMM_MAX_ORDER 64
+
+typedef std::complex<double> cplx;
+
+/* With z = x + iy, the conjugate velocity is u - iv = i / 2pi f(z), with
+	f(z) = sum gamma_j / (z - z_j).
+A multipole expansion about centre c of vortices gamma at c + d is
+	f(z) = sum_k M_k / (z - c)^(k+1),	M_k = sum gamma d^k
+and a local expansion about centre c is
+	f(z) = sum_n L_n (z - c)^n. 
+Expansions have order + 1 coefficients. */
+class FmmP2D {
+public:
+	FmmP2D(int order, float theta, float near_field);
+
+	/* Build the trees, expansions and near field lists. */
+	void evaluate(
+		const P2DView &particles, int num_particles,
+		const bsv_V2f *targets, int num_targets);
+
+	int order;
+	float theta, near_field;
+	ParticleQuadtree src_tree, tgt_tree;
+	std::vector<cplx> multipoles, locals;
+	std::vector<float> src_radius, tgt_radius;
+	/* Per target node, the source nodes that interact with it. */
+	std::vector<std::vector<int>> m2l_lists, p2p_lists;
+
+protected:
+	/* Binomial coefficients C(n, k) for n <= 2 * order. */
+	std::vector<double> m_binomials;
+	double binomial(int n, int k) const {
+		return m_binomials[n * (2 * order + 1) + k];
+	}
+
+	void compute_radii(const ParticleQuadtree &tree, const bsv_V2f *points,
+		std::vector<float> &radii);
+	void upward_pass(const P2DView &particles);
+	void build_interaction_lists();
+	void m2l_pass();
+	void downward_pass();
+};
+
+FmmP2D::FmmP2D(int order_, float theta_, float near_field_)
+	: order(order_), theta(theta_), near_field(near_field_)
+{
+	int n_max = 2 * order + 1;
+	m_binomials.assign(n_max * n_max, 0.);
+	for (int n = 0; n < n_max; ++n) {
+		m_binomials[n * n_max] = 1.;
+		for (int k = 1; k <= n; ++k) {
+			m_binomials[n * n_max + k] = m_binomials[(n - 1) * n_max + k - 1]
+				+ m_binomials[(n - 1) * n_max + k];
+		}
+	}
+}
+
+void FmmP2D::evaluate(
+	const P2DView &particles, int num_particles,
+	const bsv_V2f *targets, int num_targets)
+{
+	std::vector<bsv_V2f> coords(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		coords[i] = particles[i].coord;
+	}
+	src_tree.build(coords.data(), num_particles, CVTX_FMM_LEAF_SIZE);
+	tgt_tree.build(targets, num_targets, CVTX_FMM_LEAF_SIZE);
+	compute_radii(src_tree, coords.data(), src_radius);
+	compute_radii(tgt_tree, targets, tgt_radius);
+	upward_pass(particles);
+	build_interaction_lists();
+	m2l_pass();
+	downward_pass();
+	return;
+}
+
+void FmmP2D::compute_radii(
+	const ParticleQuadtree &tree, const bsv_V2f *points,
+	std::vector<float> &radii)
+{
+	int num_nodes = tree.number_of_nodes();
+	const int *perm = tree.permutation().data();
+	radii.resize(num_nodes);
+	int n;
+#pragma omp parallel for schedule(dynamic, 16)
+	for (n = 0; n < num_nodes; ++n) {
+		const ParticleQuadtreeNode &nd = tree.node(n);
+		float r2 = 0.f;
+		for (int i = nd.begin; i < nd.end; ++i) {
+			bsv_V2f d = bsv_V2f_minus(points[perm[i]], nd.centre);
+			r2 = fmaxf(r2, bsv_V2f_dot(d, d));
+		}
+		radii[n] = sqrtf(r2);
+	}
+	return;
+}
+
+void FmmP2D::upward_pass(const P2DView &particles)
+{
+	const int nc = order + 1;
+	const int *perm = src_tree.permutation().data();
+	multipoles.assign((size_t)src_tree.number_of_nodes() * nc, 0.);
+	for (int level = src_tree.number_of_levels() - 1; level >= 0; --level) {
+		const std::vector<int> &nodes = src_tree.level_nodes(level);
+		int num_nodes = (int)nodes.size(), i;
+#pragma omp parallel for schedule(dynamic, 4)
+		for (i = 0; i < num_nodes; ++i) {
+			const ParticleQuadtreeNode &nd = src_tree.node(nodes[i]);
+			cplx *M = multipoles.data() + (size_t)nodes[i] * nc;
+			cplx centre(nd.centre.x[0], nd.centre.x[1]);
+			if (nd.is_leaf()) {		/* P2M */
+				for (int j = nd.begin; j < nd.end; ++j) {
+					const cvtx_P2D *p = &particles[perm[j]];
+					cplx d = cplx(p->coord.x[0], p->coord.x[1]) - centre;
+					cplx dk = p->vorticity;
+					for (int k = 0; k < nc; ++k) {
+						M[k] += dk;
+						dk *= d;
+					}
+				}
+			}
+			else {					/* M2M */
+				std::vector<cplx> spw(nc);
+				for (int ch : nd.child_idxs) {
+					if (ch == -1) { continue; }
+					const ParticleQuadtreeNode &cnd = src_tree.node(ch);
+					const cplx *Mc = multipoles.data() + (size_t)ch * nc;
+					cplx s = cplx(cnd.centre.x[0], cnd.centre.x[1]) - centre;
+					spw[0] = 1.;
+					for (int k = 1; k < nc; ++k) { spw[k] = spw[k - 1] * s; }
+					for (int k = 0; k < nc; ++k) {
+						for (int l = 0; l <= k; ++l) {
+							M[k] += binomial(k, l) * spw[k - l] * Mc[l];
+						}
+					}
+				}
+			}
+		}
+	}
+	return;
+}
+
+void FmmP2D::build_interaction_lists()
+{
+	int num_tgt = tgt_tree.number_of_nodes();
+	m2l_lists.assign(num_tgt, std::vector<int>());
+	p2p_lists.assign(num_tgt, std::vector<int>());
+	if (num_tgt == 0 || src_tree.number_of_nodes() == 0) { return; }
+	/* Dual tree traversal. */
+	std::vector<std::pair<int, int>> stack;
+	stack.emplace_back(0, 0);
+	while (!stack.empty()) {
+		int t = stack.back().first, s = stack.back().second;
+		stack.pop_back();
+		const ParticleQuadtreeNode &tn = tgt_tree.node(t), &sn = src_tree.node(s);
+		float rt = tgt_radius[t], rs = src_radius[s];
+		float dist = bsv_V2f_abs(bsv_V2f_minus(tn.centre, sn.centre));
+		if (rt + rs < theta * dist && dist - rt - rs > near_field) {
+			m2l_lists[t].push_back(s);
+		}
+		else if (tn.is_leaf() && sn.is_leaf()) {
+			p2p_lists[t].push_back(s);
+		}
+		else if (sn.is_leaf() || (!tn.is_leaf() && rt >= rs)) {
+			for (int ch : tn.child_idxs) {
+				if (ch != -1) { stack.emplace_back(ch, s); }
+			}
+		}
+		else {
+			for (int ch : sn.child_idxs) {
+				if (ch != -1) { stack.emplace_back(t, ch); }
+			}
+		}
+	}
+	return;
+}
+
+void FmmP2D::m2l_pass()
+{
+	const int nc = order + 1;
+	int num_tgt = tgt_tree.number_of_nodes(), t;
+	locals.assign((size_t)num_tgt * nc, 0.);
+#pragma omp parallel for schedule(dynamic, 4)
+	for (t = 0; t < num_tgt; ++t) {
+		/* rpw[m] = 1 / R^(m+1) */
+		std::vector<cplx> rpw(2 * nc);
+		cplx *L = locals.data() + (size_t)t * nc;
+		const ParticleQuadtreeNode &tn = tgt_tree.node(t);
+		for (int s : m2l_lists[t]) {
+			const ParticleQuadtreeNode &sn = src_tree.node(s);
+			const cplx *M = multipoles.data() + (size_t)s * nc;
+			cplx R(
+				(double)tn.centre.x[0] - sn.centre.x[0],
+				(double)tn.centre.x[1] - sn.centre.x[1]);
+			cplx recip_R = 1. / R;
+			rpw[0] = recip_R;
+			for (int m = 1; m < 2 * nc; ++m) { rpw[m] = rpw[m - 1] * recip_R; }
+			/* L_n = (-1)^n sum_k C(n+k, k) M_k / R^(n+k+1) */
+			for (int n = 0; n < nc; ++n) {
+				cplx acc = 0.;
+				for (int k = 0; k < nc; ++k) {
+					acc += binomial(n + k, k) * M[k] * rpw[n + k];
+				}
+				L[n] += n % 2 ? -acc : acc;
+			}
+		}
+	}
+	return;
+}
+
+void FmmP2D::downward_pass()
+{
+	const int nc = order + 1;
+	for (int level = 1; level < tgt_tree.number_of_levels(); ++level) {
+		const std::vector<int> &nodes = tgt_tree.level_nodes(level);
+		int num_nodes = (int)nodes.size(), i;
+#pragma omp parallel for schedule(dynamic, 4)
+		for (i = 0; i < num_nodes; ++i) {
+			const ParticleQuadtreeNode &nd = tgt_tree.node(nodes[i]);
+			const ParticleQuadtreeNode &pnd = tgt_tree.node(nd.parent);
+			cplx *L = locals.data() + (size_t)nodes[i] * nc;
+			const cplx *Lp = locals.data() + (size_t)nd.parent * nc;
+			std::vector<cplx> tpw(nc);
+			cplx shift(
+				(double)nd.centre.x[0] - pnd.centre.x[0],
+				(double)nd.centre.x[1] - pnd.centre.x[1]);
+			tpw[0] = 1.;
+			for (int k = 1; k < nc; ++k) { tpw[k] = tpw[k - 1] * shift; }
+			/* L'_m = sum_{n >= m} C(n, m) t^(n-m) L_n */
+			for (int m = 0; m < nc; ++m) {
+				cplx acc = 0.;
+				for (int n = m; n < nc; ++n) {
+					acc += binomial(n, m) * tpw[n - m] * Lp[n];
+				}
+				L[m] += acc;
+			}
+		}
+	}
+	return;
+}
+
+int fmm_P2D_M2M_vel(
+	const P2DView &array_start,
+	const int num_particles,
+	const bsv_V2f *mes_start,
+	const int num_mes,
+	bsv_V2f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	int order,
+	float theta)
+{
+	assert(num_particles >= 0);
+	assert(num_mes >= 0);
+	if (order < 1 || order > CVTX_FMM_MAX_ORDER || theta <= 0.f
+		|| kernel->g_2D == NULL) {
+		return -1;
+	}
+	if (num_mes == 0) { return 0; }
+	if (num_particles == 0) {
+		for (int i = 0; i < num_mes; ++i) { result_array[i] = bsv_V2f_zero(); }
+		return 0;
+	}
+	float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	FmmP2D fmm(order, theta,
+		CVTX_FMM_NEAR_FIELD_RHO * fabsf(regularisation_radius));
+	fmm.evaluate(array_start, num_particles, mes_start, num_mes);
+
+	const int nc = order + 1;
+	const int *src_perm = fmm.src_tree.permutation().data();
+	const int *tgt_perm = fmm.tgt_tree.permutation().data();
+	int num_tgt = fmm.tgt_tree.number_of_nodes(), t;
+	const double recip_2pi = 1. / (2. * CVTX_PI_F);
+#pragma omp parallel for schedule(dynamic, 4)
+	for (t = 0; t < num_tgt; ++t) {
+		const ParticleQuadtreeNode &tn = fmm.tgt_tree.node(t);
+		if (!tn.is_leaf()) { continue; }
+		const cplx *L = fmm.locals.data() + (size_t)t * nc;
+		cplx centre(tn.centre.x[0], tn.centre.x[1]);
+		for (int j = tn.begin; j < tn.end; ++j) {
+			bsv_V2f mes = mes_start[tgt_perm[j]];
+			/* L2P by Horner's method. u - iv = i / 2pi f */
+			cplx w = cplx(mes.x[0], mes.x[1]) - centre, f = 0.;
+			for (int n = nc - 1; n >= 0; --n) { f = f * w + L[n]; }
+			double acc[2] = { -f.imag(), -f.real() };
+			/* P2P: as P2D_vel_inner in P2D.cpp. */
+			for (int s : fmm.p2p_lists[t]) {
+				const ParticleQuadtreeNode &sn = fmm.src_tree.node(s);
+				for (int k = sn.begin; k < sn.end; ++k) {
+					const cvtx_P2D *p = &array_start[src_perm[k]];
+					if (bsv_V2f_isequal(p->coord, mes)) { continue; }
+					bsv_V2f rad = bsv_V2f_minus(mes, p->coord);
+					float radd = bsv_V2f_abs(rad);
+					float g = kernel->g_2D(radd * recip_reg_rad);
+					float c = p->vorticity * g / (radd * radd);
+					acc[0] += rad.x[1] * c;
+					acc[1] -= rad.x[0] * c;
+				}
+			}
+			bsv_V2f ret = { 
+				(float)(acc[0] * recip_2pi), (float)(acc[1] * recip_2pi) };
+			result_array[tgt_perm[j]] = ret;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,595 @@
+#include "fmm_P3D.h"
+/*============================================================================
+fmm_P3D.cpp
+
+Fast multipole methods for 3D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "ParticleOcttree.h"
+
+#ifdef CVTX_USING_OPENMP
+#	include <omp.h>
+#endif
+
+#define CVTX_PI_F 3.14159265359f
+/* Maximum number of particles in a leaf of the trees. */
+#define CVTX_FMM_LEAF_SIZE 32
+/* Expansions are only used between cells separated by at least this
+many regularisation radii, where the regularisation is negligible. */
+#define CVTX_FMM_NEAR_FIELD_RHO 6.f
+#define CVTX_FMM_MAX_ORDER 16
+
+/* Multi-indices k = (kx, ky, kz) with |k| <= order and operator tables
+for cartesian Taylor expansions of phi(R) = 1/|R|. The coefficients
+	b_k(R) = (-1)^|k| / k! d^k phi(R)
+satisfy the recurrence (Lindsay & Krasny 2001)
+	|k| |R|^2 b_k = (2|k| - 1) sum_i R_i b_{k-e_i} - (|k| - 1) sum_i b_{k-2e_i}.
+A multipole expansion about centre c of sources alpha at c + d is
+	psi(x) = sum_k M_k b_k(x - c),	M_k = sum alpha d^k
+and a local expansion about centre c is
+	psi(x) = sum_n L_n (x - c)^n. */
+class FmmTables {
+public:
+	FmmTables(int order);
+
+	/* out[term.out] += term.coeff * in[term.in] * aux[term.aux] */
+	typedef struct { int out, in, aux; double coeff; } Term;
+
+	int order;
+	int num_coeffs;
+	std::vector<std::array<int, 3>> k;
+	std::vector<Term> m2m_terms;	/* M_k += C(k,l) s^(k-l) M'_l */
+	std::vector<Term> m2l_terms;	/* L_n += (-1)^|n| C(k+n,n) b_(k+n) M_k */
+	std::vector<int> m2l_offsets;	/* m2l_terms of out n start at [n] */
+	std::vector<Term> l2l_terms;	/* L'_m += C(n,m) t^(n-m) L_n */
+	std::vector<Term> grad_terms;	/* G_p += n_p z^(n-e_p) L_n */
+	std::vector<Term> hess_terms;	/* H_pq += n_p (n_q - d_pq) z^(n-e_p-e_q) L_n */
+
+	/* out[k] = s^k */
+	void monomials(const double s[3], double *out) const;
+	/* out[k] = b_k(R) */
+	void derivatives(const double R[3], double *out) const;
+	/* Index of a multi-index, or -1 if it has degree > order. */
+	int index(int x, int y, int z) const;
+
+protected:
+	std::vector<int> m_index;
+	std::vector<int> m_degree;
+	std::vector<int> m_mono_dim, m_mono_prev;
+	std::vector<std::array<int, 3>> m_minus_e, m_minus_2e;
+};
+
+static double binomial(int n, int k) {
+	double ret = 1;
+	for (int i = 1; i <= k; ++i) { ret = ret * (n - k + i) / i; }
+	return ret;
+}
+
+FmmTables::FmmTables(int order_)
+	: order(order_), num_coeffs(0)
+{
+	assert(order >= 0);
+	m_index.assign((order + 1) * (order + 1) * (order + 1), -1);
+	for (int deg = 0; deg <= order; ++deg) {
+		for (int x = deg; x >= 0; --x) {
+			for (int y = deg - x; y >= 0; --y) {
+				std::array<int, 3> kk = { x, y, deg - x - y };
+				m_index[(kk[0] * (order + 1) + kk[1]) * (order + 1) + kk[2]] 
+					= (int)k.size();
+				k.push_back(kk);
+				m_degree.push_back(deg);
+			}
+		}
+	}
+	num_coeffs = (int)k.size();
+	for (int i = 0; i < num_coeffs; ++i) {
+		const std::array<int, 3> &ki = k[i];
+		std::array<int, 3> me, m2e;
+		int dim = -1;
+		for (int d = 0; d < 3; ++d) {
+			std::array<int, 3> t = ki;
+			t[d] -= 1;
+			me[d] = t[d] >= 0 ? index(t[0], t[1], t[2]) : -1;
+			t[d] -= 1;
+			m2e[d] = t[d] >= 0 ? index(t[0], t[1], t[2]) : -1;
+			if (dim == -1 && ki[d] > 0) { dim = d; }
+		}
+		m_minus_e.push_back(me);
+		m_minus_2e.push_back(m2e);
+		m_mono_dim.push_back(dim);
+		m_mono_prev.push_back(dim >= 0 ? me[dim] : -1);
+	}
+	m2l_offsets.push_back(0);
+	for (int i = 0; i < num_coeffs; ++i) {
+		const std::array<int, 3> &ki = k[i];
+		for (int j = 0; j < num_coeffs; ++j) {
+			const std::array<int, 3> &kj = k[j];
+			/* M2M and L2L: j <= i componentwise. */
+			if (kj[0] <= ki[0] && kj[1] <= ki[1] && kj[2] <= ki[2]) {
+				double c = binomial(ki[0], kj[0]) * binomial(ki[1], kj[1])
+					* binomial(ki[2], kj[2]);
+				int diff = index(ki[0] - kj[0], ki[1] - kj[1], ki[2] - kj[2]);
+				Term m2m = { i, j, diff, c };
+				m2m_terms.push_back(m2m);
+				Term l2l = { j, i, diff, c };
+				l2l_terms.push_back(l2l);
+			}
+			/* M2L: n = i, k = j. */
+			if (m_degree[i] + m_degree[j] <= order) {
+				double c = binomial(ki[0] + kj[0], ki[0]) 
+					* binomial(ki[1] + kj[1], ki[1])
+					* binomial(ki[2] + kj[2], ki[2]);
+				c = m_degree[i] % 2 ? -c : c;
+				Term m2l = { i, j, 
+					index(ki[0] + kj[0], ki[1] + kj[1], ki[2] + kj[2]), c };
+				m2l_terms.push_back(m2l);
+			}
+		}
+		m2l_offsets.push_back((int)m2l_terms.size());
+		int pq = 0;
+		for (int p = 0; p < 3; ++p) {
+			if (ki[p] > 0) {
+				Term g = { p, i, m_minus_e[i][p], (double)ki[p] };
+				grad_terms.push_back(g);
+			}
+			for (int q = p; q < 3; ++q, ++pq) {
+				std::array<int, 3> t = ki;
+				t[p] -= 1;
+				t[q] -= 1;
+				if (t[0] < 0 || t[1] < 0 || t[2] < 0) { continue; }
+				Term h = { pq, i, index(t[0], t[1], t[2]), 
+					(double)ki[p] * (double)(p == q ? ki[q] - 1 : ki[q]) };
+				hess_terms.push_back(h);
+			}
+		}
+	}
+}
+
+int FmmTables::index(int x, int y, int z) const
+{
+	if (x < 0 || y < 0 || z < 0 || x + y + z > order) { return -1; }
+	return m_index[(x * (order + 1) + y) * (order + 1) + z];
+}
+
+void FmmTables::monomials(const double s[3], double *out) const
+{
+	out[0] = 1.;
+	for (int i = 1; i < num_coeffs; ++i) {
+		out[i] = s[m_mono_dim[i]] * out[m_mono_prev[i]];
+	}
+	return;
+}
+
+void FmmTables::derivatives(const double R[3], double *out) const
+{
+	double r2 = R[0] * R[0] + R[1] * R[1] + R[2] * R[2];
+	double recip_r2 = 1. / r2;
+	out[0] = sqrt(recip_r2);
+	for (int i = 1; i < num_coeffs; ++i) {
+		int deg = m_degree[i];
+		double s1 = 0, s2 = 0;
+		for (int d = 0; d < 3; ++d) {
+			if (m_minus_e[i][d] >= 0) { s1 += R[d] * out[m_minus_e[i][d]]; }
+			if (m_minus_2e[i][d] >= 0) { s2 += out[m_minus_2e[i][d]]; }
+		}
+		out[i] = ((2 * deg - 1) * s1 - (deg - 1) * s2) * recip_r2 / deg;
+	}
+	return;
+}
+
+/* The parts of an FMM evaluation common to all the kernels: the trees, 
+the multipole expansions of the sources and the local expansions of
+the targets. Expansions are of the vector potential psi, with 3 * 
+num_coeffs coefficients per node stored as [3 * coeff + component]. */
+class FmmP3D {
+public:
+	FmmP3D(int order, float theta, float near_field);
+
+	/* Build the trees, expansions and near field lists. */
+	void evaluate(
+		const P3DView &particles, int num_particles,
+		const bsv_V3f *targets, int num_targets);
+
+	FmmTables tables;
+	float theta, near_field;
+	ParticleOcttree src_tree, tgt_tree;
+	std::vector<double> multipoles, locals;
+	std::vector<float> src_radius, tgt_radius;
+	/* Per target node, the source nodes that interact with it. */
+	std::vector<std::vector<int>> m2l_lists, p2p_lists;
+
+protected:
+	void compute_radii(const ParticleOcttree &tree, const bsv_V3f *points, 
+		std::vector<float> &radii);
+	void upward_pass(const P3DView &particles);
+	void build_interaction_lists();
+	void m2l_pass();
+	void downward_pass();
+};
+
+FmmP3D::FmmP3D(int order, float theta_, float near_field_)
+	: tables(order), theta(theta_), near_field(near_field_)
+{
+}
+
+void FmmP3D::evaluate(
+	const P3DView &particles, int num_particles,
+	const bsv_V3f *targets, int num_targets)
+{
+	std::vector<bsv_V3f> coords(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		coords[i] = particles[i].coord;
+	}
+	src_tree.build(coords.data(), num_particles, CVTX_FMM_LEAF_SIZE);
+	tgt_tree.build(targets, num_targets, CVTX_FMM_LEAF_SIZE);
+	compute_radii(src_tree, coords.data(), src_radius);
+	compute_radii(tgt_tree, targets, tgt_radius);
+	upward_pass(particles);
+	build_interaction_lists();
+	m2l_pass();
+	downward_pass();
+	return;
+}
+
+void FmmP3D::compute_radii(
+	const ParticleOcttree &tree, const bsv_V3f *points, 
+	std::vector<float> &radii)
+{
+	int num_nodes = tree.number_of_nodes();
+	const int *perm = tree.permutation().data();
+	radii.resize(num_nodes);
+	int n;
+#pragma omp parallel for schedule(dynamic, 16)
+	for (n = 0; n < num_nodes; ++n) {
+		const ParticleOcttreeNode &nd = tree.node(n);
+		float r2 = 0.f;
+		for (int i = nd.begin; i < nd.end; ++i) {
+			bsv_V3f d = bsv_V3f_minus(points[perm[i]], nd.centre);
+			r2 = fmaxf(r2, bsv_V3f_dot(d, d));
+		}
+		radii[n] = sqrtf(r2);
+	}
+	return;
+}
+
+void FmmP3D::upward_pass(const P3DView &particles)
+{
+	const int nc = tables.num_coeffs;
+	const int *perm = src_tree.permutation().data();
+	multipoles.assign((size_t)src_tree.number_of_nodes() * 3 * nc, 0.);
+	for (int level = src_tree.number_of_levels() - 1; level >= 0; --level) {
+		const std::vector<int> &nodes = src_tree.level_nodes(level);
+		int num_nodes = (int)nodes.size(), i;
+#pragma omp parallel for schedule(dynamic, 4)
+		for (i = 0; i < num_nodes; ++i) {
+			const ParticleOcttreeNode &nd = src_tree.node(nodes[i]);
+			double *M = multipoles.data() + (size_t)nodes[i] * 3 * nc;
+			std::vector<double> pw(nc);
+			if (nd.is_leaf()) {		/* P2M */
+				for (int j = nd.begin; j < nd.end; ++j) {
+					const cvtx_P3D *p = &particles[perm[j]];
+					double d[3];
+					for (int a = 0; a < 3; ++a) {
+						d[a] = (double)p->coord.x[a] - nd.centre.x[a];
+					}
+					tables.monomials(d, pw.data());
+					for (int a = 0; a < 3; ++a) {
+						double alpha = p->vorticity.x[a];
+						for (int c = 0; c < nc; ++c) {
+							M[3 * c + a] += alpha * pw[c];
+						}
+					}
+				}
+			}
+			else {					/* M2M */
+				for (int ch : nd.child_idxs) {
+					if (ch == -1) { continue; }
+					const ParticleOcttreeNode &cnd = src_tree.node(ch);
+					const double *Mc = multipoles.data() + (size_t)ch * 3 * nc;
+					double s[3];
+					for (int a = 0; a < 3; ++a) {
+						s[a] = (double)cnd.centre.x[a] - nd.centre.x[a];
+					}
+					tables.monomials(s, pw.data());
+					for (const FmmTables::Term &t : tables.m2m_terms) {
+						double f = t.coeff * pw[t.aux];
+						for (int a = 0; a < 3; ++a) {
+							M[3 * t.out + a] += f * Mc[3 * t.in + a];
+						}
+					}
+				}
+			}
+		}
+	}
+	return;
+}
+
+void FmmP3D::build_interaction_lists()
+{
+	int num_tgt = tgt_tree.number_of_nodes();
+	m2l_lists.assign(num_tgt, std::vector<int>());
+	p2p_lists.assign(num_tgt, std::vector<int>());
+	if (num_tgt == 0 || src_tree.number_of_nodes() == 0) { return; }
+	/* Dual tree traversal. */
+	std::vector<std::pair<int, int>> stack;
+	stack.emplace_back(0, 0);
+	while (!stack.empty()) {
+		int t = stack.back().first, s = stack.back().second;
+		stack.pop_back();
+		const ParticleOcttreeNode &tn = tgt_tree.node(t), &sn = src_tree.node(s);
+		float rt = tgt_radius[t], rs = src_radius[s];
+		float dist = bsv_V3f_abs(bsv_V3f_minus(tn.centre, sn.centre));
+		if (rt + rs < theta * dist && dist - rt - rs > near_field) {
+			m2l_lists[t].push_back(s);
+		}
+		else if (tn.is_leaf() && sn.is_leaf()) {
+			p2p_lists[t].push_back(s);
+		}
+		else if (sn.is_leaf() || (!tn.is_leaf() && rt >= rs)) {
+			for (int ch : tn.child_idxs) {
+				if (ch != -1) { stack.emplace_back(ch, s); }
+			}
+		}
+		else {
+			for (int ch : sn.child_idxs) {
+				if (ch != -1) { stack.emplace_back(t, ch); }
+			}
+		}
+	}
+	return;
+}
+
+void FmmP3D::m2l_pass()
+{
+	const int nc = tables.num_coeffs;
+	int num_tgt = tgt_tree.number_of_nodes(), t;
+	locals.assign((size_t)num_tgt * 3 * nc, 0.);
+#pragma omp parallel for schedule(dynamic, 4)
+	for (t = 0; t < num_tgt; ++t) {
+		std::vector<double> b(nc);
+		double *L = locals.data() + (size_t)t * 3 * nc;
+		const ParticleOcttreeNode &tn = tgt_tree.node(t);
+		for (int s : m2l_lists[t]) {
+			const ParticleOcttreeNode &sn = src_tree.node(s);
+			const double *M = multipoles.data() + (size_t)s * 3 * nc;
+			double R[3];
+			for (int a = 0; a < 3; ++a) {
+				R[a] = (double)tn.centre.x[a] - sn.centre.x[a];
+			}
+			tables.derivatives(R, b.data());
+			const FmmTables::Term *terms = tables.m2l_terms.data();
+			for (int n = 0; n < nc; ++n) {
+				double l0 = 0, l1 = 0, l2 = 0;
+				int end = tables.m2l_offsets[n + 1];
+				for (int ti = tables.m2l_offsets[n]; ti < end; ++ti) {
+					double f = terms[ti].coeff * b[terms[ti].aux];
+					const double *Mk = M + 3 * terms[ti].in;
+					l0 += f * Mk[0];
+					l1 += f * Mk[1];
+					l2 += f * Mk[2];
+				}
+				L[3 * n] += l0;
+				L[3 * n + 1] += l1;
+				L[3 * n + 2] += l2;
+			}
+		}
+	}
+	return;
+}
+
+void FmmP3D::downward_pass()
+{
+	const int nc = tables.num_coeffs;
+	for (int level = 1; level < tgt_tree.number_of_levels(); ++level) {
+		const std::vector<int> &nodes = tgt_tree.level_nodes(level);
+		int num_nodes = (int)nodes.size(), i;
+#pragma omp parallel for schedule(dynamic, 4)
+		for (i = 0; i < num_nodes; ++i) {
+			const ParticleOcttreeNode &nd = tgt_tree.node(nodes[i]);
+			const ParticleOcttreeNode &pnd = tgt_tree.node(nd.parent);
+			double *L = locals.data() + (size_t)nodes[i] * 3 * nc;
+			const double *Lp = locals.data() + (size_t)nd.parent * 3 * nc;
+			std::vector<double> pw(nc);
+			double s[3];
+			for (int a = 0; a < 3; ++a) {
+				s[a] = (double)nd.centre.x[a] - pnd.centre.x[a];
+			}
+			tables.monomials(s, pw.data());
+			for (const FmmTables::Term &t : tables.l2l_terms) {
+				double f = t.coeff * pw[t.aux];
+				for (int a = 0; a < 3; ++a) {
+					L[3 * t.out + a] += f * Lp[3 * t.in + a];
+				}
+			}
+		}
+	}
+	return;
+}
+
+static bool fmm_arguments_ok(int order, float theta) {
+	return order >= 1 && order <= CVTX_FMM_MAX_ORDER && theta > 0.f;
+}
+
+int fmm_P3D_M2M_vel(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	int order,
+	float theta)
+{
+	assert(num_particles >= 0);
+	assert(num_mes >= 0);
+	if (!fmm_arguments_ok(order, theta) || kernel->g_3D == NULL) { return -1; }
+	if (num_mes == 0) { return 0; }
+	if (num_particles == 0) {
+		for (int i = 0; i < num_mes; ++i) { result_array[i] = bsv_V3f_zero(); }
+		return 0;
+	}
+	float recip_reg_rad = 1.f / fabsf(regularisation_radius);
+	FmmP3D fmm(order, theta, 
+		CVTX_FMM_NEAR_FIELD_RHO * fabsf(regularisation_radius));
+	fmm.evaluate(array_start, num_particles, mes_start, num_mes);
+
+	const FmmTables &tables = fmm.tables;
+	const int nc = tables.num_coeffs;
+	const int *src_perm = fmm.src_tree.permutation().data();
+	const int *tgt_perm = fmm.tgt_tree.permutation().data();
+	int num_tgt = fmm.tgt_tree.number_of_nodes(), t;
+#pragma omp parallel for schedule(dynamic, 4)
+	for (t = 0; t < num_tgt; ++t) {
+		const ParticleOcttreeNode &tn = fmm.tgt_tree.node(t);
+		if (!tn.is_leaf()) { continue; }
+		const double *L = fmm.locals.data() + (size_t)t * 3 * nc;
+		std::vector<double> zpw(nc);
+		for (int j = tn.begin; j < tn.end; ++j) {
+			bsv_V3f mes = mes_start[tgt_perm[j]];
+			double z[3], J[3][3] = { { 0 } }, acc[3] = { 0, 0, 0 };
+			for (int a = 0; a < 3; ++a) {
+				z[a] = (double)mes.x[a] - tn.centre.x[a];
+			}
+			/* L2P: J[a][p] = d_p psi_a, u = curl(psi) */
+			tables.monomials(z, zpw.data());
+			for (const FmmTables::Term &term : tables.grad_terms) {
+				double f = term.coeff * zpw[term.aux];
+				for (int a = 0; a < 3; ++a) {
+					J[a][term.out] += f * L[3 * term.in + a];
+				}
+			}
+			acc[0] = J[2][1] - J[1][2];
+			acc[1] = J[0][2] - J[2][0];
+			acc[2] = J[1][0] - J[0][1];
+			/* P2P: as P3D_vel_inner in P3D.cpp. */
+			for (int s : fmm.p2p_lists[t]) {
+				const ParticleOcttreeNode &sn = fmm.src_tree.node(s);
+				for (int k = sn.begin; k < sn.end; ++k) {
+					const cvtx_P3D *p = &array_start[src_perm[k]];
+					if (bsv_V3f_isequal(p->coord, mes)) { continue; }
+					bsv_V3f rad = bsv_V3f_minus(mes, p->coord);
+					float radd = bsv_V3f_abs(rad);
+					float cor = -kernel->g_3D(radd * recip_reg_rad) 
+						/ (radd * radd * radd);
+					bsv_V3f num = bsv_V3f_cross(rad, p->vorticity);
+					acc[0] += num.x[0] * cor;
+					acc[1] += num.x[1] * cor;
+					acc[2] += num.x[2] * cor;
+				}
+			}
+			bsv_V3f ret = { (float)acc[0], (float)acc[1], (float)acc[2] };
+			result_array[tgt_perm[j]] = bsv_V3f_mult(ret, 1.f / (4.f * CVTX_PI_F));
+		}
+	}
+	return 0;
+}
+
+int fmm_P3D_M2M_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	const P3DView &induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	int order,
+	float theta)
+{
+	assert(num_particles >= 0);
+	assert(num_induced >= 0);
+	if (!fmm_arguments_ok(order, theta) || kernel->combined_3D == NULL) { 
+		return -1; 
+	}
+	if (num_induced == 0) { return 0; }
+	if (num_particles == 0) {
+		for (int i = 0; i < num_induced; ++i) { result_array[i] = bsv_V3f_zero(); }
+		return 0;
+	}
+	std::vector<bsv_V3f> targets(num_induced);
+	for (int i = 0; i < num_induced; ++i) {
+		targets[i] = induced_start[i].coord;
+	}
+	FmmP3D fmm(order, theta,
+		CVTX_FMM_NEAR_FIELD_RHO * fabsf(regularisation_radius));
+	fmm.evaluate(array_start, num_particles, targets.data(), num_induced);
+
+	const FmmTables &tables = fmm.tables;
+	const int nc = tables.num_coeffs;
+	const int *src_perm = fmm.src_tree.permutation().data();
+	const int *tgt_perm = fmm.tgt_tree.permutation().data();
+	int num_tgt = fmm.tgt_tree.number_of_nodes(), t;
+	/* Index into hessian {xx, xy, xz, yy, yz, zz} */
+	static const int hidx[3][3] = { {0, 1, 2}, {1, 3, 4}, {2, 4, 5} };
+#pragma omp parallel for schedule(dynamic, 4)
+	for (t = 0; t < num_tgt; ++t) {
+		const ParticleOcttreeNode &tn = fmm.tgt_tree.node(t);
+		if (!tn.is_leaf()) { continue; }
+		const double *L = fmm.locals.data() + (size_t)t * 3 * nc;
+		std::vector<double> zpw(nc);
+		for (int j = tn.begin; j < tn.end; ++j) {
+			const cvtx_P3D *induced = &induced_start[tgt_perm[j]];
+			double z[3], H[3][6] = { { 0 } }, acc[3] = { 0, 0, 0 };
+			for (int a = 0; a < 3; ++a) {
+				z[a] = (double)induced->coord.x[a] - tn.centre.x[a];
+			}
+			/* L2P: H[c][mk] = d_m d_k psi_c, 
+			dvort_m = -1/4pi eps_kbc omega_b H[c][mk] */
+			tables.monomials(z, zpw.data());
+			for (const FmmTables::Term &term : tables.hess_terms) {
+				double f = term.coeff * zpw[term.aux];
+				for (int c = 0; c < 3; ++c) {
+					H[c][term.out] += f * L[3 * term.in + c];
+				}
+			}
+			const float *om = induced->vorticity.x;
+			for (int m = 0; m < 3; ++m) {
+				double s = 0;
+				for (int k = 0; k < 3; ++k) {
+					int b = (k + 1) % 3, c = (k + 2) % 3;
+					s += om[b] * H[c][hidx[m][k]] - om[c] * H[b][hidx[m][k]];
+				}
+				acc[m] = -s / (4. * CVTX_PI_F);
+			}
+			/* P2P */
+			for (int s : fmm.p2p_lists[t]) {
+				const ParticleOcttreeNode &sn = fmm.src_tree.node(s);
+				for (int k = sn.begin; k < sn.end; ++k) {
+					bsv_V3f dv = cvtx_P3D_S2S_dvort(&array_start[src_perm[k]],
+						induced, kernel, regularisation_radius);
+					acc[0] += dv.x[0];
+					acc[1] += dv.x[1];
+					acc[2] += dv.x[2];
+				}
+			}
+			bsv_V3f ret = { (float)acc[0], (float)acc[1], (float)acc[2] };
+			result_array[tgt_perm[j]] = ret;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef CVTX_FMM_P3D_H
+#define CVTX_FMM_P3D_H
+#include "libcvtx.h"
+/*============================================================================
+fmm_P3D.h
+
+Fast multipole methods for 3D vortex particles.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <bsv/bsv.h>
+
+#include "ParticleView.h"
+
+/* Velocity induced by particles at mes points using a cartesian fast 
+multipole method of given expansion order. Cells are well separated 
+if (r_a + r_b) < theta * distance. Returns 0 on success. */
+int fmm_P3D_M2M_vel(
+	const P3DView &array_start,
+	const int num_particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	int order,
+	float theta);
+
+/* Vortex stretching on induced particles using a cartesian fast
+multipole method. As fmm_P3D_M2M_vel. */
+int fmm_P3D_M2M_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	const P3DView &induced_start,
+	const int num_induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	int order,
+	float theta);
+
+#endif /* CVTX_FMM_P3D_H */
@@ -0,0 +1,194 @@
+#include "hybrid_P3D.h"
+/*============================================================================
+hybrid_P3D.cpp
+
+Splits 3D vortex particle M2M work between the accelerators and the CPU.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifdef CVTX_USING_OPENCL
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "DispatchProfile.h"
+#include "Request.h"
+#include "cpu_P3D.h"
+#include "ocl_P3D.h"
+#include "simd_P3D.h"
+
+/* Interactions per second measured on the CPU and the accelerators for 
+one kind of interaction, or 0 before the first measurement. */
+struct HybridRates {
+	double cpu;
+	double accelerator;
+};
+
+static int share_with_cpu_set = 0;
+static int share_with_cpu_value = 0;
+/* The rates by function and regularisation, since the cost per pair 
+differs between regularisations. Concurrent calls share them. */
+static struct {
+	std::mutex mutex;
+	HybridRates rates[DISPATCH_NUM_FUNCTIONS][CVTX_NUM_VORTFUNC_TYPES];
+} hybrid;
+
+void hybrid_P3D_share_with_cpu(int share)
+{
+	share_with_cpu_set = 1;
+	share_with_cpu_value = share;
+}
+
+static bool share_with_cpu()
+{
+	const char *env;
+	if (share_with_cpu_set) {
+		return share_with_cpu_value != 0;
+	}
+	env = getenv("CVTX_ACCELERATOR_SHARE_WITH_CPU");
+	return env != NULL && !strcmp(env, "1");
+}
+
+/* The fraction of the work the CPU should do to finish with the 
+accelerators. Before both are measured, guess the CPU is a quarter 
+as fast. Each always gets a little so that both stay measured. */
+static double cpu_fraction(const HybridRates &rates)
+{
+	double fraction = 0.2;
+	if (rates.cpu > 0. && rates.accelerator > 0.) {
+		fraction = rates.cpu / (rates.cpu + rates.accelerator);
+	}
+	return std::min(std::max(fraction, 0.02), 0.98);
+}
+
+static void record_rate(double &rate, double interactions, double seconds)
+{
+	double measured;
+	if (seconds <= 0.) { return; }
+	measured = interactions / seconds;
+	rate = rate == 0. ? measured : 0.5 * (rate + measured);
+}
+
+/* accelerator(count, request) enqueues the first count of num_induced 
+on the accelerators. cpu(first, count) computes the rest. The accelerators'
+results are waited for on another thread so that the time they finish is 
+known even if the CPU is still busy. If the accelerators fail after the 
+work is enqueued the CPU computes their part too. */
+template<typename AccT, typename CpuT>
+static int hybrid_split(
+	DispatchFunction function,
+	VortFuncType regularisation,
+	int num_particles,
+	int num_induced,
+	AccT accelerator,
+	CpuT cpu)
+{
+	typedef std::chrono::steady_clock clock;
+	int num_cpu, num_acc, acc_good;
+	cvtx_Request request;
+	std::chrono::duration<double> acc_time, cpu_time;
+	HybridRates &rates = hybrid.rates[function][regularisation];
+	double fraction;
+
+	if (!share_with_cpu() || dispatch_calibrating()) { return -1; }
+	{
+		std::lock_guard<std::mutex> lock(hybrid.mutex);
+		fraction = cpu_fraction(rates);
+	}
+	num_cpu = (int)(num_induced * fraction);
+	num_acc = num_induced - num_cpu;
+	if (num_cpu == 0 || num_acc == 0) { return -1; }
+
+	clock::time_point acc_start = clock::now();
+	if (accelerator(num_acc, &request) != 0) { return -1; }
+	std::thread waiter([&]() {
+		acc_good = request.wait();
+		acc_time = clock::now() - acc_start;
+	});
+	clock::time_point cpu_start = clock::now();
+	cpu(num_acc, num_cpu);
+	cpu_time = clock::now() - cpu_start;
+	waiter.join();
+	if (acc_good != 0) {
+		cpu(0, num_acc);
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(hybrid.mutex);
+	record_rate(rates.cpu, (double) num_particles * num_cpu, 
+		cpu_time.count());
+	record_rate(rates.accelerator, (double) num_particles * num_acc, 
+		acc_time.count());
+	return 0;
+}
+
+int hybrid_P3D_M2M_vel(
+	const P3DArray &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	return hybrid_split(DISPATCH_P3D_M2M_VEL, vortfunc_type_3D(kernel),
+		particles.size(), num_mes,
+		[&](int count, cvtx_Request *request) {
+		return opencl_brute_force_P3D_M2M_vel(particles, mes_start, count,
+			result_array, kernel, regularisation_radius, request);
+	},
+		[&](int first, int count) {
+		if (simd_P3D_M2M_vel(particles.soa(), mes_start + first, count,
+				result_array + first, kernel, regularisation_radius) != 0) {
+			cpu_brute_force_P3D_M2M_vel(particles.soa(), mes_start + first,
+				count, result_array + first, kernel, regularisation_radius);
+		}
+	});
+}
+
+int hybrid_P3D_M2M_dvort(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	return hybrid_split(DISPATCH_P3D_M2M_DVORT, vortfunc_type_3D(kernel),
+		particles.size(), induced.size(),
+		[&](int count, cvtx_Request *request) {
+		/* The leading count, so induced's accelerator copy can be used. */
+		return opencl_brute_force_P3D_M2M_dvort(particles, induced, count,
+			result_array, kernel, regularisation_radius, request);
+	},
+		[&](int first, int count) {
+		P3DArray part(induced.view().offset(first), count);
+		if (simd_P3D_M2M_dvort(particles.soa(), part.soa(), 
+				result_array + first, kernel, regularisation_radius) != 0) {
+			cpu_brute_force_P3D_M2M_dvort(particles.soa(), part.soa(),
+				result_array + first, kernel, regularisation_radius);
+		}
+	});
+}
+
+#endif /* CVTX_USING_OPENCL */
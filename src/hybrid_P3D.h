@@ -0,0 +1,59 @@
+#ifndef CVTX_HYBRID_P3D_H
+#define CVTX_HYBRID_P3D_H
+#include "libcvtx.h"
+/*============================================================================
+hybrid_P3D.h
+
+Splits 3D vortex particle M2M work between the accelerators and the CPU.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#ifdef CVTX_USING_OPENCL
+#include <bsv/bsv.h>
+
+#include "P3D_soa.h"
+
+/* Set whether the CPU takes a share of the work given to the 
+accelerators. Until set, CVTX_ACCELERATOR_SHARE_WITH_CPU=1 enables it. */
+void hybrid_P3D_share_with_cpu(int share);
+
+/* Run part of the interaction on the enabled accelerators and the rest 
+on the CPU at the same time. The CPU's share adapts to the speeds measured
+in previous calls with the same regularisation. These return 0 on success, or nonzero if sharing is 
+disabled or no accelerator could be used, in which case nothing is 
+computed. */
+int hybrid_P3D_M2M_vel(
+	const P3DArray &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+int hybrid_P3D_M2M_dvort(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+#endif /* CVTX_USING_OPENCL */
+#endif /* CVTX_HYBRID_P3D_H */
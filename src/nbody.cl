@@ -35,23 +35,31 @@ Definitions for the repeated body of kernels
 "#define SQRT_2_OVER_PI 0.7978845608028654f							\n"
 "#define ONE_OVER_SQRT_TWO 0.7071067811865475f						\n"
 
+/* The 3D kernels take particles as float4s so that each is a single
+16 byte load: coordinates with the volume in w, and vorticity with w 
+unused. They have a workgroup of CVTX_CL_WORKGROUP_SIZE items per
+induced particle / measurement point. Each item sums over every
+CVTX_CL_WORKGROUP_SIZE-th inducing particle in the loop opened by _START
+and closed by _END, then the items' sums are reduced. */
 "#define CVTX_P3D_VEL_START 										\\\n"
 "(																	\\\n"
-"	__global float3* particle_locs,									\\\n"
-"	__global float3* particle_vorts,								\\\n"
+"	__global float4* particle_locs,	/* xyz and volume */			\\\n"
+"	__global float4* particle_vorts,								\\\n"
 "	float    recip_reg_rad,								            \\\n"
 "	__global float3* mes_locs,										\\\n"
-"	__global float3* results)										\\\n"
+"	__global float3* results,										\\\n"
+"	uint num_particles)												\\\n"
 "{																	\\\n"
-"	float3 rad, num, ret;											\\\n"
+"	float3 rad, num, ret, acc;										\\\n"
 "	float cor, den, rho, g, radd;									\\\n"
 "	__local float3 reduction_workspace[CVTX_CL_WORKGROUP_SIZE];		\\\n"
 "	/* Particle idx, mes_pnt idx and local work item idx */			\\\n"
-"	uint pidx, midx, widx, loop_idx;								\\\n"
+"	uint pidx, midx, widx;											\\\n"
 "	midx = get_global_id(1);										\\\n"
 "	widx = get_local_id(0);											\\\n"
-"	pidx = widx;													\\\n"
-"	rad = mes_locs[midx] - particle_locs[pidx];						\\\n"
+"	acc = (float3)(0.f, 0.f, 0.f);									\\\n"
+"	for (pidx = widx; pidx < num_particles; pidx += CVTX_CL_WORKGROUP_SIZE) {\\\n"
+"	rad = mes_locs[midx] - particle_locs[pidx].xyz;					\\\n"
 "	radd = length(rad);												\\\n"
 "	rho = radd * recip_reg_rad;    									\n"
 
@@ -60,43 +68,47 @@ Definitions for the repeated body of kernels
 "#define CVTX_P3D_VEL_END 											\\\n"
 "	cor = - g;	/*1/4pi term is done by host. */					\\\n"
 "	den = pown(radd, 3);											\\\n"
-"	num = cross(rad, particle_vorts[pidx]);							\\\n"
+"	num = cross(rad, particle_vorts[pidx].xyz);						\\\n"
 "	ret = num * (cor / den);										\\\n"
 "	ret = isnormal(ret) && radd != 0.f ? ret : (float3)(0.f, 0.f, 0.f);\\\n"
-"	reduction_workspace[widx] = ret;								\\\n"
+"	acc += ret;														\\\n"
+"	}																\\\n"
+"	reduction_workspace[widx] = acc;								\\\n"
 "	local_workspace_float3_reduce(reduction_workspace);				\\\n"
 "	barrier(CLK_LOCAL_MEM_FENCE);									\\\n"
 "	if( widx == 0 ){												\\\n"
-"		results[midx] = reduction_workspace[0] + results[midx];		\\\n"
+"		results[midx] = reduction_workspace[0];						\\\n"
 "	}																\\\n"
 "	return;															\\\n"
 "}																	\n"
 
 "#define CVTX_P3D_DVORT_START										\\\n"
 "(																	\\\n"
-"	__global float3* particle_locs,									\\\n"
-"	__global float3* particle_vorts,								\\\n"
+"	__global float4* particle_locs,	/* xyz and volume */			\\\n"
+"	__global float4* particle_vorts,								\\\n"
 "	float    recip_reg_rad,			        						\\\n"
-"	__global float3* induced_locs,									\\\n"
-"	__global float3* induced_vorts,									\\\n"
-"	__global float3* results)										\\\n"
+"	__global float4* induced_locs,									\\\n"
+"	__global float4* induced_vorts,									\\\n"
+"	__global float3* results,										\\\n"
+"	uint num_particles)												\\\n"
 "{																	\\\n"
-"	float3 ret, rad, cross_om, t21, t21n, t22;						\\\n"
+"	float3 ret, rad, cross_om, t21, t21n, t22, acc;					\\\n"
 "	float g, f, radd, rho, recip_rho3, t221, t222, t223;			\\\n"
 "	__local float3 reduction_workspace[CVTX_CL_WORKGROUP_SIZE];		\\\n"
 "	/* self (inducing particle) index, induced particle index */	\\\n"
 "	uint sidx, indidx, widx;										\\\n"
 "	indidx = get_global_id(1);										\\\n"
 "	widx = get_local_id(0);											\\\n"
-"	sidx = widx;													\\\n"
-"	rad = induced_locs[indidx] - particle_locs[sidx];				\\\n"
+"	acc = (float3)(0.f, 0.f, 0.f);									\\\n"
+"	for (sidx = widx; sidx < num_particles; sidx += CVTX_CL_WORKGROUP_SIZE) {\\\n"
+"	rad = induced_locs[indidx].xyz - particle_locs[sidx].xyz;		\\\n"
 "	radd = length(rad);												\\\n"
 "	rho = radd * recip_reg_rad;  									\n"
 
 /* FILL in f & g calc here! */
 
 "#define CVTX_P3D_DVORT_END											\\\n"
-"	cross_om = cross(induced_vorts[indidx], particle_vorts[sidx]);	\\\n"
+"	cross_om = cross(induced_vorts[indidx].xyz, particle_vorts[sidx].xyz);\\\n"
 "	t21n = cross_om * g;											\\\n"
 "	recip_rho3 = 1.f/(rho * rho * rho);								\\\n"
 "	t21 = t21n * recip_rho3;										\\\n"
@@ -105,11 +117,13 @@ Definitions for the repeated body of kernels
 "	t223 = dot(rad, cross_om);										\\\n"
 "	ret = fma(t221 * t222 * t223, rad, t21); /* 1/(4 pi reg_dist^3) is host side */\\\n"
 "	ret = isnormal(ret) && radd > 0.f ? ret : (float3)(0.f, 0.f, 0.f);\\\n"
-"	reduction_workspace[widx] = ret;								\\\n"
+"	acc += ret;														\\\n"
+"	}																\\\n"
+"	reduction_workspace[widx] = acc;								\\\n"
 "	local_workspace_float3_reduce(reduction_workspace);				\\\n"
 "	barrier(CLK_LOCAL_MEM_FENCE);									\\\n"
 "	if( widx == 0 ){												\\\n"
-"		results[indidx] = reduction_workspace[0] + results[indidx];	\\\n"
+"		results[indidx] = reduction_workspace[0];					\\\n"
 "	}																\\\n"
 "	return;															\\\n"
 "}																	\n"
@@ -120,30 +134,30 @@ Definitions for the repeated body of kernels
 
 "#define CVTX_P3D_VISC_DVORT_START									\\\n"
 "(																	\\\n"
-"	__global float3* particle_locs,									\\\n"
-"	__global float3* particle_vorts,								\\\n"
-"	__global float* particle_vols,									\\\n"
-"	__global float3* induced_locs,									\\\n"
-"	__global float3* induced_vorts,									\\\n"
-"	__global float* induced_vols,									\\\n"
+"	__global float4* particle_locs,	/* xyz and volume */			\\\n"
+"	__global float4* particle_vorts,								\\\n"
+"	__global float4* induced_locs,									\\\n"
+"	__global float4* induced_vorts,									\\\n"
 "	__global float3* results,										\\\n"
 "	float regularisation_dist,										\\\n"
-"	float kinematic_visc)											\\\n"
+"	float kinematic_visc,											\\\n"
+"	uint num_particles)												\\\n"
 "{																	\\\n"
-"	float3 ret, rad, t211, t212, t21, t2;							\\\n"
+"	float3 ret, rad, t211, t212, t21, t2, acc;						\\\n"
 "	float radd, rho, t1, eta;										\\\n"
 "	__local float3 reduction_workspace[CVTX_CL_WORKGROUP_SIZE];		\\\n"
 "	/* self (inducing particle) index, induced particle index */	\\\n"
-"	uint sidx, indidx, widx, loop_idx;								\\\n"
-"	sidx = get_global_id(0);										\\\n"
+"	uint sidx, indidx, widx;										\\\n"
 "	indidx = get_global_id(1);										\\\n"
 "	widx = get_local_id(0);											\\\n"
-"	rad = particle_locs[sidx] - induced_locs[indidx];				\\\n"
+"	t1 =  2 * kinematic_visc / pown(regularisation_dist, 2);		\\\n"
+"	acc = (float3)(0.f, 0.f, 0.f);									\\\n"
+"	for (sidx = widx; sidx < num_particles; sidx += CVTX_CL_WORKGROUP_SIZE) {\\\n"
+"	rad = particle_locs[sidx].xyz - induced_locs[indidx].xyz;		\\\n"
 "	radd = length(rad);												\\\n"
 "	rho = radd / regularisation_dist;								\\\n"
-"	t1 =  2 * kinematic_visc / pown(regularisation_dist, 2);		\\\n"
-"	t211 = particle_vorts[sidx] * induced_vols[indidx];  			\\\n"
-"	t212 = -1 * induced_vorts[indidx] * particle_vols[sidx];		\\\n"
+"	t211 = particle_vorts[sidx].xyz * induced_locs[indidx].w;		\\\n"
+"	t212 = -1 * induced_vorts[indidx].xyz * particle_locs[sidx].w;	\\\n"
 "	t21 = t211 + t212;												\n"
 
 /* ETA FUNCTION function!  here */
@@ -152,32 +166,95 @@ Definitions for the repeated body of kernels
 "	t2 = t21 * eta;													\\\n"
 "	ret = t2 * t1;													\\\n"
 "	ret = isnormal(ret) && radd != 0.f ? ret : (float3)(0.f, 0.f, 0.f);\\\n"
-"	reduction_workspace[widx] = convert_float3(ret);				\\\n"
+"	acc += ret;														\\\n"
+"	}																\\\n"
+"	reduction_workspace[widx] = acc;								\\\n"
 "	local_workspace_float3_reduce(reduction_workspace);				\\\n"
 "	barrier(CLK_LOCAL_MEM_FENCE);									\\\n"
 "	if( widx == 0 ){												\\\n"
-"		results[indidx] = reduction_workspace[0] + results[indidx];	\\\n"
+"		results[indidx] = reduction_workspace[0];					\\\n"
+"	}																\\\n"
+"	return;															\\\n"
+"}																	\n"
+
+"#define CVTX_P3D_VEL_DVORT_VISC_START								\\\n"
+"(																	\\\n"
+"	__global float4* particle_locs,	/* xyz and volume */			\\\n"
+"	__global float4* particle_vorts,								\\\n"
+"	__global float4* induced_locs,									\\\n"
+"	__global float4* induced_vorts,									\\\n"
+"	__global float3* vel_results,									\\\n"
+"	__global float3* dvort_results,									\\\n"
+"	__global float3* visc_results,									\\\n"
+"	float recip_reg_rad,											\\\n"
+"	uint num_particles)												\\\n"
+"{																	\\\n"
+"	float3 rad, cross_om, vel, dvort, visc, t21;					\\\n"
+"	float3 vel_acc, dvort_acc, visc_acc;							\\\n"
+"	float g, f, eta, radd, rho, recip_rho3, t22;					\\\n"
+"	__local float3 vel_workspace[CVTX_CL_WORKGROUP_SIZE];			\\\n"
+"	__local float3 dvort_workspace[CVTX_CL_WORKGROUP_SIZE];			\\\n"
+"	__local float3 visc_workspace[CVTX_CL_WORKGROUP_SIZE];			\\\n"
+"	/* self (inducing particle) index, induced particle index */	\\\n"
+"	uint sidx, indidx, widx;										\\\n"
+"	indidx = get_global_id(1);										\\\n"
+"	widx = get_local_id(0);											\\\n"
+"	vel_acc = dvort_acc = visc_acc = (float3)(0.f, 0.f, 0.f);		\\\n"
+"	for (sidx = widx; sidx < num_particles; sidx += CVTX_CL_WORKGROUP_SIZE) {\\\n"
+"	rad = induced_locs[indidx].xyz - particle_locs[sidx].xyz;		\\\n"
+"	radd = length(rad);												\\\n"
+"	rho = radd * recip_reg_rad;  									\n"
+
+/* FILL in g, f & eta calc here! */
+
+/* The constant factors of each are applied by the host. */
+"#define CVTX_P3D_VEL_DVORT_VISC_END									\\\n"
+"	recip_rho3 = 1.f / (rho * rho * rho);							\\\n"
+"	vel = cross(rad, particle_vorts[sidx].xyz) * (-g * recip_rho3);	\\\n"
+"	cross_om = cross(induced_vorts[indidx].xyz, particle_vorts[sidx].xyz);\\\n"
+"	t21 = cross_om * (g * recip_rho3);								\\\n"
+"	t22 = -(3 * g * recip_rho3 - f) * dot(rad, cross_om) / (radd * radd);\\\n"
+"	dvort = fma(t22, rad, t21);										\\\n"
+"	visc = (particle_vorts[sidx].xyz * induced_locs[indidx].w		\\\n"
+"		- induced_vorts[indidx].xyz * particle_locs[sidx].w) * eta;	\\\n"
+"	vel_acc += isnormal(vel) && radd > 0.f ? vel : (float3)(0.f, 0.f, 0.f);\\\n"
+"	dvort_acc += isnormal(dvort) && radd > 0.f ? dvort : (float3)(0.f, 0.f, 0.f);\\\n"
+"	visc_acc += isnormal(visc) && radd > 0.f ? visc : (float3)(0.f, 0.f, 0.f);\\\n"
+"	}																\\\n"
+"	vel_workspace[widx] = vel_acc;									\\\n"
+"	dvort_workspace[widx] = dvort_acc;								\\\n"
+"	visc_workspace[widx] = visc_acc;								\\\n"
+"	local_workspace_float3_reduce(vel_workspace);					\\\n"
+"	local_workspace_float3_reduce(dvort_workspace);					\\\n"
+"	local_workspace_float3_reduce(visc_workspace);					\\\n"
+"	barrier(CLK_LOCAL_MEM_FENCE);									\\\n"
+"	if( widx == 0 ){												\\\n"
+"		vel_results[indidx] = vel_workspace[0];						\\\n"
+"		dvort_results[indidx] = dvort_workspace[0];					\\\n"
+"		visc_results[indidx] = visc_workspace[0];					\\\n"
 "	}																\\\n"
 "	return;															\\\n"
 "}																	\n"
 
 "#define CVTX_P3D_VORT_START 										\\\n"
 "(																	\\\n"
-"	__global float3* particle_locs,									\\\n"
-"	__global float3* particle_vorts,								\\\n"
+"	__global float4* particle_locs,	/* xyz and volume */			\\\n"
+"	__global float4* particle_vorts,								\\\n"
 "	float    recip_reg_rad,								            \\\n"
 "	__global float3* mes_locs,										\\\n"
-"	__global float3* results)										\\\n"
+"	__global float3* results,										\\\n"
+"	uint num_particles)												\\\n"
 "{																	\\\n"
-"	float3 rad, ret;												\\\n"
+"	float3 rad, ret, acc;											\\\n"
 "	float radd, rho, zeta;											\\\n"
 "	__local float3 reduction_workspace[CVTX_CL_WORKGROUP_SIZE];		\\\n"
 "	/* Particle idx, mes_pnt idx and local work item idx */			\\\n"
-"	uint pidx, midx, widx, loop_idx;								\\\n"
+"	uint pidx, midx, widx;											\\\n"
 "	midx = get_global_id(1);										\\\n"
 "	widx = get_local_id(0);											\\\n"
-"	pidx = widx;													\\\n"
-"	rad = mes_locs[midx] - particle_locs[pidx];						\\\n"
+"	acc = (float3)(0.f, 0.f, 0.f);									\\\n"
+"	for (pidx = widx; pidx < num_particles; pidx += CVTX_CL_WORKGROUP_SIZE) {\\\n"
+"	rad = mes_locs[midx] - particle_locs[pidx].xyz;					\\\n"
 "	radd = length(rad);												\\\n"
 "	rho = radd * recip_reg_rad;    									\n"
 
@@ -185,13 +262,15 @@ Definitions for the repeated body of kernels
 
 "#define CVTX_P3D_VORT_END 											\\\n"
 "	/* 1/(4pi sigma^3) term is done by host. */						\\\n"
-"	ret = zeta * particle_vorts[pidx];								\\\n"
+"	ret = zeta * particle_vorts[pidx].xyz;							\\\n"
 "	ret = isnormal(ret) && radd != 0.f ? ret : (float3)(0.f, 0.f, 0.f);\\\n"
-"	reduction_workspace[widx] = ret;								\\\n"
+"	acc += ret;														\\\n"
+"	}																\\\n"
+"	reduction_workspace[widx] = acc;								\\\n"
 "	local_workspace_float3_reduce(reduction_workspace);				\\\n"
 "	barrier(CLK_LOCAL_MEM_FENCE);									\\\n"
 "	if( widx == 0 ){												\\\n"
-"		results[midx] = reduction_workspace[0] + results[midx];		\\\n"
+"		results[midx] = reduction_workspace[0];						\\\n"
 "	}																\\\n"
 "	return;															\\\n"
 "}																	\n"
@@ -510,6 +589,33 @@ Definitions for the repeated body of kernels
 "	CVTX_P3D_VISC_DVORT_END															\n"
 
 
+/* ###########################################################
+	3D fused velocity, dvort and viscous dvort kernels here:
+	name cvtx_nb_P3D_vel_dvort_visc_XXXXX	
+	###########################################################	*/
+"	/* Viscocity doesn't work for singular & planetary */							\n"
+"__kernel void cvtx_nb_P3D_vel_dvort_visc_winckelmans								\n"
+"	CVTX_P3D_VEL_DVORT_VISC_START													\n"
+"	float a = rsqrt(rho * rho + 1);													\n"
+"	float a2 = a * a;																\n"
+"	float a5 = a2 * a2 * a;															\n"
+"	g = (rho * rho + 2.5f) * rho * rho * rho * a5;									\n"
+"	f = 7.5f * a5 * a2;																\n"
+"	eta = 52.5f * a5 * a2 * a2;														\n"
+"	CVTX_P3D_VEL_DVORT_VISC_END														\n"
+"__kernel void cvtx_nb_P3D_vel_dvort_visc_gaussian									\n"
+"	CVTX_P3D_VEL_DVORT_VISC_START													\n"
+"	float a1 = 0.254829592f, a2 = -0.284496736f, a3 = 1.421413741f;					\n"
+"	float a4 = -1.453152027f, a5 = 1.061405429f, p = 0.3275911f;					\n"
+"	float rho_sr2 = rho * ONE_OVER_SQRT_TWO;										\n"
+"	float t = 1.f / (1.f + p * rho_sr2);											\n"
+"	float t2 = t * t;	float t3 = t2 * t; float t4 = t2 * t2; float t5 = t3 * t2;	\n"
+"	float e = exp(-rho_sr2 * rho_sr2);												\n"
+"	float erf = 1.f - (a1 * t + a2 * t2 + a3 * t3 + a4 * t4 + a5 * t5) * e;		\n"
+"	f = SQRT_2_OVER_PI * e;															\n"
+"	g = erf - rho * f;																\n"
+"	eta = f;																		\n"
+"	CVTX_P3D_VEL_DVORT_VISC_END														\n"
 /* ###########################################################
 	3D vorticity calculation kernels here:
 	name cvtx_nb_P3D_vort_XXXXX	
@@ -30,37 +30,36 @@ SOFTWARE.
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "OclDeviceState.h"
 #include "opencl_acc.h"
 #include "ocl_F3D.h"
 
 int opencl_brute_force_F3D_M2M_vel(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array) {
 
 	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	long long cpubetter;
 	cl_program prog;
 	cl_context cont;
 	cl_command_queue queue;
-	cpubetter = (long long)num_filaments * (long long)num_mes <
-		(long long)num_filaments * (long long)num_mes / 20 + 5000 + 300 * num_mes ?
-		1 : 0;
+	OclDeviceState *device;
 
-	if (!cpubetter && opencl_num_active_devices() > 0 &&
+	if (opencl_load() >= 0 &&
+		opencl_num_active_devices() > 0 &&
 		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
-		if (num_mes < CVTX_WORKGROUP_SIZE) {
+		device = opencl_device_of_queue(queue);
+		if (device != NULL && num_mes < device->workgroup_size()) {
 			return opencl_brute_force_F3D_M2sM_vel_impl(
 				array_start, num_filaments, mes_start,
-				num_mes, result_array, prog, queue, cont);
+				num_mes, result_array, prog, queue);
 		}
 		else {
 			return opencl_brute_force_F3D_M2M_vel_impl(
 				array_start, num_filaments, mes_start,
-				num_mes, result_array, prog, queue, cont);
+				num_mes, result_array, prog, queue);
 		}
 	}
 	else
@@ -70,36 +69,37 @@ int opencl_brute_force_F3D_M2M_vel(
 }
 
 int opencl_brute_force_F3D_M2M_vel_impl(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_Filament_ind_vel_singular";
-	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments;
+	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments, group_size;
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float3 *mes_pos_buff_data, *fil_start_buff_data, *fil_end_buff_data, *res_buff_data;
 	cl_float *fil_strength_buff_data;
 	cl_mem mes_pos_buff, res_buff, *fil_start_buff, *fil_end_buff, *fil_strength_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 	cl_event *event_chain;
 
 	if (opencl_init() == 1)
 	{
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
+		workgroup_size[0] = group_size;	/* Particles per group */
 		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple particle buffers */
+		global_work_size[0] = group_size;	/* We use multiple particle buffers */
 		global_work_size[1] = num_mes;
 
 		/* Generate an buffer for the measurement position data  */
@@ -109,8 +109,7 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 			mes_pos_buff_data[i].y = mes_start[i].x[1];
 			mes_pos_buff_data[i].z = mes_start[i].x[2];
 		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes * sizeof(cl_float3), NULL, &status);
+		mes_pos_buff = device->acquire_buffer(num_mes * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, mes_pos_buff, CL_FALSE,
 			0, num_mes * sizeof(cl_float3), mes_pos_buff_data, 0, NULL, NULL);
@@ -118,15 +117,13 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
 		if (status != CL_SUCCESS) {
 			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
+			device->release_buffer(mes_pos_buff);
 			return -1;
 		}
 
 		/* Generate a results buffer */
 		res_buff_data = (cl_float3*) malloc(num_mes * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_mes, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float3) * num_mes, &status);
 		for (i = 0; i < num_mes; ++i) {
 			res_buff_data[i].x = 0;
 			res_buff_data[i].y = 0;
@@ -143,24 +140,24 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel. */
-		num_filament_groups = num_filaments / CVTX_WORKGROUP_SIZE;
-		if (num_filaments % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_filaments % CVTX_WORKGROUP_SIZE;
+		num_filament_groups = num_filaments / group_size;
+		if (num_filaments % group_size) {
+			n_zeroed_particles = group_size
+				- num_filaments % group_size;
 			num_filament_groups += 1;
 		}
-		n_modelled_filaments = CVTX_WORKGROUP_SIZE * num_filament_groups;
+		n_modelled_filaments = group_size * num_filament_groups;
 		fil_start_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_end_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_strength_buff_data = (cl_float*) malloc(n_modelled_filaments * sizeof(cl_float));
 		for (i = 0; i < num_filaments; ++i) {
-			fil_start_buff_data[i].x = array_start[i]->start.x[0];
-			fil_start_buff_data[i].y = array_start[i]->start.x[1];
-			fil_start_buff_data[i].z = array_start[i]->start.x[2];
-			fil_end_buff_data[i].x = array_start[i]->end.x[0];
-			fil_end_buff_data[i].y = array_start[i]->end.x[1];
-			fil_end_buff_data[i].z = array_start[i]->end.x[2];
-			fil_strength_buff_data[i] = array_start[i]->strength;
+			fil_start_buff_data[i].x = array_start[i].start.x[0];
+			fil_start_buff_data[i].y = array_start[i].start.x[1];
+			fil_start_buff_data[i].z = array_start[i].start.x[2];
+			fil_end_buff_data[i].x = array_start[i].end.x[0];
+			fil_end_buff_data[i].y = array_start[i].end.x[1];
+			fil_end_buff_data[i].z = array_start[i].end.x[2];
+			fil_strength_buff_data[i] = array_start[i].strength;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_filaments; i < n_modelled_filaments; ++i) {
@@ -177,29 +174,26 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 		fil_strength_buff = (cl_mem*) malloc(num_filament_groups * sizeof(cl_mem));
 		event_chain = (cl_event*) malloc(sizeof(cl_event) * num_filament_groups * 4);
 		for (i = 0; i < num_filament_groups; ++i) {
-			fil_start_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_start_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_start_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				fil_start_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i);
+				0, group_size * sizeof(cl_float3),
+				fil_start_buff_data + i * group_size, 0, NULL, event_chain + 4 * i);
 			assert(status == CL_SUCCESS);
-			fil_end_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_end_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_end_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				fil_end_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 1);
+				0, group_size * sizeof(cl_float3),
+				fil_end_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 1);
 			assert(status == CL_SUCCESS);
-			fil_strength_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_strength_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_strength_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float),
-				fil_strength_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 2);
+				0, group_size * sizeof(cl_float),
+				fil_strength_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 2);
 			assert(status == CL_SUCCESS);
 			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), fil_start_buff + i);
 			assert(status == CL_SUCCESS);
@@ -216,9 +210,9 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 					NULL, global_work_size, workgroup_size, 4, event_chain + 4 * i - 1, event_chain + 4 * i + 3);
 			}
 			assert(status == CL_SUCCESS);
-			clReleaseMemObject(fil_start_buff[i]);
-			clReleaseMemObject(fil_end_buff[i]);
-			clReleaseMemObject(fil_strength_buff[i]);
+			device->release_buffer(fil_start_buff[i]);
+			device->release_buffer(fil_end_buff[i]);
+			device->release_buffer(fil_strength_buff[i]);
 		}
 
 		/* Read back our results! */
@@ -241,9 +235,8 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 		free(fil_end_buff_data);
 		free(fil_strength_buff_data);
 		free(mes_pos_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(res_buff);
+		device->release_buffer(mes_pos_buff);
 		return 0;
 	}
 	else
@@ -253,17 +246,16 @@ int opencl_brute_force_F3D_M2M_vel_impl(
 }
 
 int opencl_brute_force_F3D_M2sM_vel_impl(
-	const cvtx_F3D** array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_Filament_ind_vel_singular_smes";
-	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments;
+	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments, group_size;
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float3 *mes_pos_buff_data, * fil_start_buff_data, * fil_end_buff_data, * res_buff_data;
 	cl_float *fil_strength_buff_data;
@@ -271,23 +263,25 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 	cl_mem mes_pos_buff, res_buff, fil_start_buff, fil_end_buff, fil_strength_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 
 	if (opencl_init() == 1)
 	{
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 
-		num_filament_groups = num_filaments / CVTX_WORKGROUP_SIZE +
-			(num_filaments % CVTX_WORKGROUP_SIZE == 0 ? 0 : 1);
+		num_filament_groups = num_filaments / group_size +
+			(num_filaments % group_size == 0 ? 0 : 1);
 
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;		/* Filaments per group */
+		workgroup_size[0] = group_size;		/* Filaments per group */
 		workgroup_size[1] = 1;							/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;		/* We use multiple filament buffers */
-		/* We're doing reduction both on the device side (in CVTX_WORKGROUP_SIZE groups)
+		global_work_size[0] = group_size;		/* We use multiple filament buffers */
+		/* We're doing reduction both on the device side (in group_size groups)
 		and on the host side in num_filament_groups. */
 		global_work_size[1] = num_mes * num_filament_groups;
 
@@ -302,8 +296,7 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 			mes_pos_buff_data[i].y = mes_start[i % num_mes].x[1];
 			mes_pos_buff_data[i].z = mes_start[i % num_mes].x[2];
 		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes  * num_filament_groups * sizeof(cl_float3), NULL, &status);
+		mes_pos_buff = device->acquire_buffer(num_mes  * num_filament_groups * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, mes_pos_buff, CL_FALSE,
 			0, num_mes * num_filament_groups * sizeof(cl_float3), mes_pos_buff_data, 0, NULL, NULL);
@@ -311,15 +304,13 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
 		if (status != CL_SUCCESS) {
 			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
+			device->release_buffer(mes_pos_buff);
 			return -1;
 		}
 
 		/* Generate a results buffer */
 		res_buff_data = (cl_float3*) malloc(num_mes * num_filament_groups * sizeof(cl_float3));
-		res_buff = (cl_mem) clCreateBuffer(context, CL_MEM_WRITE_ONLY,
-			sizeof(cl_float3) * num_mes * num_filament_groups, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float3) * num_mes * num_filament_groups, &status);
 		if (status != CL_SUCCESS) {
 			assert(0);
 			printf("OPENCL:\tFailed to enqueue write buffer.");
@@ -328,22 +319,22 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel. */
-		if (num_filaments % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_filaments % CVTX_WORKGROUP_SIZE;
+		if (num_filaments % group_size) {
+			n_zeroed_particles = group_size
+				- num_filaments % group_size;
 		}
-		n_modelled_filaments = CVTX_WORKGROUP_SIZE * num_filament_groups;
+		n_modelled_filaments = group_size * num_filament_groups;
 		fil_start_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_end_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_strength_buff_data = (cl_float*) malloc(n_modelled_filaments * sizeof(cl_float));
 		for (i = 0; i < num_filaments; ++i) {
-			fil_start_buff_data[i].x = array_start[i]->start.x[0];
-			fil_start_buff_data[i].y = array_start[i]->start.x[1];
-			fil_start_buff_data[i].z = array_start[i]->start.x[2];
-			fil_end_buff_data[i].x = array_start[i]->end.x[0];
-			fil_end_buff_data[i].y = array_start[i]->end.x[1];
-			fil_end_buff_data[i].z = array_start[i]->end.x[2];
-			fil_strength_buff_data[i] = array_start[i]->strength;
+			fil_start_buff_data[i].x = array_start[i].start.x[0];
+			fil_start_buff_data[i].y = array_start[i].start.x[1];
+			fil_start_buff_data[i].z = array_start[i].start.x[2];
+			fil_end_buff_data[i].x = array_start[i].end.x[0];
+			fil_end_buff_data[i].y = array_start[i].end.x[1];
+			fil_end_buff_data[i].z = array_start[i].end.x[2];
+			fil_strength_buff_data[i] = array_start[i].strength;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_filaments; i < n_modelled_filaments; ++i) {
@@ -355,24 +346,21 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 			fil_end_buff_data[i].z = 1.0f;
 			fil_strength_buff_data[i] = 0.0f;
 		}
-		fil_start_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, n_modelled_filaments * sizeof(cl_float3), NULL, &status);
+		fil_start_buff = device->acquire_buffer(n_modelled_filaments * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, fil_start_buff, CL_FALSE,
 			0, n_modelled_filaments * sizeof(cl_float3), fil_start_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), &fil_start_buff);
 
-		fil_end_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, n_modelled_filaments * sizeof(cl_float3), NULL, &status);
+		fil_end_buff = device->acquire_buffer(n_modelled_filaments * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, fil_end_buff, CL_FALSE,
 			0, n_modelled_filaments * sizeof(cl_float3), fil_end_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 1, sizeof(cl_mem), &fil_end_buff);
 
-		fil_strength_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, n_modelled_filaments * sizeof(cl_float), NULL, &status);
+		fil_strength_buff = device->acquire_buffer(n_modelled_filaments * sizeof(cl_float), &status);
 		status = clEnqueueWriteBuffer(
 			queue, fil_strength_buff, CL_FALSE,
 			0, n_modelled_filaments * sizeof(cl_float), fil_strength_buff_data, 0, NULL, NULL);
@@ -405,12 +393,11 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 		free(fil_end_buff_data);
 		free(fil_strength_buff_data);
 		free(mes_pos_buff_data);
-		clReleaseMemObject(fil_start_buff);
-		clReleaseMemObject(fil_end_buff);
-		clReleaseMemObject(fil_strength_buff);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(fil_start_buff);
+		device->release_buffer(fil_end_buff);
+		device->release_buffer(fil_strength_buff);
+		device->release_buffer(res_buff);
+		device->release_buffer(mes_pos_buff);
 		return 0;
 	}
 	else
@@ -420,23 +407,22 @@ int opencl_brute_force_F3D_M2sM_vel_impl(
 }
 
 int opencl_brute_force_F3D_M2M_dvort(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_fil,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array) {
 
 	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
 	cl_program prog;
 	cl_context cont;
 	cl_command_queue queue;
 
-	if (opencl_num_active_devices() > 0 &&
+	if (opencl_load() >= 0 && opencl_num_active_devices() > 0 &&
 		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
 		return opencl_brute_force_F3D_M2M_dvort_impl(
 			array_start, num_fil, induced_start,
-			num_induced, result_array, prog, queue, cont);
+			num_induced, result_array, prog, queue);
 	}
 	else
 	{
@@ -445,17 +431,16 @@ int opencl_brute_force_F3D_M2M_dvort(
 }
 
 int opencl_brute_force_F3D_M2M_dvort_impl(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_fil,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_Filament_ind_dvort_singular";
-	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments;
+	int i, num_filament_groups, n_zeroed_particles, n_modelled_filaments, group_size;
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float3 *part_pos_buff_data, *part_vort_buff_data,
 		*fil_start_buff_data, *fil_end_buff_data, *res_buff_data;
@@ -464,42 +449,42 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 		*fil_start_buff, *fil_end_buff, *fil_strength_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 	cl_event *event_chain;
 
 	if (opencl_init() == 1)
 	{
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
+		workgroup_size[0] = group_size;	/* Particles per group */
 		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple particle buffers */
+		global_work_size[0] = group_size;	/* We use multiple particle buffers */
 		global_work_size[1] = num_induced;
 
 		/* Generate an buffer for the measurement position data  */
 		part_pos_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
 		part_vort_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
 		for (i = 0; i < num_induced; ++i) {
-			part_pos_buff_data[i].x = induced_start[i]->coord.x[0];
-			part_pos_buff_data[i].y = induced_start[i]->coord.x[1];
-			part_pos_buff_data[i].z = induced_start[i]->coord.x[2];
-			part_vort_buff_data[i].x = induced_start[i]->vorticity.x[0];
-			part_vort_buff_data[i].y = induced_start[i]->vorticity.x[1];
-			part_vort_buff_data[i].z = induced_start[i]->vorticity.x[2];
+			part_pos_buff_data[i].x = induced_start[i].coord.x[0];
+			part_pos_buff_data[i].y = induced_start[i].coord.x[1];
+			part_pos_buff_data[i].z = induced_start[i].coord.x[2];
+			part_vort_buff_data[i].x = induced_start[i].vorticity.x[0];
+			part_vort_buff_data[i].y = induced_start[i].vorticity.x[1];
+			part_vort_buff_data[i].z = induced_start[i].vorticity.x[2];
 		}
-		part_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
+		part_pos_buff = device->acquire_buffer(num_induced * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part_pos_buff, CL_FALSE,
 			0, num_induced * sizeof(cl_float3), part_pos_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &part_pos_buff);
 		assert(status == CL_SUCCESS);
-		part_vort_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
+		part_vort_buff = device->acquire_buffer(num_induced * sizeof(cl_float3), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part_vort_buff, CL_FALSE,
 			0, num_induced * sizeof(cl_float3), part_vort_buff_data, 0, NULL, NULL);
@@ -508,16 +493,14 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 		if (status != CL_SUCCESS) {
 			free(part_pos_buff_data);
 			free(part_vort_buff_data);
-			clReleaseMemObject(part_pos_buff);
-			clReleaseMemObject(part_vort_buff);
-			clReleaseKernel(cl_kernel);
+			device->release_buffer(part_pos_buff);
+			device->release_buffer(part_vort_buff);
 			return -1;
 		}
 
 		/* Generate a results buffer */
 		res_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_induced, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float3) * num_induced, &status);
 		for (i = 0; i < num_induced; ++i) {
 			res_buff_data[i].x = 0;
 			res_buff_data[i].y = 0;
@@ -534,24 +517,24 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel. */
-		num_filament_groups = num_fil / CVTX_WORKGROUP_SIZE;
-		if (num_fil % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_fil % CVTX_WORKGROUP_SIZE;
+		num_filament_groups = num_fil / group_size;
+		if (num_fil % group_size) {
+			n_zeroed_particles = group_size
+				- num_fil % group_size;
 			num_filament_groups += 1;
 		}
-		n_modelled_filaments = CVTX_WORKGROUP_SIZE * num_filament_groups;
+		n_modelled_filaments = group_size * num_filament_groups;
 		fil_start_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_end_buff_data = (cl_float3*) malloc(n_modelled_filaments * sizeof(cl_float3));
 		fil_strength_buff_data = (cl_float*) malloc(n_modelled_filaments * sizeof(cl_float));
 		for (i = 0; i < num_fil; ++i) {
-			fil_start_buff_data[i].x = array_start[i]->start.x[0];
-			fil_start_buff_data[i].y = array_start[i]->start.x[1];
-			fil_start_buff_data[i].z = array_start[i]->start.x[2];
-			fil_end_buff_data[i].x = array_start[i]->end.x[0];
-			fil_end_buff_data[i].y = array_start[i]->end.x[1];
-			fil_end_buff_data[i].z = array_start[i]->end.x[2];
-			fil_strength_buff_data[i] = array_start[i]->strength;
+			fil_start_buff_data[i].x = array_start[i].start.x[0];
+			fil_start_buff_data[i].y = array_start[i].start.x[1];
+			fil_start_buff_data[i].z = array_start[i].start.x[2];
+			fil_end_buff_data[i].x = array_start[i].end.x[0];
+			fil_end_buff_data[i].y = array_start[i].end.x[1];
+			fil_end_buff_data[i].z = array_start[i].end.x[2];
+			fil_strength_buff_data[i] = array_start[i].strength;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_fil; i < n_modelled_filaments; ++i) {
@@ -568,29 +551,26 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 		fil_strength_buff = (cl_mem*) malloc(num_filament_groups * sizeof(cl_mem));
 		event_chain = (cl_event*) malloc(sizeof(cl_event) * num_filament_groups * 4);
 		for (i = 0; i < num_filament_groups; ++i) {
-			fil_start_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_start_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_start_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				fil_start_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i);
+				0, group_size * sizeof(cl_float3),
+				fil_start_buff_data + i * group_size, 0, NULL, event_chain + 4 * i);
 			assert(status == CL_SUCCESS);
-			fil_end_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_end_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_end_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				fil_end_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 1);
+				0, group_size * sizeof(cl_float3),
+				fil_end_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 1);
 			assert(status == CL_SUCCESS);
-			fil_strength_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
+			fil_strength_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float3), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, fil_strength_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				fil_strength_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 2);
+				0, group_size * sizeof(cl_float3),
+				fil_strength_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 2);
 			assert(status == CL_SUCCESS);
 			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), fil_start_buff + i);
 			assert(status == CL_SUCCESS);
@@ -607,9 +587,9 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 					NULL, global_work_size, workgroup_size, 4, event_chain + 4 * i - 1, event_chain + 4 * i + 3);
 			}
 			assert(status == CL_SUCCESS);
-			clReleaseMemObject(fil_start_buff[i]);
-			clReleaseMemObject(fil_end_buff[i]);
-			clReleaseMemObject(fil_strength_buff[i]);
+			device->release_buffer(fil_start_buff[i]);
+			device->release_buffer(fil_end_buff[i]);
+			device->release_buffer(fil_strength_buff[i]);
 		}
 
 		/* Read back our results! */
@@ -633,10 +613,9 @@ int opencl_brute_force_F3D_M2M_dvort_impl(
 		free(fil_strength_buff_data);
 		free(part_pos_buff_data);
 		free(part_vort_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(part_pos_buff);
-		clReleaseMemObject(part_vort_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(res_buff);
+		device->release_buffer(part_pos_buff);
+		device->release_buffer(part_vort_buff);
 		return 0;
 	}
 	else
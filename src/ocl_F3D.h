@@ -29,51 +29,49 @@ SOFTWARE.
 
 #ifdef CVTX_USING_OPENCL
 #include <CL/cl.h>
+#include "ParticleView.h"
 
 int opencl_brute_force_F3D_M2M_vel(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array);
 
 int opencl_brute_force_F3D_M2M_vel_impl(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 /* M2M, but for where the num_mes is small (EG. <256) */
 int opencl_brute_force_F3D_M2sM_vel_impl(
-	const cvtx_F3D** array_start,
+	const F3DView &array_start,
 	const int num_filaments,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 int opencl_brute_force_F3D_M2M_dvort(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_fil,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array);
 
 int opencl_brute_force_F3D_M2M_dvort_impl(
-	const cvtx_F3D **array_start,
+	const F3DView &array_start,
 	const int num_fil,
-	const cvtx_P3D **induced_start,
+	const P3DView &induced_start,
 	const int num_induced,
 	bsv_V3f *result_array,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 #endif /* CVTX_USING_OPENCL */
 #endif /* CVTX_OCL_F3D_H */
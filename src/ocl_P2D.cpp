@@ -31,11 +31,12 @@ SOFTWARE.
 #include <stdlib.h>
 #include <string.h>
 
+#include "OclDeviceState.h"
 #include "opencl_acc.h"
 #include "ocl_P2D.h"
 
 int opencl_brute_force_P2D_M2M_vel(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -44,29 +45,26 @@ int opencl_brute_force_P2D_M2M_vel(
 	float regularisation_radius)
 {
 	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	long long cpubetter;
 	cl_program prog;
 	cl_context cont;
 	cl_command_queue queue;
-	/* A loosey goosey way of estimating whether we'd do better
-	using the cpu to solve the problem: */
-	cpubetter = 20000 + (long long)num_particles * (long long)num_mes / 20
-		< (long long)num_particles * (long long)num_mes ? 0 : 1;
+	OclDeviceState *device;
 
-	if (!cpubetter && opencl_num_active_devices() > 0 &&
+	if (opencl_load() >= 0 &&
+		opencl_num_active_devices() > 0 &&
 		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
-		if (num_mes < CVTX_WORKGROUP_SIZE) {
+		device = opencl_device_of_queue(queue);
+		if (device != NULL && num_mes < device->workgroup_size()) {
 			return opencl_brute_force_P2D_M2sM_vel_impl(
 				array_start, num_particles, mes_start,
 				num_mes, result_array, kernel, regularisation_radius,
-				prog, queue, cont);
+				prog, queue);
 		}
 		else {
 			return opencl_brute_force_P2D_M2M_vel_impl(
 				array_start, num_particles, mes_start,
 				num_mes, result_array, kernel, regularisation_radius,
-				prog, queue, cont);
+				prog, queue);
 		}
 	}
 	else
@@ -76,9 +74,9 @@ int opencl_brute_force_P2D_M2M_vel(
 }
 
 int opencl_brute_force_P2D_M2M_visc_dvort(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
@@ -86,17 +84,16 @@ int opencl_brute_force_P2D_M2M_visc_dvort(
 	float kinematic_visc)
 {
 	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
 	cl_program prog;
 	cl_context cont;
 	cl_command_queue queue;
 
-	if (opencl_num_active_devices() > 0 &&
+	if (opencl_load() >= 0 && opencl_num_active_devices() > 0 &&
 		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
 		return opencl_brute_force_P2D_M2M_visc_dvort_impl(
 			array_start, num_particles, induced_start, num_induced,
 			result_array, kernel, regularisation_radius, kinematic_visc,
-			prog, queue, cont);
+			prog, queue);
 	}
 	else
 	{
@@ -105,7 +102,7 @@ int opencl_brute_force_P2D_M2M_visc_dvort(
 }
 
 int opencl_brute_force_P2D_M2M_vel_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -113,11 +110,10 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_P2D_vel_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
+	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles, group_size;
 	float constant_multiplyer = 1.f / (2.f * acosf(-1));
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float2 *mes_pos_buff_data, *part_pos_buff_data, *res_buff_data;
@@ -125,20 +121,22 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 	cl_mem mes_pos_buff, res_buff, *part_pos_buff, *part_vort_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 	cl_event *event_chain;
 
 	if (opencl_init() == 1)
 	{
 		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
+		workgroup_size[0] = group_size;	/* Particles per group */
 		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple particle buffers */
+		global_work_size[0] = group_size;	/* We use multiple particle buffers */
 		global_work_size[1] = num_mes;
 
 		/* Generate an buffer for the measurement position data  */
@@ -147,8 +145,7 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 			mes_pos_buff_data[i].x = mes_start[i].x[0];
 			mes_pos_buff_data[i].y = mes_start[i].x[1];
 		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes * sizeof(cl_float2), NULL, &status);
+		mes_pos_buff = device->acquire_buffer(num_mes * sizeof(cl_float2), &status);
 		status = clEnqueueWriteBuffer(
 			queue, mes_pos_buff, CL_FALSE,
 			0, num_mes * sizeof(cl_float2), mes_pos_buff_data, 0, NULL, NULL);
@@ -156,8 +153,7 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
 		if (status != CL_SUCCESS) {
 			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
+			device->release_buffer(mes_pos_buff);
 			return -1;
 		}
 
@@ -167,8 +163,7 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 
 		/* Generate a results buffer */
 		res_buff_data = (cl_float2*) malloc(num_mes * sizeof(cl_float2));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float2) * num_mes, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float2) * num_mes, &status);
 		for (i = 0; i < num_mes; ++i) {
 			res_buff_data[i].x = 0.f;
 			res_buff_data[i].y = 0.f;
@@ -183,19 +178,19 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
+		n_particle_groups = num_particles / group_size;
+		if (num_particles % group_size) {
+			n_zeroed_particles = group_size
+				- num_particles % group_size;
 			n_particle_groups += 1;
 		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
+		n_modelled_particles = group_size * n_particle_groups;
 		part_pos_buff_data = (cl_float2*) malloc(n_modelled_particles * sizeof(cl_float2));
 		part_vort_buff_data = (cl_float*) malloc(n_modelled_particles * sizeof(cl_float));
 		for (i = 0; i < num_particles; ++i) {
-			part_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part_vort_buff_data[i] = array_start[i]->vorticity;
+			part_pos_buff_data[i].x = array_start[i].coord.x[0];
+			part_pos_buff_data[i].y = array_start[i].coord.x[1];
+			part_vort_buff_data[i] = array_start[i].vorticity;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_particles; i < n_modelled_particles; ++i) {
@@ -207,21 +202,19 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 		part_vort_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
 		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 3);
 		for (i = 0; i < n_particle_groups; ++i) {
-			part_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float2), NULL, &status);
+			part_pos_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float2), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, part_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float2),
-				part_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i);
+				0, group_size * sizeof(cl_float2),
+				part_pos_buff_data + i * group_size, 0, NULL, event_chain + 3 * i);
 			assert(status == CL_SUCCESS);
-			part_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float), NULL, &status);
+			part_vort_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, part_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float),
-				part_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i + 1);
+				0, group_size * sizeof(cl_float),
+				part_vort_buff_data + i * group_size, 0, NULL, event_chain + 3 * i + 1);
 			assert(status == CL_SUCCESS);
 			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part_pos_buff + i);
 			assert(status == CL_SUCCESS);
@@ -236,8 +229,8 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 					NULL, global_work_size, workgroup_size, 3, event_chain + 3 * i - 1, event_chain + 3 * i + 2);
 			}
 			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part_pos_buff[i]);
-			clReleaseMemObject(part_vort_buff[i]);
+			device->release_buffer(part_pos_buff[i]);
+			device->release_buffer(part_vort_buff[i]);
 		}
 
 		/* Read back our results! */
@@ -258,9 +251,8 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 		free(part_pos_buff_data);
 		free(part_vort_buff_data);
 		free(mes_pos_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(res_buff);
+		device->release_buffer(mes_pos_buff);
 		return 0;
 	}
 	else
@@ -270,7 +262,7 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 }
 
 int opencl_brute_force_P2D_M2sM_vel_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -278,11 +270,10 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_P2D_smallmes_vel_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
+	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles, group_size;
 	float constant_multiplyer = 1.f / (2.f * acosf(-1));
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float2 *mes_pos_buff_data, *part_pos_buff_data, *res_buff_data;
@@ -291,24 +282,26 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 	cl_mem mes_pos_buff, res_buff, part_pos_buff, part_vort_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 
 	if (opencl_init() == 1)
 	{
 		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE +
-			(num_particles % CVTX_WORKGROUP_SIZE == 0 ? 0 : 1);
+		n_particle_groups = num_particles / group_size +
+			(num_particles % group_size == 0 ? 0 : 1);
 
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
+		workgroup_size[0] = group_size;	/* Particles per group */
 		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;
-		/* We're doing reduction both on the device side (in CVTX_WORKGROUP_SIZE groups)
+		global_work_size[0] = group_size;
+		/* We're doing reduction both on the device side (in group_size groups)
 		and on the host side in n_particle_groups. */
 		global_work_size[1] = num_mes * n_particle_groups;
 
@@ -322,8 +315,7 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 			mes_pos_buff_data[i].x = mes_start[i % num_mes].x[0];
 			mes_pos_buff_data[i].y = mes_start[i % num_mes].x[1];
 		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes  * n_particle_groups * sizeof(cl_float2), NULL, &status);
+		mes_pos_buff = device->acquire_buffer(num_mes  * n_particle_groups * sizeof(cl_float2), &status);
 		status = clEnqueueWriteBuffer(
 			queue, mes_pos_buff, CL_FALSE,
 			0, num_mes * n_particle_groups * sizeof(cl_float2), mes_pos_buff_data, 0, NULL, NULL);
@@ -331,8 +323,7 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
 		if (status != CL_SUCCESS) {
 			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
+			device->release_buffer(mes_pos_buff);
 			return -1;
 		}
 
@@ -342,8 +333,7 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 
 		/* Generate a results buffer */
 		res_buff_data = (cl_float2*) malloc(num_mes * n_particle_groups * sizeof(cl_float2));
-		res_buff = clCreateBuffer(context, CL_MEM_WRITE_ONLY,
-			sizeof(cl_float2) * num_mes * n_particle_groups, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float2) * num_mes * n_particle_groups, &status);
 		if (status != CL_SUCCESS) {
 			assert(0);
 		}
@@ -351,18 +341,18 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel. */
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
+		if (num_particles % group_size) {
+			n_zeroed_particles = group_size
+				- num_particles % group_size;
 		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
+		n_modelled_particles = group_size * n_particle_groups;
 		assert(n_modelled_particles >= num_particles);
 		part_pos_buff_data = (cl_float2*) malloc(n_modelled_particles * sizeof(cl_float2));
 		part_vort_buff_data = (cl_float*) malloc(n_modelled_particles * sizeof(cl_float));
 		for (i = 0; i < num_particles; ++i) {
-			part_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part_vort_buff_data[i] = array_start[i]->vorticity;
+			part_pos_buff_data[i].x = array_start[i].coord.x[0];
+			part_pos_buff_data[i].y = array_start[i].coord.x[1];
+			part_vort_buff_data[i] = array_start[i].vorticity;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_particles; i < n_modelled_particles; ++i) {
@@ -370,16 +360,14 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 			part_pos_buff_data[i].y = 0.f;
 			part_vort_buff_data[i] = 0.f;
 		}
-		part_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, n_modelled_particles * sizeof(cl_float2), NULL, &status);
+		part_pos_buff = device->acquire_buffer(n_modelled_particles * sizeof(cl_float2), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part_pos_buff, CL_FALSE,
 			0, n_modelled_particles * sizeof(cl_float2), part_pos_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), &part_pos_buff);
 
-		part_vort_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, n_modelled_particles * sizeof(cl_float), NULL, &status);
+		part_vort_buff = device->acquire_buffer(n_modelled_particles * sizeof(cl_float), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part_vort_buff, CL_FALSE,
 			0, n_modelled_particles * sizeof(cl_float), part_vort_buff_data, 0, NULL, NULL);
@@ -410,11 +398,10 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 
 		free(part_vort_buff_data);
 		free(mes_pos_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseMemObject(part_pos_buff);
-		clReleaseMemObject(part_vort_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(res_buff);
+		device->release_buffer(mes_pos_buff);
+		device->release_buffer(part_pos_buff);
+		device->release_buffer(part_vort_buff);
 		return 0;
 	}
 	else
@@ -424,20 +411,19 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 }
 
 int opencl_brute_force_P2D_M2M_visc_dvort_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
 	char kernel_name[128] = "cvtx_nb_P2D_visc_dvort_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
+	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles, group_size;
 	size_t global_work_size[2], workgroup_size[2];
 	cl_float2 *part1_pos_buff_data, *part2_pos_buff_data;
 	cl_float *part1_area_buff_data, *part1_vort_buff_data, 
@@ -446,20 +432,22 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 		part2_pos_buff, part2_vort_buff, part2_area_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
+	OclDeviceState *device;
 	cl_event *event_chain;
 
 	if (opencl_init() == 1)
 	{
 		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { return -1; }
+		group_size = device->workgroup_size();
+		cl_kernel = device->kernel(program, kernel_name);
+		if (cl_kernel == NULL) { return -1; }
+		std::lock_guard<std::mutex> launch(device->launch_mutex());
 		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
+		workgroup_size[0] = group_size;	/* Particles per group */
 		workgroup_size[1] = 1;	/* Only 1 induced particle pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple inducing particle buffers */
+		global_work_size[0] = group_size;	/* We use multiple inducing particle buffers */
 		global_work_size[1] = num_induced;
 
 		/* Generate buffers for induced particle data  */
@@ -467,30 +455,27 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 		part2_vort_buff_data = (cl_float*) malloc(num_induced * sizeof(cl_float));
 		part2_area_buff_data = (cl_float*) malloc(num_induced * sizeof(cl_float));
 		for (i = 0; i < num_induced; ++i) {
-			part2_pos_buff_data[i].x = induced_start[i]->coord.x[0];
-			part2_pos_buff_data[i].y = induced_start[i]->coord.x[1];
-			part2_vort_buff_data[i] = induced_start[i]->vorticity;
-			part2_area_buff_data[i] = induced_start[i]->area;
+			part2_pos_buff_data[i].x = induced_start[i].coord.x[0];
+			part2_pos_buff_data[i].y = induced_start[i].coord.x[1];
+			part2_vort_buff_data[i] = induced_start[i].vorticity;
+			part2_area_buff_data[i] = induced_start[i].area;
 		}
 		/* Induced particle Create buffer, enqueue write and set kernel arg. */
-		part2_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float2), NULL, &status);
+		part2_pos_buff = device->acquire_buffer(num_induced * sizeof(cl_float2), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part2_pos_buff, CL_TRUE,
 			0, num_induced * sizeof(cl_float2), part2_pos_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &part2_pos_buff);
 		assert(status == CL_SUCCESS);
-		part2_vort_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float), NULL, &status);
+		part2_vort_buff = device->acquire_buffer(num_induced * sizeof(cl_float), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part2_vort_buff, CL_TRUE,
 			0, num_induced * sizeof(cl_float), part2_vort_buff_data, 0, NULL, NULL);
 		assert(status == CL_SUCCESS);
 		status = clSetKernelArg(cl_kernel, 4, sizeof(cl_mem), &part2_vort_buff);
 		assert(status == CL_SUCCESS);
-		part2_area_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float), NULL, &status);
+		part2_area_buff = device->acquire_buffer(num_induced * sizeof(cl_float), &status);
 		status = clEnqueueWriteBuffer(
 			queue, part2_area_buff, CL_TRUE,
 			0, num_induced * sizeof(cl_float), part2_area_buff_data, 0, NULL, NULL);
@@ -500,8 +485,7 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 
 		/* Generate a results buffer										*/
 		res_buff_data = (cl_float*) malloc(num_induced * sizeof(cl_float));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_induced, NULL, &status);
+		res_buff = device->acquire_buffer(sizeof(cl_float3) * num_induced, &status);
 		for (i = 0; i < num_induced; ++i) {
 			res_buff_data[i] = 0;
 		}
@@ -523,23 +507,23 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 		assert(status == CL_SUCCESS);
 
 		/* Now create & dispatch particle buffers and kernel.
-		Inducing particle count needs to be a multiple of the CVTX_WORKGROUP_SIZE,
+		Inducing particle count needs to be a multiple of the workgroup size,
 		so we add some zerod particles onto the end of the array. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
+		n_particle_groups = num_particles / group_size;
+		if (num_particles % group_size) {
+			n_zeroed_particles = group_size
+				- num_particles % group_size;
 			n_particle_groups += 1;
 		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
+		n_modelled_particles = group_size * n_particle_groups;
 		part1_pos_buff_data = (cl_float2*) malloc(n_modelled_particles * sizeof(cl_float2));
 		part1_vort_buff_data = (cl_float*) malloc(n_modelled_particles * sizeof(cl_float));
 		part1_area_buff_data = (cl_float*) malloc(n_modelled_particles * sizeof(cl_float));
 		for (i = 0; i < num_particles; ++i) {
-			part1_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part1_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part1_vort_buff_data[i] = array_start[i]->vorticity;
-			part1_area_buff_data[i] = array_start[i]->area;
+			part1_pos_buff_data[i].x = array_start[i].coord.x[0];
+			part1_pos_buff_data[i].y = array_start[i].coord.x[1];
+			part1_vort_buff_data[i] = array_start[i].vorticity;
+			part1_area_buff_data[i] = array_start[i].area;
 		}
 		/* We need this so that we always have the minimum workgroup size. */
 		for (i = num_particles; i < n_modelled_particles; ++i) {
@@ -553,29 +537,26 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 		part1_area_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
 		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 4);
 		for (i = 0; i < n_particle_groups; ++i) {
-			part1_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float2), NULL, &status);
+			part1_pos_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float2), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, part1_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float2),
-				part1_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i);
+				0, group_size * sizeof(cl_float2),
+				part1_pos_buff_data + i * group_size, 0, NULL, event_chain + 4 * i);
 			assert(status == CL_SUCCESS);
-			part1_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float), NULL, &status);
+			part1_vort_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, part1_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float),
-				part1_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 1);
+				0, group_size * sizeof(cl_float),
+				part1_vort_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 1);
 			assert(status == CL_SUCCESS);
-			part1_area_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float), NULL, &status);
+			part1_area_buff[i] = device->acquire_buffer(group_size * sizeof(cl_float), &status);
 			assert(status == CL_SUCCESS);
 			status = clEnqueueWriteBuffer(
 				queue, part1_area_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float),
-				part1_area_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 2);
+				0, group_size * sizeof(cl_float),
+				part1_area_buff_data + i * group_size, 0, NULL, event_chain + 4 * i + 2);
 			assert(status == CL_SUCCESS);
 			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part1_pos_buff + i);
 			assert(status == CL_SUCCESS);
@@ -592,9 +573,9 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 					NULL, global_work_size, workgroup_size, 4, event_chain + 4 * i - 1, event_chain + 4 * i + 3);
 			}
 			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part1_pos_buff[i]);
-			clReleaseMemObject(part1_vort_buff[i]);
-			clReleaseMemObject(part1_area_buff[i]);
+			device->release_buffer(part1_pos_buff[i]);
+			device->release_buffer(part1_vort_buff[i]);
+			device->release_buffer(part1_area_buff[i]);
 		}
 
 		/* Read back our results! */
@@ -617,11 +598,10 @@ int opencl_brute_force_P2D_M2M_visc_dvort_impl(
 		free(part1_pos_buff_data);
 		free(part1_vort_buff_data);
 		free(part1_area_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(part2_pos_buff);
-		clReleaseMemObject(part2_vort_buff);
-		clReleaseMemObject(part2_area_buff);
-		clReleaseKernel(cl_kernel);
+		device->release_buffer(res_buff);
+		device->release_buffer(part2_pos_buff);
+		device->release_buffer(part2_vort_buff);
+		device->release_buffer(part2_area_buff);
 		return 0;
 	}
 	else
@@ -29,9 +29,10 @@ SOFTWARE.
 #ifdef CVTX_USING_OPENCL
 #include <bsv/bsv.h>
 #include "opencl_acc.h"
+#include "ParticleView.h"
 
 int opencl_brute_force_P2D_M2M_vel(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -40,9 +41,9 @@ int opencl_brute_force_P2D_M2M_vel(
 	float regularisation_radius);
 
 int opencl_brute_force_P2D_M2M_visc_dvort(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
@@ -50,7 +51,7 @@ int opencl_brute_force_P2D_M2M_visc_dvort(
 	float kinematic_visc);
 
 int opencl_brute_force_P2D_M2M_vel_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -58,12 +59,11 @@ int opencl_brute_force_P2D_M2M_vel_impl(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 /* For small number of measurement points. */
 int opencl_brute_force_P2D_M2sM_vel_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
 	const bsv_V2f *mes_start,
 	const int num_mes,
@@ -71,21 +71,19 @@ int opencl_brute_force_P2D_M2sM_vel_impl(
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 int opencl_brute_force_P2D_M2M_visc_dvort_impl(
-	const cvtx_P2D **array_start,
+	const P2DView &array_start,
 	const int num_particles,
-	const cvtx_P2D **induced_start,
+	const P2DView &induced_start,
 	const int num_induced,
 	float *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 #endif /* CVTX_USING_OPENCL */
 #endif /* CVTX_OCL_P2D_H */
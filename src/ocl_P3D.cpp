@@ -26,876 +26,685 @@ SOFTWARE.
 ============================================================================*/
 
 #ifdef CVTX_USING_OPENCL
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
 
+#include "OclDeviceState.h"
+#include "OclP3DBuffers.h"
 #include "opencl_acc.h"
 #include "ocl_P3D.h"
 
+/* When each part of a split completes. The devices may finish in any 
+order, so each part's time is recorded by a callback on its last event. */
+struct SplitCompletion {
+	std::mutex mutex;
+	std::condition_variable all_complete;
+	int num_pending;
+	std::vector<std::chrono::steady_clock::time_point> ends;
+	std::vector<std::pair<SplitCompletion*, int>> tags;
+
+	explicit SplitCompletion(int num_parts) 
+		: num_pending(0), ends(num_parts), tags(num_parts) {}
+
+	static void CL_CALLBACK on_complete(cl_event, cl_int, void *data)
+	{
+		auto *tag = (std::pair<SplitCompletion*, int>*) data;
+		SplitCompletion &self = *tag->first;
+		std::lock_guard<std::mutex> lock(self.mutex);
+		self.ends[tag->second] = std::chrono::steady_clock::now();
+		if (--self.num_pending == 0) { self.all_complete.notify_all(); }
+	}
+
+	/* Record when part's request completes. False if it can't be. */
+	bool watch(int part, cvtx_Request &request)
+	{
+		tags[part] = std::make_pair(this, part);
+		std::lock_guard<std::mutex> lock(mutex);
+		++num_pending;
+		if (request.set_callback(on_complete, &tags[part]) != CL_SUCCESS) {
+			--num_pending;
+			return false;
+		}
+		return true;
+	}
+
+	/* Block until every watched part has completed. */
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		all_complete.wait(lock, [this]() { return num_pending == 0; });
+	}
+};
+
+/* Split num_induced induced particles / measurement points over the active 
+devices in proportion to their throughput, falling back to their compute 
+units until every device has been measured. eval(program, queue, first, count, 
+request) evaluates the count from first on one device. Given 
+a request, every part's results are read back through it. Otherwise the 
+call blocks until all the parts are complete, timing each device. */
+template<typename EvalT>
+static int split_over_devices(
+	int num_particles,
+	int num_induced,
+	cvtx_Request *request,
+	EvalT eval)
+{
+	std::vector<cl_program> progs;
+	std::vector<cl_command_queue> queues;
+	std::vector<OclDeviceState*> devices;
+	std::vector<double> weights;
+	std::vector<int> firsts, counts;
+	cl_program prog;
+	cl_context cont;
+	cl_command_queue queue;
+	OclDeviceState *device;
+	bool all_measured = true;
+	double total_weight = 0.;
+	int i, n, nd, first, good = 0;
+
+	if (opencl_load() < 0) { return -1; }
+	nd = opencl_num_active_devices();
+	for (i = 0; i < nd; ++i) {
+		if (opencl_get_device_state(i, &prog, &cont, &queue) != 0) { continue; }
+		device = opencl_device_of_queue(queue);
+		if (device == NULL) { continue; }
+		progs.push_back(prog);
+		queues.push_back(queue);
+		devices.push_back(device);
+		all_measured = all_measured && device->throughput() > 0.;
+	}
+	n = (int) devices.size();
+	if (n == 0) { return -1; }
+	if (n == 1) {
+		return eval(progs[0], queues[0], 0, num_induced, request);
+	}
+
+	for (i = 0; i < n; ++i) {
+		weights.push_back(all_measured ? devices[i]->throughput() 
+			: (double) std::max(devices[i]->compute_units(), 1));
+		total_weight += weights[i];
+	}
+	first = 0;
+	for (i = 0; i < n; ++i) {
+		firsts.push_back(first);
+		counts.push_back(i == n - 1 ? num_induced - first :
+			std::min(num_induced - first, 
+				(int)(num_induced * weights[i] / total_weight + 0.5)));
+		first += counts[i];
+	}
+
+	if (request != NULL) {
+		for (i = 0; i < n && good == 0; ++i) {
+			if (counts[i] > 0) {
+				good = eval(progs[i], queues[i], firsts[i], counts[i], 
+					request);
+			}
+		}
+		if (good != 0) { request->wait(); }
+		return good;
+	}
+
+	/* Enqueue everything before waiting so that the devices run together, 
+	then time each part to its completion for the next split. */
+	std::vector<cvtx_Request> parts(n);
+	std::vector<bool> watched(n, false);
+	SplitCompletion completion(n);
+	auto start = std::chrono::steady_clock::now();
+	for (i = 0; i < n && good == 0; ++i) {
+		if (counts[i] > 0) {
+			good = eval(progs[i], queues[i], firsts[i], counts[i], 
+				&parts[i]);
+			watched[i] = good == 0 && completion.watch(i, parts[i]);
+		}
+	}
+	/* The callbacks refer to completion, so wait for them even on error. 
+	A part that failed leaves its results unwritten, so the caller has to 
+	fall back to the CPU. */
+	completion.wait();
+	for (i = 0; i < n; ++i) {
+		if (parts[i].wait() != 0) { good = -1; }
+	}
+	for (i = 0; i < n && good == 0; ++i) {
+		if (watched[i]) {
+			std::chrono::duration<double> secs = completion.ends[i] - start;
+			devices[i]->record_throughput(
+				(double) num_particles * counts[i], secs.count());
+		}
+	}
+	return good;
+}
+
 int opencl_brute_force_P3D_M2M_vel(
-	const cvtx_P3D **array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
-	float regularisation_radius) 
+	float regularisation_radius,
+	cvtx_Request *request)
 {
-	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	cl_program prog;
-	cl_context cont;
-	cl_command_queue queue;
-	if (opencl_num_active_devices() > 0 &&
-		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
+	return split_over_devices(particles.size(), num_mes, request,
+		[&](cl_program prog, cl_command_queue queue,
+			int first, int count, cvtx_Request *req) {
 		return opencl_brute_force_P3D_M2M_vel_impl(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius,
-			prog, queue, cont);
-	}
-	else
-	{
-		return -1;
-	}
+			particles, mes_start + first, count, result_array + first, 
+			kernel, regularisation_radius, req, prog, queue);
+	});
+}
+
+/* The dvort family is split over the first num_induced induced particles. 
+The kernels only read the induced particles they are launched over, so a 
+leading part can use induced itself, and with it induced's accelerator 
+copy or the buffers it shares with particles. Other parts are copied. */
+template<typename ImplT>
+static int split_induced_over_devices(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	const int num_induced,
+	cvtx_Request *request,
+	ImplT impl)
+{
+	return split_over_devices(particles.size(), num_induced, request,
+		[&](cl_program prog, cl_command_queue queue,
+			int first, int count, cvtx_Request *req) {
+		if (first == 0 
+			&& (count == induced.size() || induced.device() != NULL)) {
+			return impl(induced, first, count, req, prog, queue);
+		}
+		P3DArray part(induced.view().offset(first), count);
+		return impl(part, first, count, req, prog, queue);
+	});
 }
 
 int opencl_brute_force_P3D_M2M_dvort(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
-	float regularisation_radius)
+	float regularisation_radius,
+	cvtx_Request *request)
 {
-	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	cl_program prog;
-	cl_context cont;
-	cl_command_queue queue;
-
-	if (opencl_num_active_devices() > 0 &&
-		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
+	return split_induced_over_devices(particles, induced, num_induced, 
+		request, [&](const P3DArray &part, int first, int count, 
+			cvtx_Request *req, cl_program prog, cl_command_queue queue) {
 		return opencl_brute_force_P3D_M2M_dvort_impl(
-			array_start, num_particles, induced_start,
-			num_induced, result_array, kernel, regularisation_radius,
-			prog, queue, cont);
-	}
-	else
-	{
-		return -1;
-	}
+			particles, part, count, result_array + first, kernel, 
+			regularisation_radius, req, prog, queue);
+	});
 }
 
 int opencl_brute_force_P3D_M2M_visc_dvort(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
-	const int num_induced,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc)
 {
-	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	cl_program prog;
-	cl_context cont;
-	cl_command_queue queue;
-
-	if (opencl_num_active_devices() > 0 &&
-		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
+	return split_induced_over_devices(particles, induced, induced.size(), 
+		NULL, [&](const P3DArray &part, int first, int count, 
+			cvtx_Request *req, cl_program prog, cl_command_queue queue) {
 		return opencl_brute_force_P3D_M2M_visc_dvort_impl(
-			array_start, num_particles, induced_start,
-			num_induced, result_array, kernel, regularisation_radius,
-			kinematic_visc, prog, queue, cont);
-	}
-	else
-	{
-		return -1;
-	}
+			particles, part, count, result_array + first, kernel, 
+			regularisation_radius, kinematic_visc, req, prog, queue);
+	});
+}
+
+int opencl_brute_force_P3D_M2M_vel_dvort_visc(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	return split_induced_over_devices(particles, induced, induced.size(), 
+		NULL, [&](const P3DArray &part, int first, int count, 
+			cvtx_Request *req, cl_program prog, cl_command_queue queue) {
+		return opencl_brute_force_P3D_M2M_vel_dvort_visc_impl(
+			particles, part, count, vel_result + first, dvort_result + first, 
+			visc_dvort_result + first, kernel, regularisation_radius, 
+			kinematic_visc, req, prog, queue);
+	});
 }
 
 int opencl_brute_force_P3D_M2M_vort(
-	const cvtx_P3D** array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
 	const cvtx_VortFunc* kernel,
 	float regularisation_radius)
 {
-	/* Right now we just use the first active device. */
-	assert(opencl_is_init());
-	cl_program prog;
-	cl_context cont;
-	cl_command_queue queue;
-
-	if (opencl_num_active_devices() > 0 &&
-		opencl_get_device_state(0, &prog, &cont, &queue) == 0) {
+	return split_over_devices(particles.size(), num_mes, NULL,
+		[&](cl_program prog, cl_command_queue queue,
+			int first, int count, cvtx_Request *req) {
 		return opencl_brute_force_P3D_M2M_vort_impl(
-			array_start, num_particles, mes_start,
-			num_mes, result_array, kernel, regularisation_radius,
-			prog, queue, cont);
+			particles, mes_start + first, count, result_array + first, 
+			kernel, regularisation_radius, req, prog, queue);
+	});
+}
+
+/* Helpers for the impls -----------------------------------------------------*/
+
+/* kernel_name_start followed by the regularisation's extension from the 
+device's cache, or NULL if the program doesn't have such a kernel. */
+static cl_kernel create_kernel(
+	OclDeviceState &device,
+	cl_program program,
+	const char *kernel_name_start,
+	const cvtx_VortFunc *kernel)
+{
+	std::string kernel_name(kernel_name_start);
+	kernel_name += kernel->cl_kernel_name_ext;
+	return device.kernel(program, kernel_name);
+}
+
+/* The accelerator copy of the particles if it is in context, otherwise 
+a copy made into tmp. NULL on failure. */
+static const OclP3DBuffers *particle_buffers(
+	const P3DArray &particles,
+	OclP3DBuffers &tmp,
+	OclDeviceState &device)
+{
+	const OclP3DBuffers *dev = particles.device();
+	if (dev != NULL && dev->context() == device.context()) {
+		return dev;
 	}
-	else
-	{
-		return -1;
+	return tmp.upload(particles.soa(), device) == 0 ? &tmp : NULL;
+}
+
+/* A pooled buffer of num float3s copied from points, or uninitialised if 
+points is NULL. Return it with device.release_buffer. */
+static cl_mem float3_buffer(
+	OclDeviceState &device,
+	const bsv_V3f *points,
+	int num,
+	cl_int *status)
+{
+	cl_mem buffer = device.acquire_buffer(sizeof(cl_float3) * num, status);
+	if (points == NULL || *status != CL_SUCCESS) {
+		return buffer;
+	}
+	std::vector<cl_float3> data(num);
+	int i;
+	for (i = 0; i < num; ++i) {
+		data[i].x = points[i].x[0];
+		data[i].y = points[i].x[1];
+		data[i].z = points[i].x[2];
+		data[i].w = 0.f;
 	}
+	*status = clEnqueueWriteBuffer(device.queue(), buffer, CL_TRUE, 0,
+		sizeof(cl_float3) * num, data.data(), 0, NULL, NULL);
+	return buffer;
 }
 
-/* This is *almost* identical to the vort impl so any bugs likely occur in both. */
-int opencl_brute_force_P3D_M2M_vel_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
+/* Set argument index of kernel, unless status says an earlier step has 
+already failed. Returns the status of whichever failed first. */
+static cl_int set_kernel_arg(
+	cl_kernel kernel,
+	cl_uint index,
+	size_t size,
+	const void *value,
+	cl_int status)
+{
+	if (status != CL_SUCCESS) { return status; }
+	return clSetKernelArg(kernel, index, size, value);
+}
+
+/* Run the kernel once over all the inducing particles, with arguments 0 
+and 1 set to their packed coordinates & volumes and vorticities, and
+argument num_particles_arg set to their number. Each workgroup loops over
+every particle for its induced particle / measurement point and writes
+its result, so the results buffer needn't be initialised. */
+static cl_int enqueue_particles(
+	OclDeviceState &device,
+	cl_kernel cl_kernel,
+	const OclP3DBuffers &particles,
+	int num_particles_arg,
+	int num_induced)
+{
+	size_t global_work_size[2], workgroup_size[2];
+	cl_mem args[2];
+	cl_uint num_particles = particles.size();
+	cl_int status = CL_SUCCESS;
+	int j;
+	/* This has to match the opencl kernels, so be careful with fiddling */
+	workgroup_size[0] = device.workgroup_size();	/* Work items per induced */
+	workgroup_size[1] = 1;	/* Only 1 induced / measure pos per workgroup. */
+	global_work_size[0] = device.workgroup_size();
+	global_work_size[1] = num_induced;
+	args[0] = particles.coords();
+	args[1] = particles.vorticities();
+	for (j = 0; j < 2; ++j) {
+		status = set_kernel_arg(cl_kernel, j, sizeof(cl_mem), args + j, 
+			status);
+	}
+	status = set_kernel_arg(cl_kernel, num_particles_arg, 
+		sizeof(cl_uint), &num_particles, status);
+	if (status != CL_SUCCESS) { return status; }
+	return clEnqueueNDRangeKernel(device.queue(), cl_kernel, 2,
+		NULL, global_work_size, workgroup_size, 0, NULL, NULL);
+}
+
+/* Read back num results, multiplying them by multiplyer. */
+static cl_int read_results(
+	cl_command_queue queue,
+	cl_mem res_buff,
+	int num,
+	float multiplyer,
+	bsv_V3f *result_array)
+{
+	std::vector<cl_float3> data(num);
+	cl_int status;
+	int i;
+	status = clEnqueueReadBuffer(queue, res_buff, CL_TRUE, 0,
+		sizeof(cl_float3) * num, data.data(), 0, NULL, NULL);
+	if (status == CL_SUCCESS) {
+		for (i = 0; i < num; ++i) {
+			result_array[i].x[0] = data[i].x * multiplyer;
+			result_array[i].x[1] = data[i].y * multiplyer;
+			result_array[i].x[2] = data[i].z * multiplyer;
+		}
+	}
+	return status;
+}
+
+/* The vel and vort impls only differ by kernel and constant. */
+static int P3D_M2M_mes_impl(
+	const char *kernel_name_start,
+	float constant_multiplyer,
+	const P3DArray &particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
-	char kernel_name[128] = "cvtx_nb_P3D_vel_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
-	float constant_multiplyer = 1.f / (4.f * acosf(-1));
-	size_t global_work_size[2], workgroup_size[2];
-	cl_float3 *mes_pos_buff_data, *part_pos_buff_data, *part_vort_buff_data, *res_buff_data;
-	cl_mem mes_pos_buff, res_buff, *part_pos_buff, *part_vort_buff;
+	OclP3DBuffers tmp_particles;
+	const OclP3DBuffers *part_buffs;
+	OclDeviceState *device;
+	cl_mem mes_pos_buff, res_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
-	cl_event *event_chain;
 
-	if (opencl_init() == 1)
-	{
-		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
-		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
-		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple particle buffers */
-		global_work_size[1] = num_mes;
-
-		/* Generate an buffer for the measurement position data  */
-		mes_pos_buff_data = (cl_float3*) malloc(num_mes * sizeof(cl_float3));
-		for (i = 0; i < num_mes; ++i) {
-			mes_pos_buff_data[i].x = mes_start[i].x[0];
-			mes_pos_buff_data[i].y = mes_start[i].x[1];
-			mes_pos_buff_data[i].z = mes_start[i].x[2];
-		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, mes_pos_buff, CL_FALSE,
-			0, num_mes * sizeof(cl_float3), mes_pos_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
-		if (status != CL_SUCCESS) {
-			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
-
-		cl_float cl_recip_regularisation_radius = 1.f/regularisation_radius;
-		status = clSetKernelArg(cl_kernel, 2, sizeof(cl_float), &cl_recip_regularisation_radius);
-		assert(status == CL_SUCCESS);
-
-		/* Generate a results buffer */
-		res_buff_data = (cl_float3*) malloc(num_mes * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_mes, NULL, &status);
-		for (i = 0; i < num_mes; ++i) {
-			res_buff_data[i].x = 0;
-			res_buff_data[i].y = 0;
-			res_buff_data[i].z = 0;
-		}
-		status = clEnqueueWriteBuffer(
-			queue, res_buff, CL_FALSE,
-			0, num_mes * sizeof(cl_float3), res_buff_data, 0, NULL, NULL);
-		if (status != CL_SUCCESS) {
-			assert(0);
-		}
-		status = clSetKernelArg(cl_kernel, 4, sizeof(cl_mem), &res_buff);
-		assert(status == CL_SUCCESS);
-
-		/* Now create & dispatch particle buffers and kernel. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
-			n_particle_groups += 1;
-		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
-		part_pos_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		part_vort_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		for (i = 0; i < num_particles; ++i) {
-			part_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part_pos_buff_data[i].z = array_start[i]->coord.x[2];
-			part_vort_buff_data[i].x = array_start[i]->vorticity.x[0];
-			part_vort_buff_data[i].y = array_start[i]->vorticity.x[1];
-			part_vort_buff_data[i].z = array_start[i]->vorticity.x[2];
-		}
-		/* We need this so that we always have the minimum workgroup size. */
-		for (i = num_particles; i < n_modelled_particles; ++i) {
-			part_pos_buff_data[i].x = 0;
-			part_pos_buff_data[i].y = 0;
-			part_pos_buff_data[i].z = 0;
-			part_vort_buff_data[i].x = 0;
-			part_vort_buff_data[i].y = 0;
-			part_vort_buff_data[i].z = 0;
-		}
-		part_pos_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		part_vort_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 3);
-		for (i = 0; i < n_particle_groups; ++i) {
-			part_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i);
-			assert(status == CL_SUCCESS);
-			part_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i + 1);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part_pos_buff + i);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 1, sizeof(cl_mem), part_vort_buff + i);
-			assert(status == CL_SUCCESS);
-			if (i == 0) {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 2, event_chain, event_chain + 3 * i + 2);
-			}
-			else {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 3, event_chain + 3 * i - 1, event_chain + 3 * i + 2);
-			}
-			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part_pos_buff[i]);
-			clReleaseMemObject(part_vort_buff[i]);
-		}
-
-		/* Read back our results! */
-		clEnqueueReadBuffer(queue, res_buff, CL_TRUE, 0,
-			sizeof(cl_float3) * num_mes, res_buff_data, 1,
-			event_chain + 3 * n_particle_groups - 1, NULL);
-		for (i = 0; i < n_particle_groups * 3; ++i) { clReleaseEvent(event_chain[i]); }
-		free(event_chain);	/* Its tempting to do this earlier, but remember, this is asynchonous! */
-		for (i = 0; i < num_mes; ++i) {
-			/* Constant multiplyer is constant the 1/4pi term. */
-			result_array[i].x[0] = res_buff_data[i].x * constant_multiplyer;
-			result_array[i].x[1] = res_buff_data[i].y * constant_multiplyer;
-			result_array[i].x[2] = res_buff_data[i].z * constant_multiplyer;
-		}
-		free(res_buff_data);
-
-		free(part_pos_buff);
-		free(part_vort_buff);
-		free(part_pos_buff_data);
-		free(part_vort_buff_data);
-		free(mes_pos_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseKernel(cl_kernel);
-		return 0;
+	if (opencl_load() < 0) { return -1; }
+	device = opencl_device_of_queue(queue);
+	if (device == NULL) { return -1; }
+	cl_kernel = create_kernel(*device, program, kernel_name_start, kernel);
+	if (cl_kernel == NULL) { return -1; }
+	std::lock_guard<std::mutex> launch(device->launch_mutex());
+	part_buffs = particle_buffers(particles, tmp_particles, *device);
+	if (part_buffs == NULL) { return -1; }
+	mes_pos_buff = float3_buffer(*device, mes_start, num_mes, &status);
+	res_buff = status == CL_SUCCESS ? 
+		float3_buffer(*device, NULL, num_mes, &status) : NULL;
+
+	cl_float cl_recip_regularisation_radius = 1.f / regularisation_radius;
+	status = set_kernel_arg(cl_kernel, 2, sizeof(cl_float), 
+		&cl_recip_regularisation_radius, status);
+	status = set_kernel_arg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff, 
+		status);
+	status = set_kernel_arg(cl_kernel, 4, sizeof(cl_mem), &res_buff, status);
+
+	if (status == CL_SUCCESS) {
+		status = enqueue_particles(*device, cl_kernel, *part_buffs, 5, 
+			num_mes);
 	}
-	else
-	{
-		return -1;
+	if (status == CL_SUCCESS && request != NULL) {
+		status = request->enqueue_read(queue, res_buff, num_mes,
+			constant_multiplyer, result_array);
 	}
+	else if (status == CL_SUCCESS) {
+		status = read_results(queue, res_buff, num_mes, 
+			constant_multiplyer, result_array);
+	}
+	device->release_buffer(mes_pos_buff);
+	device->release_buffer(res_buff);
+	return status == CL_SUCCESS ? 0 : -1;
+}
+
+/* The impls -----------------------------------------------------------------*/
+
+int opencl_brute_force_P3D_M2M_vel_impl(
+	const P3DArray &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	cvtx_Request *request,
+	cl_program program,
+	cl_command_queue queue)
+{
+	/* The kernel works in radius, so only 1/(4 pi) is left. */
+	return P3D_M2M_mes_impl("cvtx_nb_P3D_vel_", 1.f / (4.f * acosf(-1)),
+		particles, mes_start, num_mes, result_array, kernel, 
+		regularisation_radius, request, program, queue);
+}
+
+int opencl_brute_force_P3D_M2M_vort_impl(
+	const P3DArray &particles,
+	const bsv_V3f* mes_start,
+	const int num_mes,
+	bsv_V3f* result_array,
+	const cvtx_VortFunc* kernel,
+	float regularisation_radius,
+	cvtx_Request *request,
+	cl_program program,
+	cl_command_queue queue)
+{
+	return P3D_M2M_mes_impl("cvtx_nb_P3D_vort_", 
+		1.f / (4.f * acosf(-1) * powf(regularisation_radius, 3)),
+		particles, mes_start, num_mes, result_array, kernel, 
+		regularisation_radius, request, program, queue);
 }
 
 int opencl_brute_force_P3D_M2M_dvort_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
-	char kernel_name[128] = "cvtx_nb_P3D_dvort_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
+	/* 1/(4 pi reg_dist^3) is done host side. */
 	float constant_multiplyer = 1.f / (4.f * acosf(-1) * powf(regularisation_radius, 3));
-	size_t global_work_size[2], workgroup_size[2];
-	cl_float3 *part1_pos_buff_data, *part1_vort_buff_data, *part2_pos_buff_data, *part2_vort_buff_data, *res_buff_data;
-	cl_mem res_buff, *part1_pos_buff, *part1_vort_buff, part2_pos_buff, part2_vort_buff;
+	OclP3DBuffers tmp_particles, tmp_induced;
+	const OclP3DBuffers *part_buffs, *ind_buffs;
+	OclDeviceState *device;
+	cl_mem ind_pos_buff, ind_vort_buff, res_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
-	cl_event *event_chain;
 
-	if (opencl_init() == 1)
-	{
-		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
-		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
-		workgroup_size[1] = 1;	/* Only 1 induced particle pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple inducing particle buffers */
-		global_work_size[1] = num_induced;
-
-		/* Generate buffers for induced particle data  */
-		part2_pos_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		part2_vort_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		for (i = 0; i < num_induced; ++i) {
-			part2_pos_buff_data[i].x = induced_start[i]->coord.x[0];
-			part2_pos_buff_data[i].y = induced_start[i]->coord.x[1];
-			part2_pos_buff_data[i].z = induced_start[i]->coord.x[2];
-			part2_vort_buff_data[i].x = induced_start[i]->vorticity.x[0];
-			part2_vort_buff_data[i].y = induced_start[i]->vorticity.x[1];
-			part2_vort_buff_data[i].z = induced_start[i]->vorticity.x[2];
-		}
-		/* Induced particle Create buffer, enqueue write and set kernel arg. */
-		part2_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, part2_pos_buff, CL_FALSE,
-			0, num_induced * sizeof(cl_float3), part2_pos_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &part2_pos_buff);
-		assert(status == CL_SUCCESS);
-		part2_vort_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, part2_vort_buff, CL_FALSE,
-			0, num_induced * sizeof(cl_float3), part2_vort_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 4, sizeof(cl_mem), &part2_vort_buff);
-		assert(status == CL_SUCCESS);
-
-		/* Generate a results buffer										*/
-		res_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_induced, NULL, &status);
-		for (i = 0; i < num_induced; ++i) {
-			res_buff_data[i].x = 0;
-			res_buff_data[i].y = 0;
-			res_buff_data[i].z = 0;
-		}
-		status = clEnqueueWriteBuffer(
-			queue, res_buff, CL_FALSE,
-			0, num_induced * sizeof(cl_float3), res_buff_data, 0, NULL, NULL);
-		if (status != CL_SUCCESS) {
-			assert(0);
-		}
-		status = clSetKernelArg(cl_kernel, 5, sizeof(cl_mem), &res_buff);
-		assert(status == CL_SUCCESS);
-
-		cl_float cl_recip_regularisation_rad = 1.f/regularisation_radius;
-		status = clSetKernelArg(cl_kernel, 2, sizeof(cl_float), &cl_recip_regularisation_rad);
-		assert(status == CL_SUCCESS);
-
-		/* Now create & dispatch particle buffers and kernel.
-		Inducing particle count needs to be a multiple of the CVTX_WORKGROUP_SIZE,
-		so we add some zerod particles onto the end of the array. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
-			n_particle_groups += 1;
-		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
-		part1_pos_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		part1_vort_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		for (i = 0; i < num_particles; ++i) {
-			part1_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part1_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part1_pos_buff_data[i].z = array_start[i]->coord.x[2];
-			part1_vort_buff_data[i].x = array_start[i]->vorticity.x[0];
-			part1_vort_buff_data[i].y = array_start[i]->vorticity.x[1];
-			part1_vort_buff_data[i].z = array_start[i]->vorticity.x[2];
-		}
-		/* We need this so that we always have the minimum workgroup size. */
-		for (i = num_particles; i < n_modelled_particles; ++i) {
-			part1_pos_buff_data[i].x = 0;
-			part1_pos_buff_data[i].y = 0;
-			part1_pos_buff_data[i].z = 0;
-			part1_vort_buff_data[i].x = 0;
-			part1_vort_buff_data[i].y = 0;
-			part1_vort_buff_data[i].z = 0;
-		}
-		part1_pos_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		part1_vort_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 3);
-		for (i = 0; i < n_particle_groups; ++i) {
-			part1_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part1_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part1_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i);
-			assert(status == CL_SUCCESS);
-			part1_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part1_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part1_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i + 1);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part1_pos_buff + i);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 1, sizeof(cl_mem), part1_vort_buff + i);
-			assert(status == CL_SUCCESS);
-			if (i == 0) {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 2, event_chain + 3 * i, event_chain + 3 * i + 2);
-			}
-			else {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 3, event_chain + 3 * i - 1, event_chain + 3 * i + 2);
-			}
-			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part1_pos_buff[i]);
-			clReleaseMemObject(part1_vort_buff[i]);
-		}
-
-		/* Read back our results! */
-		clEnqueueReadBuffer(queue, res_buff, CL_TRUE, 0,
-			sizeof(cl_float3) * num_induced, res_buff_data, 1,
-			event_chain + 3 * n_particle_groups - 1, NULL);
-		for (i = 0; i < n_particle_groups * 3; ++i) { clReleaseEvent(event_chain[i]); }
-		free(event_chain);	/* Its tempting to do this earlier, but remember, this is asynchonous! */
-		for (i = 0; i < num_induced; ++i) {
-			/* We take the 1 / (4 pi * reg_dist^3) into account here as const mult. */
-			result_array[i].x[0] = res_buff_data[i].x * constant_multiplyer;
-			result_array[i].x[1] = res_buff_data[i].y * constant_multiplyer;
-			result_array[i].x[2] = res_buff_data[i].z * constant_multiplyer;
-		}
-		free(res_buff_data);
-
-		free(part1_pos_buff);
-		free(part1_vort_buff);
-		free(part2_pos_buff_data);
-		free(part2_vort_buff_data);
-		free(part1_pos_buff_data);
-		free(part1_vort_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(part2_pos_buff);
-		clReleaseMemObject(part2_vort_buff);
-		clReleaseKernel(cl_kernel);
-		return 0;
+	if (opencl_load() < 0) { return -1; }
+	device = opencl_device_of_queue(queue);
+	if (device == NULL) { return -1; }
+	cl_kernel = create_kernel(*device, program, "cvtx_nb_P3D_dvort_", kernel);
+	if (cl_kernel == NULL) { return -1; }
+	std::lock_guard<std::mutex> launch(device->launch_mutex());
+	part_buffs = particle_buffers(particles, tmp_particles, *device);
+	ind_buffs = &induced == &particles ? part_buffs :
+		particle_buffers(induced, tmp_induced, *device);
+	if (part_buffs == NULL || ind_buffs == NULL) { return -1; }
+	res_buff = float3_buffer(*device, NULL, num_induced, &status);
+
+	cl_float cl_recip_regularisation_rad = 1.f / regularisation_radius;
+	status = set_kernel_arg(cl_kernel, 2, sizeof(cl_float), 
+		&cl_recip_regularisation_rad, status);
+	ind_pos_buff = ind_buffs->coords();
+	status = set_kernel_arg(cl_kernel, 3, sizeof(cl_mem), &ind_pos_buff,
+		status);
+	ind_vort_buff = ind_buffs->vorticities();
+	status = set_kernel_arg(cl_kernel, 4, sizeof(cl_mem), &ind_vort_buff,
+		status);
+	status = set_kernel_arg(cl_kernel, 5, sizeof(cl_mem), &res_buff, status);
+
+	if (status == CL_SUCCESS) {
+		status = enqueue_particles(*device, cl_kernel, *part_buffs, 6,
+			num_induced);
 	}
-	else
-	{
-		return -1;
+	if (status == CL_SUCCESS && request != NULL) {
+		status = request->enqueue_read(queue, res_buff, num_induced,
+			constant_multiplyer, result_array);
 	}
+	else if (status == CL_SUCCESS) {
+		status = read_results(queue, res_buff, num_induced, 
+			constant_multiplyer, result_array);
+	}
+	device->release_buffer(res_buff);
+	return status == CL_SUCCESS ? 0 : -1;
 }
 
 int opencl_brute_force_P3D_M2M_visc_dvort_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
-	char kernel_name[128] = "cvtx_nb_P3D_visc_dvort_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
-	size_t global_work_size[2], workgroup_size[2];
-	cl_float3 *part1_pos_buff_data, *part1_vort_buff_data, *part2_pos_buff_data, *part2_vort_buff_data, *res_buff_data;
-	cl_float *part1_vol_buff_data, *part2_vol_buff_data;
-	cl_mem res_buff, *part1_pos_buff, *part1_vort_buff, *part1_vol_buff,
-		part2_pos_buff, part2_vort_buff, part2_vol_buff;
+	OclP3DBuffers tmp_particles, tmp_induced;
+	const OclP3DBuffers *part_buffs, *ind_buffs;
+	OclDeviceState *device;
+	cl_mem ind_pos_buff, ind_vort_buff, res_buff;
 	cl_int status;
 	cl_kernel cl_kernel;
-	cl_event *event_chain;
 
-	if (opencl_init() == 1)
-	{
-		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
-		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
-		workgroup_size[1] = 1;	/* Only 1 induced particle pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple inducing particle buffers */
-		global_work_size[1] = num_induced;
-
-		/* Generate buffers for induced particle data  */
-		part2_pos_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		part2_vort_buff_data = (cl_float3*) malloc(num_induced * sizeof(cl_float3));
-		part2_vol_buff_data = (cl_float*) malloc(num_induced * sizeof(cl_float));
-		for (i = 0; i < num_induced; ++i) {
-			part2_pos_buff_data[i].x = induced_start[i]->coord.x[0];
-			part2_pos_buff_data[i].y = induced_start[i]->coord.x[1];
-			part2_pos_buff_data[i].z = induced_start[i]->coord.x[2];
-			part2_vort_buff_data[i].x = induced_start[i]->vorticity.x[0];
-			part2_vort_buff_data[i].y = induced_start[i]->vorticity.x[1];
-			part2_vort_buff_data[i].z = induced_start[i]->vorticity.x[2];
-			part2_vol_buff_data[i] = induced_start[i]->volume;
-		}
-		/* Induced particle Create buffer, enqueue write and set kernel arg. */
-		part2_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, part2_pos_buff, CL_TRUE,
-			0, num_induced * sizeof(cl_float3), part2_pos_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &part2_pos_buff);
-		assert(status == CL_SUCCESS);
-		part2_vort_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, part2_vort_buff, CL_TRUE,
-			0, num_induced * sizeof(cl_float3), part2_vort_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 4, sizeof(cl_mem), &part2_vort_buff);
-		assert(status == CL_SUCCESS);
-		part2_vol_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_induced * sizeof(cl_float), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, part2_vol_buff, CL_TRUE,
-			0, num_induced * sizeof(cl_float), part2_vol_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 5, sizeof(cl_mem), &part2_vol_buff);
-		assert(status == CL_SUCCESS);
-
-		/* Generate a results buffer										*/
-		res_buff_data = (cl_float3*)malloc(num_induced * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_induced, NULL, &status);
-		for (i = 0; i < num_induced; ++i) {
-			res_buff_data[i].x = 0;
-			res_buff_data[i].y = 0;
-			res_buff_data[i].z = 0;
-		}
-		status = clEnqueueWriteBuffer(
-			queue, res_buff, CL_TRUE,
-			0, num_induced * sizeof(cl_float3), res_buff_data, 0, NULL, NULL);
-		if (status != CL_SUCCESS) {
-			assert(0);
-		}
-		status = clSetKernelArg(cl_kernel, 6, sizeof(cl_mem), &res_buff);
-		assert(status == CL_SUCCESS);
-
-		/* Setup the kinematic viscocity argument */
-		cl_float cl_regularisation_rad = regularisation_radius;
-		status = clSetKernelArg(cl_kernel, 7, sizeof(cl_float), &cl_regularisation_rad);
-		assert(status == CL_SUCCESS);
-		cl_float cl_kinem_visc = kinematic_visc;
-		status = clSetKernelArg(cl_kernel, 8, sizeof(cl_float), &cl_kinem_visc);
-		assert(status == CL_SUCCESS);
-
-		/* Now create & dispatch particle buffers and kernel.
-		Inducing particle count needs to be a multiple of the CVTX_WORKGROUP_SIZE,
-		so we add some zerod particles onto the end of the array. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
-			n_particle_groups += 1;
-		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
-		part1_pos_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		part1_vort_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		part1_vol_buff_data = (cl_float*) malloc(n_modelled_particles * sizeof(cl_float));
-		for (i = 0; i < num_particles; ++i) {
-			part1_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part1_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part1_pos_buff_data[i].z = array_start[i]->coord.x[2];
-			part1_vort_buff_data[i].x = array_start[i]->vorticity.x[0];
-			part1_vort_buff_data[i].y = array_start[i]->vorticity.x[1];
-			part1_vort_buff_data[i].z = array_start[i]->vorticity.x[2];
-			part1_vol_buff_data[i] = array_start[i]->volume;
-		}
-		/* We need this so that we always have the minimum workgroup size. */
-		for (i = num_particles; i < n_modelled_particles; ++i) {
-			part1_pos_buff_data[i].x = 0;
-			part1_pos_buff_data[i].y = 0;
-			part1_pos_buff_data[i].z = 0;
-			part1_vort_buff_data[i].x = 0;
-			part1_vort_buff_data[i].y = 0;
-			part1_vort_buff_data[i].z = 0;
-			part1_vol_buff_data[i] = 0;
-		}
-		part1_pos_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		part1_vort_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		part1_vol_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 4);
-		for (i = 0; i < n_particle_groups; ++i) {
-			part1_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part1_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part1_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i);
-			assert(status == CL_SUCCESS);
-			part1_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part1_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part1_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 1);
-			assert(status == CL_SUCCESS);
-			part1_vol_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part1_vol_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float),
-				part1_vol_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 4 * i + 2);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part1_pos_buff + i);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 1, sizeof(cl_mem), part1_vort_buff + i);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 2, sizeof(cl_mem), part1_vol_buff + i);
-			assert(status == CL_SUCCESS);
-			if (i == 0) {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 3, event_chain + 4 * i, event_chain + 4 * i + 3);
-			}
-			else {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 4, event_chain + 4 * i - 1, event_chain + 4 * i + 3);
-			}
-			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part1_pos_buff[i]);
-			clReleaseMemObject(part1_vort_buff[i]);
-			clReleaseMemObject(part1_vol_buff[i]);
-		}
-
-		/* Read back our results! */
-		clEnqueueReadBuffer(queue, res_buff, CL_TRUE, 0,
-			sizeof(cl_float3) * num_induced, res_buff_data, 1,
-			event_chain + 4 * n_particle_groups - 1, NULL);
-		for (i = 0; i < n_particle_groups * 4; ++i) { clReleaseEvent(event_chain[i]); }
-		free(event_chain);	/* Its tempting to do this earlier, but remember, this is asynchonous! */
-		for (i = 0; i < num_induced; ++i) {
-			result_array[i].x[0] = res_buff_data[i].x;
-			result_array[i].x[1] = res_buff_data[i].y;
-			result_array[i].x[2] = res_buff_data[i].z;
-		}
-		free(res_buff_data);
-
-		free(part1_pos_buff);
-		free(part1_vort_buff);
-		free(part1_vol_buff);
-		free(part2_pos_buff_data);
-		free(part2_vort_buff_data);
-		free(part2_vol_buff_data);
-		free(part1_pos_buff_data);
-		free(part1_vort_buff_data);
-		free(part1_vol_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(part2_pos_buff);
-		clReleaseMemObject(part2_vort_buff);
-		clReleaseMemObject(part2_vol_buff);
-		clReleaseKernel(cl_kernel);
-		return 0;
+	if (opencl_load() < 0) { return -1; }
+	device = opencl_device_of_queue(queue);
+	if (device == NULL) { return -1; }
+	cl_kernel = create_kernel(*device, program, "cvtx_nb_P3D_visc_dvort_", kernel);
+	if (cl_kernel == NULL) { return -1; }
+	std::lock_guard<std::mutex> launch(device->launch_mutex());
+	part_buffs = particle_buffers(particles, tmp_particles, *device);
+	ind_buffs = &induced == &particles ? part_buffs :
+		particle_buffers(induced, tmp_induced, *device);
+	if (part_buffs == NULL || ind_buffs == NULL) { return -1; }
+	res_buff = float3_buffer(*device, NULL, num_induced, &status);
+
+	/* The volumes are packed with the coordinates. */
+	ind_pos_buff = ind_buffs->coords();
+	status = set_kernel_arg(cl_kernel, 2, sizeof(cl_mem), &ind_pos_buff,
+		status);
+	ind_vort_buff = ind_buffs->vorticities();
+	status = set_kernel_arg(cl_kernel, 3, sizeof(cl_mem), &ind_vort_buff,
+		status);
+	status = set_kernel_arg(cl_kernel, 4, sizeof(cl_mem), &res_buff, status);
+	cl_float cl_regularisation_rad = regularisation_radius;
+	status = set_kernel_arg(cl_kernel, 5, sizeof(cl_float), 
+		&cl_regularisation_rad, status);
+	cl_float cl_kinem_visc = kinematic_visc;
+	status = set_kernel_arg(cl_kernel, 6, sizeof(cl_float), &cl_kinem_visc,
+		status);
+
+	if (status == CL_SUCCESS) {
+		status = enqueue_particles(*device, cl_kernel, *part_buffs, 7,
+			num_induced);
 	}
-	else
-	{
-		return -1;
+	/* The kernel applies the constant itself. */
+	if (status == CL_SUCCESS && request != NULL) {
+		status = request->enqueue_read(queue, res_buff, num_induced,
+			1.f, result_array);
+	}
+	else if (status == CL_SUCCESS) {
+		status = read_results(queue, res_buff, num_induced, 
+			1.f, result_array);
 	}
+	device->release_buffer(res_buff);
+	return status == CL_SUCCESS ? 0 : -1;
 }
 
-/* This is *almost* identical to the vel impl so any bugs likely occur in both. */
-int opencl_brute_force_P3D_M2M_vort_impl(
-	const cvtx_P3D** array_start,
-	const int num_particles,
-	const bsv_V3f* mes_start,
-	const int num_mes,
-	bsv_V3f* result_array,
-	const cvtx_VortFunc* kernel,
+int opencl_brute_force_P3D_M2M_vel_dvort_visc_impl(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	const int num_induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
+	float kinematic_visc,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context)
+	cl_command_queue queue)
 {
-	char kernel_name[128] = "cvtx_nb_P3D_vort_";
-	int i, n_particle_groups, n_zeroed_particles, n_modelled_particles;
+	/* vel and dvort are both 1 / (4 pi reg_dist^3) as the kernel works in rho. */
 	float constant_multiplyer = 1.f / (4.f * acosf(-1) * powf(regularisation_radius, 3));
-	size_t global_work_size[2], workgroup_size[2];
-	cl_float3* mes_pos_buff_data, * part_pos_buff_data, * part_vort_buff_data, * res_buff_data;
-	cl_mem mes_pos_buff, res_buff, * part_pos_buff, * part_vort_buff;
+	float visc_multiplyer = 2 * kinematic_visc / powf(regularisation_radius, 2);
+	bsv_V3f *results[3] = { vel_result, dvort_result, visc_dvort_result };
+	float multiplyers[3] = { constant_multiplyer, constant_multiplyer, visc_multiplyer };
+	OclP3DBuffers tmp_particles, tmp_induced;
+	const OclP3DBuffers *part_buffs, *ind_buffs;
+	OclDeviceState *device;
+	cl_mem ind_pos_buff, ind_vort_buff, res_buff[3];
 	cl_int status;
 	cl_kernel cl_kernel;
-	cl_event* event_chain;
-
-	if (opencl_init() == 1)
-	{
-		strncat(kernel_name, kernel->cl_kernel_name_ext, 32);
-		cl_kernel = clCreateKernel(program, kernel_name, &status);
-		if (status != CL_SUCCESS) {
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
-		/* This has to match the opencl kernels, so be careful with fiddling */
-		workgroup_size[0] = CVTX_WORKGROUP_SIZE;	/* Particles per group */
-		workgroup_size[1] = 1;	/* Only 1 measure pos per workgroup. */
-		global_work_size[0] = CVTX_WORKGROUP_SIZE;	/* We use multiple particle buffers */
-		global_work_size[1] = num_mes;
-
-		/* Generate an buffer for the measurement position data  */
-		mes_pos_buff_data = (cl_float3*) malloc(num_mes * sizeof(cl_float3));
-		for (i = 0; i < num_mes; ++i) {
-			mes_pos_buff_data[i].x = mes_start[i].x[0];
-			mes_pos_buff_data[i].y = mes_start[i].x[1];
-			mes_pos_buff_data[i].z = mes_start[i].x[2];
-		}
-		mes_pos_buff = clCreateBuffer(context,
-			CL_MEM_READ_ONLY, num_mes * sizeof(cl_float3), NULL, &status);
-		status = clEnqueueWriteBuffer(
-			queue, mes_pos_buff, CL_FALSE,
-			0, num_mes * sizeof(cl_float3), mes_pos_buff_data, 0, NULL, NULL);
-		assert(status == CL_SUCCESS);
-		status = clSetKernelArg(cl_kernel, 3, sizeof(cl_mem), &mes_pos_buff);
-		if (status != CL_SUCCESS) {
-			free(mes_pos_buff_data);
-			clReleaseMemObject(mes_pos_buff);
-			clReleaseKernel(cl_kernel);
-			return -1;
-		}
+	int j;
+
+	if (opencl_load() < 0) { return -1; }
+	device = opencl_device_of_queue(queue);
+	if (device == NULL) { return -1; }
+	cl_kernel = create_kernel(*device, program, "cvtx_nb_P3D_vel_dvort_visc_", kernel);
+	if (cl_kernel == NULL) { return -1; }
+	std::lock_guard<std::mutex> launch(device->launch_mutex());
+	part_buffs = particle_buffers(particles, tmp_particles, *device);
+	ind_buffs = &induced == &particles ? part_buffs :
+		particle_buffers(induced, tmp_induced, *device);
+	if (part_buffs == NULL || ind_buffs == NULL) { return -1; }
+
+	ind_pos_buff = ind_buffs->coords();
+	status = clSetKernelArg(cl_kernel, 2, sizeof(cl_mem), &ind_pos_buff);
+	ind_vort_buff = ind_buffs->vorticities();
+	status = set_kernel_arg(cl_kernel, 3, sizeof(cl_mem), &ind_vort_buff,
+		status);
+	for (j = 0; j < 3; ++j) {
+		res_buff[j] = status == CL_SUCCESS ?
+			float3_buffer(*device, NULL, num_induced, &status) : NULL;
+		status = set_kernel_arg(cl_kernel, 4 + j, sizeof(cl_mem), 
+			res_buff + j, status);
+	}
+	cl_float cl_recip_regularisation_rad = 1.f / regularisation_radius;
+	status = set_kernel_arg(cl_kernel, 7, sizeof(cl_float), 
+		&cl_recip_regularisation_rad, status);
 
-		cl_float cl_recip_regularisation_radius = 1.f / regularisation_radius;
-		status = clSetKernelArg(cl_kernel, 2, sizeof(cl_float), &cl_recip_regularisation_radius);
-		assert(status == CL_SUCCESS);
-
-		/* Generate a results buffer */
-		res_buff_data = (cl_float3*) malloc(num_mes * sizeof(cl_float3));
-		res_buff = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			sizeof(cl_float3) * num_mes, NULL, &status);
-		for (i = 0; i < num_mes; ++i) {
-			res_buff_data[i].x = 0;
-			res_buff_data[i].y = 0;
-			res_buff_data[i].z = 0;
-		}
-		status = clEnqueueWriteBuffer(
-			queue, res_buff, CL_FALSE,
-			0, num_mes * sizeof(cl_float3), res_buff_data, 0, NULL, NULL);
-		if (status != CL_SUCCESS) {
-			assert(0);
-		}
-		status = clSetKernelArg(cl_kernel, 4, sizeof(cl_mem), &res_buff);
-		assert(status == CL_SUCCESS);
-
-		/* Now create & dispatch particle buffers and kernel. */
-		n_particle_groups = num_particles / CVTX_WORKGROUP_SIZE;
-		if (num_particles % CVTX_WORKGROUP_SIZE) {
-			n_zeroed_particles = CVTX_WORKGROUP_SIZE
-				- num_particles % CVTX_WORKGROUP_SIZE;
-			n_particle_groups += 1;
-		}
-		n_modelled_particles = CVTX_WORKGROUP_SIZE * n_particle_groups;
-		part_pos_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		part_vort_buff_data = (cl_float3*) malloc(n_modelled_particles * sizeof(cl_float3));
-		for (i = 0; i < num_particles; ++i) {
-			part_pos_buff_data[i].x = array_start[i]->coord.x[0];
-			part_pos_buff_data[i].y = array_start[i]->coord.x[1];
-			part_pos_buff_data[i].z = array_start[i]->coord.x[2];
-			part_vort_buff_data[i].x = array_start[i]->vorticity.x[0];
-			part_vort_buff_data[i].y = array_start[i]->vorticity.x[1];
-			part_vort_buff_data[i].z = array_start[i]->vorticity.x[2];
-		}
-		/* We need this so that we always have the minimum workgroup size. */
-		for (i = num_particles; i < n_modelled_particles; ++i) {
-			part_pos_buff_data[i].x = 0;
-			part_pos_buff_data[i].y = 0;
-			part_pos_buff_data[i].z = 0;
-			part_vort_buff_data[i].x = 0;
-			part_vort_buff_data[i].y = 0;
-			part_vort_buff_data[i].z = 0;
-		}
-		part_pos_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		part_vort_buff = (cl_mem*) malloc(n_particle_groups * sizeof(cl_mem));
-		event_chain = (cl_event*) malloc(sizeof(cl_event) * n_particle_groups * 3);
-		for (i = 0; i < n_particle_groups; ++i) {
-			part_pos_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part_pos_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part_pos_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i);
-			assert(status == CL_SUCCESS);
-			part_vort_buff[i] = clCreateBuffer(context,
-				CL_MEM_READ_ONLY, CVTX_WORKGROUP_SIZE * sizeof(cl_float3), NULL, &status);
-			assert(status == CL_SUCCESS);
-			status = clEnqueueWriteBuffer(
-				queue, part_vort_buff[i], CL_FALSE,
-				0, CVTX_WORKGROUP_SIZE * sizeof(cl_float3),
-				part_vort_buff_data + i * CVTX_WORKGROUP_SIZE, 0, NULL, event_chain + 3 * i + 1);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 0, sizeof(cl_mem), part_pos_buff + i);
-			assert(status == CL_SUCCESS);
-			status = clSetKernelArg(cl_kernel, 1, sizeof(cl_mem), part_vort_buff + i);
-			assert(status == CL_SUCCESS);
-			if (i == 0) {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 2, event_chain, event_chain + 3 * i + 2);
-			}
-			else {
-				status = clEnqueueNDRangeKernel(queue, cl_kernel, 2,
-					NULL, global_work_size, workgroup_size, 3, event_chain + 3 * i - 1, event_chain + 3 * i + 2);
-			}
-			assert(status == CL_SUCCESS);
-			clReleaseMemObject(part_pos_buff[i]);
-			clReleaseMemObject(part_vort_buff[i]);
+	if (status == CL_SUCCESS) {
+		status = enqueue_particles(*device, cl_kernel, *part_buffs, 8,
+			num_induced);
+	}
+	for (j = 0; j < 3; ++j) {
+		if (status == CL_SUCCESS && request != NULL) {
+			status = request->enqueue_read(queue, res_buff[j], 
+				num_induced, multiplyers[j], results[j]);
 		}
-
-		/* Read back our results! */
-		clEnqueueReadBuffer(queue, res_buff, CL_TRUE, 0,
-			sizeof(cl_float3) * num_mes, res_buff_data, 1,
-			event_chain + 3 * n_particle_groups - 1, NULL);
-		for (i = 0; i < n_particle_groups * 3; ++i) { clReleaseEvent(event_chain[i]); }
-		free(event_chain);	/* Its tempting to do this earlier, but remember, this is asynchonous! */
-		for (i = 0; i < num_mes; ++i) {
-			/* Constant multiplyer is constant the 1/4pi term. */
-			result_array[i].x[0] = res_buff_data[i].x * constant_multiplyer;
-			result_array[i].x[1] = res_buff_data[i].y * constant_multiplyer;
-			result_array[i].x[2] = res_buff_data[i].z * constant_multiplyer;
+		else if (status == CL_SUCCESS) {
+			status = read_results(queue, res_buff[j], num_induced,
+				multiplyers[j], results[j]);
 		}
-		free(res_buff_data);
-
-		free(part_pos_buff);
-		free(part_vort_buff);
-		free(part_pos_buff_data);
-		free(part_vort_buff_data);
-		free(mes_pos_buff_data);
-		clReleaseMemObject(res_buff);
-		clReleaseMemObject(mes_pos_buff);
-		clReleaseKernel(cl_kernel);
-		return 0;
-	}
-	else
-	{
-		return -1;
+		device->release_buffer(res_buff[j]);
 	}
+	return status == CL_SUCCESS ? 0 : -1;
 }
 
 #endif /* CVTX_USING_OPENCL */
@@ -29,38 +29,56 @@ SOFTWARE.
 #ifdef CVTX_USING_OPENCL
 #include <bsv/bsv.h>
 #include "opencl_acc.h"
+#include "P3D_soa.h"
+#include "Request.h"
+
+/* The particle arguments use the accelerator copy of a cvtx_P3D_soa 
+where there is one, and are otherwise copied to the device per call. 
+Given a request, the vel and dvort functions read results back without 
+blocking and write them when the request is waited on. With a NULL 
+request they block until the results are written. The work is split over 
+all the active devices by measurement point / induced particle, in 
+proportion to each device's measured throughput. */
 
 int opencl_brute_force_P3D_M2M_vel(
-	const cvtx_P3D **array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
-	float regularisation_radius);
+	float regularisation_radius,
+	cvtx_Request *request);
 
+/* Evaluates the first num_induced of induced. */
 int opencl_brute_force_P3D_M2M_dvort(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
-	float regularisation_radius);
+	float regularisation_radius,
+	cvtx_Request *request);
 
 int opencl_brute_force_P3D_M2M_visc_dvort(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
-	const int num_induced,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc);
 
+int opencl_brute_force_P3D_M2M_vel_dvort_visc(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
 int opencl_brute_force_P3D_M2M_vort(
-	const cvtx_P3D** array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
@@ -68,53 +86,63 @@ int opencl_brute_force_P3D_M2M_vort(
 	float regularisation_radius);
 
 int opencl_brute_force_P3D_M2M_vel_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f *mes_start,
 	const int num_mes,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 int opencl_brute_force_P3D_M2M_dvort_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 int opencl_brute_force_P3D_M2M_visc_dvort_impl(
-	const cvtx_P3D **array_start,
-	const int num_particles,
-	const cvtx_P3D **induced_start,
+	const P3DArray &particles,
+	const P3DArray &induced,
 	const int num_induced,
 	bsv_V3f *result_array,
 	const cvtx_VortFunc *kernel,
 	float regularisation_radius,
 	float kinematic_visc,
+	cvtx_Request *request,
+	cl_program program,
+	cl_command_queue queue);
+
+int opencl_brute_force_P3D_M2M_vel_dvort_visc_impl(
+	const P3DArray &particles,
+	const P3DArray &induced,
+	const int num_induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 int opencl_brute_force_P3D_M2M_vort_impl(
-	const cvtx_P3D** array_start,
-	const int num_particles,
+	const P3DArray &particles,
 	const bsv_V3f* mes_start,
 	const int num_mes,
 	bsv_V3f* result_array,
 	const cvtx_VortFunc* kernel,
 	float regularisation_radius,
+	cvtx_Request *request,
 	cl_program program,
-	cl_command_queue queue,
-	cl_context context);
+	cl_command_queue queue);
 
 #endif /* CVTX_USING_OPENCL */
 #endif /* CVTX_OCL_P3D_H */
@@ -26,10 +26,15 @@ SOFTWARE.
 ============================================================================*/
 #ifdef CVTX_USING_OPENCL
 
+#include <atomic>
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
 
+#include "DispatchProfile.h"
 #include "OclDeviceState.h"
 #include "OclPlatformState.h"
 
@@ -48,32 +53,70 @@ static struct {
 		std::vector<OclPlatformState>(),
 		std::vector<OclActiveDevice>() };
 
+/* Program binary cache directory set by the user, if they have. */
+static struct {
+	bool set;
+	std::string directory;
+} program_cache = { false, "" };
+
 /* Returns number of platforms and loads them into the ocl_state. 
 -1 for error.*/
 static int load_platforms();
 
+/* Platforms may be loaded on a background thread, so loading is guarded 
+and the result published through loaded. */
+static struct OclLoading {
+	std::mutex mutex;
+	std::thread thread;
+	std::atomic<bool> loaded;
+	int good;
+	/* A joinable thread can't be destroyed, even after it has finished. */
+	~OclLoading() { if (thread.joinable()) { thread.join(); } }
+} ocl_loading;
+
 int opencl_init() {
-	static int tried_init = 0;
-	static int good = 0;
-	if (tried_init == 0 || (tried_init==1 && ocl_state.initialised == 0)) {
-		tried_init = 1;
-		ocl_state.initialised = 1;
-		ocl_state.platforms.clear();
-		ocl_state.active_devices.clear();
-		good = load_platforms();
+	return opencl_load();
+}
+
+int opencl_load() {
+	if (!ocl_loading.loaded.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(ocl_loading.mutex);
+		if (!ocl_loading.loaded.load(std::memory_order_relaxed)) {
+			ocl_state.initialised = 1;
+			ocl_state.platforms.clear();
+			ocl_state.active_devices.clear();
+			ocl_loading.good = load_platforms();
+			opencl_enable_default_accelerator();
+			ocl_loading.loaded.store(true, std::memory_order_release);
+			/* Still under the lock so that calibration happens once, after 
+			marking the load done since calibrating calls opencl_load. */
+			dispatch_load_profile();
+		}
+	}
+	return ocl_loading.good;
+}
+
+void opencl_load_in_background() {
+	std::lock_guard<std::mutex> lock(ocl_loading.mutex);
+	if (!ocl_loading.loaded.load(std::memory_order_relaxed)
+		&& !ocl_loading.thread.joinable()) {
+		ocl_loading.thread = std::thread(opencl_load);
 	}
-	opencl_enable_default_accelerator();
-	return good;
 }
 
 int opencl_is_init() {
-	return ocl_state.initialised;
+	return ocl_loading.loaded.load(std::memory_order_acquire) ? 1 : 0;
 }
 
 void opencl_finalise() {
+	if (ocl_loading.thread.joinable()) {
+		ocl_loading.thread.join();
+	}
+	std::lock_guard<std::mutex> lock(ocl_loading.mutex);
 	ocl_state.platforms.clear(); 
 	ocl_state.active_devices.clear();
 	ocl_state.initialised = false;
+	ocl_loading.loaded.store(false, std::memory_order_release);
 	assert(ocl_state.platforms.size() == 0);
 }
 
@@ -226,9 +269,12 @@ int opencl_get_device_state(
 		else
 		{
 			retv = 0;
-			*program = ocl_state.platforms[pidx].program();
+			/* Each device uses the program variant tuned for it. */
+			OclDeviceState &device = ocl_state.platforms[pidx].device(didx);
+			*program = device.program() != NULL ? device.program()
+				: ocl_state.platforms[pidx].program();
 			*context = ocl_state.platforms[pidx].context();
-			*queue = ocl_state.platforms[pidx].device(didx).queue();
+			*queue = device.queue();
 		}
 	}
 	else
@@ -238,6 +284,50 @@ int opencl_get_device_state(
 	return retv;
 }
 
+OclDeviceState *opencl_device_of_queue(cl_command_queue queue) {
+	int i;
+	if (ocl_state.initialised != 1 || queue == NULL) {
+		return NULL;
+	}
+	for (OclPlatformState &platform : ocl_state.platforms) {
+		for (i = 0; i < platform.number_of_devices(); ++i) {
+			if (platform.device(i).queue() == queue) {
+				return &platform.device(i);
+			}
+		}
+	}
+	return NULL;
+}
+
+void opencl_finish_context(cl_context context) {
+	int i;
+	if (ocl_state.initialised != 1 || context == NULL) {
+		return;
+	}
+	for (OclPlatformState &platform : ocl_state.platforms) {
+		for (i = 0; i < platform.number_of_devices(); ++i) {
+			OclDeviceState &device = platform.device(i);
+			if (device.context() == context && device.queue() != NULL) {
+				clFinish(device.queue());
+			}
+		}
+	}
+}
+
+void opencl_set_program_cache_dir(const char *directory) {
+	program_cache.set = directory != NULL;
+	program_cache.directory = directory != NULL ? directory : "";
+}
+
+std::string opencl_program_cache_dir() {
+	const char *env;
+	if (program_cache.set) {
+		return program_cache.directory;
+	}
+	env = getenv("CVTX_ACCELERATOR_CACHE_DIR");
+	return env != NULL ? env : "";
+}
+
 const char* opencl_accelerator_name(int lindex) {
 	const char* res = NULL;
 	int pidx, didx;
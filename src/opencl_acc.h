@@ -37,12 +37,23 @@ SOFTWARE.
 
 #define CVTX_WORKGROUP_SIZE 256
 
+class OclDeviceState;
+
 /* 
 Make OpenCL code ready to use by initialising devices, platforms etc.
 Returns 0 if finding devices and compiling OpenCL code goes to plan.
 */
 int opencl_init();
 
+/* Find the devices, build the programs and enable the default device if 
+that hasn't happened yet, waiting for a background load to finish if there 
+is one. Returns the number of platforms, or -1 on failure. */
+int opencl_load();
+
+/* Start opencl_load on a background thread, so that it may be done by 
+the time a device is wanted. */
+void opencl_load_in_background();
+
 /* Check that OpenCL stuff has been initialised
 Returns 1 if good, 0 otherwise.*/
 int opencl_is_init();
@@ -90,6 +101,22 @@ int opencl_get_device_state(
 	cl_context *context,
 	cl_command_queue *queue);
 
+/* The device that owns queue, for its kernel and buffer caches, or NULL 
+if no initialised device does. */
+OclDeviceState *opencl_device_of_queue(cl_command_queue queue);
+
+/* Wait for the work queued on every device of context to finish. */
+void opencl_finish_context(cl_context context);
+
+/* Set the directory compiled programs are cached in. Only affects 
+programs built after the call. NULL reverts to the 
+CVTX_ACCELERATOR_CACHE_DIR environment variable, and "" disables the 
+cache. */
+void opencl_set_program_cache_dir(const char *directory);
+
+/* The directory compiled programs are cached in, or "" if disabled. */
+std::string opencl_program_cache_dir();
+
 /* Get the name of an accelerator by linear index. */
 const char* opencl_accelerator_name(int lindex);
 
@@ -0,0 +1,143 @@
+#include "self_P3D.h"
+/*============================================================================
+self_P3D.cpp
+
+Methods for the interaction of a set of 3D vortex particles with itself
+that evaluate each antisymmetric pairwise interaction once.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "VortFuncPolicy.h"
+#include "tiled_M2M.h"
+
+#define CVTX_PI_F 3.14159265359f
+
+/* Evaluates func(i, j), the effect of particle j on particle i, for each
+pair i < j once. The effect of i on j is taken to be -func(i, j). The 
+pairs are scheduled by tiled_self_interaction. */
+template<typename PairFunc>
+static void antisymmetric_self_interaction(
+	int num_particles, bsv_V3f *result_array, PairFunc func)
+{
+	std::vector<double> acc(3 * (size_t)num_particles, 0.);
+	tiled_self_interaction(num_particles, 
+		[&](int a_begin, int a_end, int b_begin, int b_end) {
+		for (int i = a_begin; i < a_end; ++i) {
+			double rx = 0, ry = 0, rz = 0;
+			int j = a_begin == b_begin ? i + 1 : b_begin;
+			for (; j < b_end; ++j) {
+				bsv_V3f d = func(i, j);
+				rx += d.x[0];
+				ry += d.x[1];
+				rz += d.x[2];
+				acc[3 * j] -= d.x[0];
+				acc[3 * j + 1] -= d.x[1];
+				acc[3 * j + 2] -= d.x[2];
+			}
+			acc[3 * i] += rx;
+			acc[3 * i + 1] += ry;
+			acc[3 * i + 2] += rz;
+		}
+	});
+
+	int i;
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < num_particles; ++i) {
+		bsv_V3f r = { (float)acc[3 * i], (float)acc[3 * i + 1], 
+			(float)acc[3 * i + 2] };
+		result_array[i] = r;
+	}
+	return;
+}
+
+void cpu_pairwise_P3D_self_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	assert(num_particles >= 0);
+	std::vector<cvtx_P3D> particles(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		particles[i] = array_start[i];
+	}
+	/* As cvtx_P3D_S2S_dvort, with the constants hoisted. */
+	const float rsigma = 1.f / regularisation_radius;
+	const float t1 = rsigma * rsigma * rsigma / (4.f * CVTX_PI_F);
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		antisymmetric_self_interaction(num_particles, result_array,
+			[&](int i, int j) {
+				const cvtx_P3D &pi = particles[i], &pj = particles[j];
+				if (bsv_V3f_isequal(pi.coord, pj.coord)) { return bsv_V3f_zero(); }
+				bsv_V3f rad = bsv_V3f_minus(pi.coord, pj.coord);
+				bsv_V3f cross_om = bsv_V3f_cross(pi.vorticity, pj.vorticity);
+				float radd2 = bsv_V3f_dot(rad, rad);
+				float rho = sqrtf(radd2) * rsigma;
+				float g, f;
+				vortfunc.combined_3D(rho, &g, &f);
+				float grho3 = g / (rho * rho * rho);
+				float t22 = -(3.f * grho3 - f) * bsv_V3f_dot(rad, cross_om) / radd2;
+				bsv_V3f ret = bsv_V3f_plus(
+					bsv_V3f_mult(cross_om, grho3), bsv_V3f_mult(rad, t22));
+				return bsv_V3f_mult(ret, t1);
+			});
+	});
+	return;
+}
+
+void cpu_pairwise_P3D_self_visc_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	assert(num_particles >= 0);
+	std::vector<cvtx_P3D> particles(num_particles);
+	for (int i = 0; i < num_particles; ++i) {
+		particles[i] = array_start[i];
+	}
+	assert(kernel->eta_3D != NULL && "Used vortex regularisation"
+		"that did have a defined eta function");
+	/* As cvtx_P3D_S2S_visc_dvort, with the constants hoisted. */
+	const float rsigma = 1.f / regularisation_radius;
+	const float t1 = 2.f * kinematic_visc * rsigma * rsigma;
+	with_vortfunc_3D(kernel, [&](const auto &vortfunc) {
+		antisymmetric_self_interaction(num_particles, result_array,
+			[&](int i, int j) {
+				const cvtx_P3D &pi = particles[i], &pj = particles[j];
+				if (bsv_V3f_isequal(pi.coord, pj.coord)) { return bsv_V3f_zero(); }
+				bsv_V3f rad = bsv_V3f_minus(pj.coord, pi.coord);
+				float rho = bsv_V3f_abs(rad) * rsigma;
+				bsv_V3f t21 = bsv_V3f_minus(bsv_V3f_mult(pj.vorticity, pi.volume),
+					bsv_V3f_mult(pi.vorticity, pj.volume));
+				return bsv_V3f_mult(t21, t1 * vortfunc.eta_3D(rho));
+			});
+	});
+	return;
+}
@@ -0,0 +1,52 @@
+#ifndef CVTX_SELF_P3D_H
+#define CVTX_SELF_P3D_H
+#include "libcvtx.h"
+/*============================================================================
+self_P3D.h
+
+Methods for the interaction of a set of 3D vortex particles with itself
+that evaluate each antisymmetric pairwise interaction once.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <bsv/bsv.h>
+
+#include "ParticleView.h"
+
+/* Equivalent to cvtx_P3D_M2M_dvort with array_start == induced_start. */
+void cpu_pairwise_P3D_self_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+/* Equivalent to cvtx_P3D_M2M_visc_dvort with array_start == induced_start. */
+void cpu_pairwise_P3D_self_visc_dvort(
+	const P3DView &array_start,
+	const int num_particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+#endif /* CVTX_SELF_P3D_H */
@@ -0,0 +1,240 @@
+#include "simd_P3D.h"
+/*============================================================================
+simd_P3D.cpp
+
+Vectorised CPU evaluation of 3D vortex particle interactions for the
+built in regularisations.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include "VortFunc.h"
+#include "simd_P3D_impl.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#	include <immintrin.h>
+#	include <intrin.h>
+#endif
+
+enum SimdLevel {
+	SIMD_NONE,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+
+static SimdLevel detect_simd_level()
+{
+#if (defined(__GNUC__) || defined(__clang__)) \
+	&& (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) { return SIMD_AVX512; }
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return SIMD_AVX2;
+	}
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) { return SIMD_NONE; }
+	__cpuid(info, 1);
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave) { return SIMD_NONE; }
+	/* Check the OS saves the AVX (and AVX-512) registers. */
+	unsigned long long xcr0 = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	const bool avx2 = (info[1] & (1 << 5)) != 0;
+	const bool avx512f = (info[1] & (1 << 16)) != 0;
+	if (avx512f && (xcr0 & 0xE6) == 0xE6) { return SIMD_AVX512; }
+	if (avx2 && fma && (xcr0 & 0x6) == 0x6) { return SIMD_AVX2; }
+#endif
+	return SIMD_NONE;
+}
+
+static SimdLevel simd_level()
+{
+	static const SimdLevel level = detect_simd_level();
+	return level;
+}
+
+static SimdP3DArrays simd_arrays(const cvtx_P3D_soa &soa)
+{
+	SimdP3DArrays ret;
+	for (int i = 0; i < 3; ++i) {
+		ret.coord[i] = soa.coord(i);
+		ret.vorticity[i] = soa.vorticity(i);
+	}
+	ret.volume = soa.volume();
+	ret.size = soa.padded_size();
+	return ret;
+}
+
+int simd_P3D_M2M_vel(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_M2M_vel(arrs, mes_start, num_mes, result_array,
+			type, regularisation_radius) == 0) { return 0; }
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_M2M_vel(arrs, mes_start, num_mes, result_array,
+			type, regularisation_radius);
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	SimdP3DArrays induced_arrs = simd_arrays(induced);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_M2M_dvort(arrs, induced_arrs, induced.size(), 
+			result_array, type, regularisation_radius) == 0) { return 0; }
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_M2M_dvort(arrs, induced_arrs, induced.size(), 
+			result_array, type, regularisation_radius);
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	SimdP3DArrays induced_arrs = simd_arrays(induced);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_M2M_visc_dvort(arrs, induced_arrs, induced.size(), 
+			result_array, type, regularisation_radius, kinematic_visc) == 0) {
+			return 0;
+		}
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_M2M_visc_dvort(arrs, induced_arrs, induced.size(), 
+			result_array, type, regularisation_radius, kinematic_visc);
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_vel_dvort_visc(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	SimdP3DArrays induced_arrs = simd_arrays(induced);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_M2M_vel_dvort_visc(arrs, induced_arrs, induced.size(), 
+			vel_result, dvort_result, visc_dvort_result, type, 
+			regularisation_radius, kinematic_visc) == 0) {
+			return 0;
+		}
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_M2M_vel_dvort_visc(arrs, induced_arrs, induced.size(), 
+			vel_result, dvort_result, visc_dvort_result, type, 
+			regularisation_radius, kinematic_visc);
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_self_dvort(
+	const cvtx_P3D_soa &particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_self_dvort(arrs, particles.size(), result_array, 
+			type, regularisation_radius) == 0) { return 0; }
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_self_dvort(arrs, particles.size(), result_array, 
+			type, regularisation_radius);
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_self_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	VortFuncType type = vortfunc_type_3D(kernel);
+	if (type == VORTFUNC_OTHER) { return -1; }
+	SimdP3DArrays arrs = simd_arrays(particles);
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		if (avx512_P3D_self_visc_dvort(arrs, particles.size(), result_array, 
+			type, regularisation_radius, kinematic_visc) == 0) { 
+			return 0; 
+		}
+		/* Fall through */
+	case SIMD_AVX2:
+		return avx2_P3D_self_visc_dvort(arrs, particles.size(), result_array, 
+			type, regularisation_radius, kinematic_visc);
+	default:
+		return -1;
+	}
+}
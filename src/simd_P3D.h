@@ -0,0 +1,89 @@
+#ifndef CVTX_SIMD_P3D_H
+#define CVTX_SIMD_P3D_H
+#include "libcvtx.h"
+/*============================================================================
+simd_P3D.h
+
+Vectorised CPU evaluation of 3D vortex particle interactions for the
+built in regularisations.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <bsv/bsv.h>
+
+#include "P3D_soa.h"
+
+/* These use the widest vector instructions the CPU supports. They return
+0 on success, or nonzero if the CPU has no supported vector instructions
+or the kernel isn't a built in regularisation, in which case nothing is
+computed. */
+int simd_P3D_M2M_vel(
+	const cvtx_P3D_soa &particles,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+int simd_P3D_M2M_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+int simd_P3D_M2M_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+/* The velocity at the induced particles, and their dvort and viscous
+dvort, in a single pass. */
+int simd_P3D_M2M_vel_dvort_visc(
+	const cvtx_P3D_soa &particles,
+	const cvtx_P3D_soa &induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+/* As cpu_pairwise_P3D_self_dvort and cpu_pairwise_P3D_self_visc_dvort,
+evaluating each pair once. */
+int simd_P3D_self_dvort(
+	const cvtx_P3D_soa &particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius);
+
+int simd_P3D_self_visc_dvort(
+	const cvtx_P3D_soa &particles,
+	bsv_V3f *result_array,
+	const cvtx_VortFunc *kernel,
+	float regularisation_radius,
+	float kinematic_visc);
+
+#endif /* CVTX_SIMD_P3D_H */
@@ -0,0 +1,161 @@
+#include "simd_P3D_impl.h"
+/*============================================================================
+simd_P3D_avx512.cpp
+
+AVX-512F instantiation of the vectorised 3D vortex particle kernels.
+This file must be compiled with AVX-512F enabled (see CMakeLists.txt)
+and is only called on CPUs supporting it.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace {
+struct Avx512 {
+	typedef __m512 V;
+	typedef __mmask16 M;
+	static const int width = 16;
+	static V set1(float x) { return _mm512_set1_ps(x); }
+	static V load(const float *p) { return _mm512_load_ps(p); }
+	static void store(float *p, V x) { _mm512_store_ps(p, x); }
+	static V add(V a, V b) { return _mm512_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm512_div_ps(a, b); }
+	static V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+	static V min(V a, V b) { return _mm512_min_ps(a, b); }
+	static V max(V a, V b) { return _mm512_max_ps(a, b); }
+	static V round(V a) { 
+		return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	}
+	static V pow2i(V n) {
+		__m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), 
+			_mm512_set1_epi32(127));
+		return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+	}
+	static V rsqrt_approx(V a) { return _mm512_rsqrt14_ps(a); }
+	static M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static M gt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+	static V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+}
+
+#define CVTX_SIMD_ISA Avx512
+#include "simd_P3D_impl.h"
+
+int avx512_P3D_M2M_vel(const SimdP3DArrays &particles, 
+	const bsv_V3f *mes_start, const int num_mes, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	return simd_P3D_M2M_vel_dispatch(particles, mes_start, num_mes,
+		result_array, kernel, regularisation_radius);
+}
+
+int avx512_P3D_M2M_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	return simd_P3D_M2M_dvort_dispatch(particles, induced, num_induced,
+		result_array, kernel, regularisation_radius);
+}
+
+int avx512_P3D_M2M_visc_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius, float kinematic_visc)
+{
+	return simd_P3D_M2M_visc_dvort_dispatch(particles, induced, num_induced,
+		result_array, kernel, regularisation_radius, kinematic_visc);
+}
+
+int avx512_P3D_M2M_vel_dvort_visc(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *vel_result,
+	bsv_V3f *dvort_result, bsv_V3f *visc_dvort_result, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	return simd_P3D_M2M_vel_dvort_visc_dispatch(particles, induced, 
+		num_induced, vel_result, dvort_result, visc_dvort_result, kernel,
+		regularisation_radius, kinematic_visc);
+}
+
+int avx512_P3D_self_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius)
+{
+	return simd_P3D_self_dvort_dispatch(particles, num_particles,
+		result_array, kernel, regularisation_radius);
+}
+
+int avx512_P3D_self_visc_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	return simd_P3D_self_visc_dvort_dispatch(particles, num_particles,
+		result_array, kernel, regularisation_radius, kinematic_visc);
+}
+
+#else
+
+int avx512_P3D_M2M_vel(const SimdP3DArrays &particles, 
+	const bsv_V3f *mes_start, const int num_mes, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	return -1;
+}
+
+int avx512_P3D_M2M_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	return -1;
+}
+
+int avx512_P3D_M2M_visc_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius, float kinematic_visc)
+{
+	return -1;
+}
+
+int avx512_P3D_M2M_vel_dvort_visc(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *vel_result,
+	bsv_V3f *dvort_result, bsv_V3f *visc_dvort_result, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	return -1;
+}
+
+int avx512_P3D_self_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius)
+{
+	return -1;
+}
+
+int avx512_P3D_self_visc_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	return -1;
+}
+
+#endif
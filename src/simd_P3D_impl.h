@@ -0,0 +1,846 @@
+#ifndef CVTX_SIMD_P3D_IMPL_H
+#define CVTX_SIMD_P3D_IMPL_H
+#include "libcvtx.h"
+/*============================================================================
+simd_P3D_impl.h
+
+Vectorised 3D vortex particle kernels, written against an instruction
+set wrapper so that they can be compiled for several instruction sets.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/* This is included by the translation units compiled for a specific
+instruction set, so must not pull in anything with external linkage that
+could be emitted with that instruction set. */
+
+#include <bsv/bsv.h>
+
+#include "VortFunc.h"
+#include "tiled_M2M.h"
+
+/* The arrays of a cvtx_P3D_soa. size is padded to a multiple of the 
+vector width with inert particles. */
+struct SimdP3DArrays {
+	const float *coord[3], *vorticity[3], *volume;
+	int size;
+};
+
+/* Functions for each instruction set. These return 0 on success or
+nonzero if the instruction set or the regularisation isn't supported. */
+int avx2_P3D_M2M_vel(const SimdP3DArrays &particles, 
+	const bsv_V3f *mes_start, const int num_mes, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius);
+int avx2_P3D_M2M_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius);
+int avx2_P3D_M2M_visc_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius, float kinematic_visc);
+int avx2_P3D_M2M_vel_dvort_visc(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *vel_result,
+	bsv_V3f *dvort_result, bsv_V3f *visc_dvort_result, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc);
+int avx2_P3D_self_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius);
+int avx2_P3D_self_visc_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc);
+int avx512_P3D_M2M_vel(const SimdP3DArrays &particles, 
+	const bsv_V3f *mes_start, const int num_mes, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius);
+int avx512_P3D_M2M_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius);
+int avx512_P3D_M2M_visc_dvort(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius, float kinematic_visc);
+int avx512_P3D_M2M_vel_dvort_visc(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *vel_result,
+	bsv_V3f *dvort_result, bsv_V3f *visc_dvort_result, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc);
+int avx512_P3D_self_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius);
+int avx512_P3D_self_visc_dvort(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc);
+
+#endif /* CVTX_SIMD_P3D_IMPL_H */
+
+/* The kernels are in a second part, included once CVTX_SIMD_ISA is 
+defined. */
+#if defined(CVTX_SIMD_ISA) && !defined(CVTX_SIMD_P3D_IMPL_KERNELS)
+#define CVTX_SIMD_P3D_IMPL_KERNELS
+/* The including file defines an instruction set wrapper ISA with
+	typedef V (a vector of floats) and M (a mask);
+	static const int width;
+	static V set1(float), load(const float*) (aligned), 
+		add(V, V), sub(V, V), mul(V, V), div(V, V), fmadd(a, b, c) (a*b+c),
+		min(V, V), max(V, V), round(V) (to nearest), 
+		pow2i(V) (2^n for integer valued n), rsqrt_approx(V);
+	static M lt(V, V), gt(V, V);
+	static V select(M, V if_true, V if_false);
+	static void store(float*, V) (aligned);
+and defines CVTX_SIMD_ISA to its name before including this. */
+
+namespace {
+
+typedef CVTX_SIMD_ISA ISA;
+typedef ISA::V V;
+typedef ISA::M M;
+
+/* Number of particles summed in single precision before adding to
+double precision accumulators. */
+const int simd_block_size = 1024;
+
+inline V rsqrt(V x)
+{
+	/* One Newton-Raphson iteration takes the estimate to ~single precision. */
+	V y = ISA::rsqrt_approx(x);
+	V yyx = ISA::mul(ISA::mul(y, y), x);
+	return ISA::mul(ISA::mul(y, ISA::set1(0.5f)), 
+		ISA::sub(ISA::set1(3.f), yyx));
+}
+
+/* exp(x) for x <= 0, following the cephes expf. */
+inline V exp_nonpositive(V x)
+{
+	M underflow = ISA::lt(x, ISA::set1(-87.f));
+	x = ISA::max(x, ISA::set1(-87.f));
+	V n = ISA::round(ISA::mul(x, ISA::set1(1.44269504088896341f)));
+	x = ISA::fmadd(n, ISA::set1(-0.693359375f), x);
+	x = ISA::fmadd(n, ISA::set1(2.12194440e-4f), x);
+	V p = ISA::set1(1.9875691500E-4f);
+	p = ISA::fmadd(p, x, ISA::set1(1.3981999507E-3f));
+	p = ISA::fmadd(p, x, ISA::set1(8.3334519073E-3f));
+	p = ISA::fmadd(p, x, ISA::set1(4.1665795894E-2f));
+	p = ISA::fmadd(p, x, ISA::set1(1.6666665459E-1f));
+	p = ISA::fmadd(p, x, ISA::set1(5.0000001201E-1f));
+	p = ISA::fmadd(p, ISA::mul(x, x), ISA::add(x, ISA::set1(1.f)));
+	p = ISA::mul(p, ISA::pow2i(n));
+	return ISA::select(underflow, ISA::set1(0.f), p);
+}
+
+/* The regularisations, as in VortFunc.cpp. Each gives in terms of rho^2
+	gr3: g(rho) / rho^3,
+	zeta: zeta(rho),
+	eta: eta(rho) (where defined),
+	gr3_zeta_eta: all three, sharing the common work (where eta is 
+		defined). */
+struct SimdSingular {
+	static V gr3(V rho2) {
+		V rs = rsqrt(rho2);
+		return ISA::mul(ISA::mul(rs, rs), rs);
+	}
+	static void gr3_zeta(V rho2, V &gr3_out, V &zeta) {
+		gr3_out = gr3(rho2);
+		zeta = ISA::set1(0.f);
+	}
+};
+
+struct SimdWinckelmans {
+	static V gr3(V rho2) {
+		V rs = rsqrt(ISA::add(rho2, ISA::set1(1.f)));
+		V rs2 = ISA::mul(rs, rs);
+		V rs5 = ISA::mul(ISA::mul(rs2, rs2), rs);
+		return ISA::mul(ISA::add(rho2, ISA::set1(2.5f)), rs5);
+	}
+	static void gr3_zeta(V rho2, V &gr3_out, V &zeta) {
+		V rs = rsqrt(ISA::add(rho2, ISA::set1(1.f)));
+		V rs2 = ISA::mul(rs, rs);
+		V rs5 = ISA::mul(ISA::mul(rs2, rs2), rs);
+		gr3_out = ISA::mul(ISA::add(rho2, ISA::set1(2.5f)), rs5);
+		zeta = ISA::mul(ISA::set1(7.5f), ISA::mul(rs5, rs2));
+	}
+	static V eta(V rho2) {
+		V rs = rsqrt(ISA::add(rho2, ISA::set1(1.f)));
+		V rs2 = ISA::mul(rs, rs);
+		V rs4 = ISA::mul(rs2, rs2);
+		return ISA::mul(ISA::set1(52.5f), ISA::mul(ISA::mul(rs4, rs4), rs));
+	}
+	static void gr3_zeta_eta(V rho2, V &gr3_out, V &zeta, V &eta_out) {
+		V rs = rsqrt(ISA::add(rho2, ISA::set1(1.f)));
+		V rs2 = ISA::mul(rs, rs);
+		V rs5 = ISA::mul(ISA::mul(rs2, rs2), rs);
+		V rs7 = ISA::mul(rs5, rs2);
+		gr3_out = ISA::mul(ISA::add(rho2, ISA::set1(2.5f)), rs5);
+		zeta = ISA::mul(ISA::set1(7.5f), rs7);
+		eta_out = ISA::mul(ISA::set1(52.5f), ISA::mul(rs7, rs2));
+	}
+};
+
+struct SimdPlanetary {
+	static V gr3(V rho2) {
+		V rs = rsqrt(rho2);
+		return ISA::select(ISA::lt(rho2, ISA::set1(1.f)), ISA::set1(1.f),
+			ISA::mul(ISA::mul(rs, rs), rs));
+	}
+	static void gr3_zeta(V rho2, V &gr3_out, V &zeta) {
+		M inside = ISA::lt(rho2, ISA::set1(1.f));
+		V rs = rsqrt(rho2);
+		gr3_out = ISA::select(inside, ISA::set1(1.f), 
+			ISA::mul(ISA::mul(rs, rs), rs));
+		zeta = ISA::select(inside, ISA::set1(3.f), ISA::set1(0.f));
+	}
+};
+
+struct SimdGaussian {
+	static void gr3_zeta(V rho2, V &gr3_out, V &zeta) {
+		/* erf by Abramowitz and Stegun 7.1.26 as g_gaussian_3D. */
+		V rs = rsqrt(rho2);
+		V rho = ISA::mul(rho2, rs);
+		V e = exp_nonpositive(ISA::mul(rho2, ISA::set1(-0.5f)));
+		V t = ISA::div(ISA::set1(1.f), ISA::fmadd(rho, 
+			ISA::set1(0.3275911f * 0.7071067811865475f), ISA::set1(1.f)));
+		V poly = ISA::set1(1.061405429f);
+		poly = ISA::fmadd(poly, t, ISA::set1(-1.453152027f));
+		poly = ISA::fmadd(poly, t, ISA::set1(1.421413741f));
+		poly = ISA::fmadd(poly, t, ISA::set1(-0.284496736f));
+		poly = ISA::fmadd(poly, t, ISA::set1(0.254829592f));
+		poly = ISA::mul(poly, t);
+		V erf = ISA::sub(ISA::set1(1.f), ISA::mul(poly, e));
+		zeta = ISA::mul(ISA::set1(0.7978845608028654f), e);
+		V g = ISA::sub(erf, ISA::mul(rho, zeta));
+		g = ISA::select(ISA::gt(rho, ISA::set1(6.f)), ISA::set1(1.f), g);
+		gr3_out = ISA::mul(g, ISA::mul(ISA::mul(rs, rs), rs));
+	}
+	static V gr3(V rho2) {
+		V ret, zeta;
+		gr3_zeta(rho2, ret, zeta);
+		return ret;
+	}
+	static V eta(V rho2) {
+		return ISA::mul(ISA::set1(0.7978845608028654f),
+			exp_nonpositive(ISA::mul(rho2, ISA::set1(-0.5f))));
+	}
+	static void gr3_zeta_eta(V rho2, V &gr3_out, V &zeta, V &eta_out) {
+		/* eta is zeta for the Gaussian. */
+		gr3_zeta(rho2, gr3_out, zeta);
+		eta_out = zeta;
+	}
+};
+
+inline double simd_hsum(V x)
+{
+	alignas(64) float buf[ISA::width];
+	ISA::store(buf, x);
+	double ret = 0;
+	for (int i = 0; i < ISA::width; ++i) { ret += buf[i]; }
+	return ret;
+}
+
+template<typename Reg>
+void simd_P3D_M2M_vel(
+	const SimdP3DArrays &p,
+	const bsv_V3f *mes_start,
+	const int num_mes,
+	bsv_V3f *result_array,
+	float regularisation_radius)
+{
+	const float recip_reg_rad2 = 1.f / 
+		(regularisation_radius * regularisation_radius);
+	/* g / r^3 = (g / rho^3) / sigma^3 */
+	const float abs_reg_rad = regularisation_radius < 0.f ?
+		-regularisation_radius : regularisation_radius;
+	const float coeff = -1.f / (4.f * 3.14159265359f * 
+		abs_reg_rad * abs_reg_rad * abs_reg_rad);
+	auto tile = [&](int i, int sb, int se, double *acc) {
+		const V mx = ISA::set1(mes_start[i].x[0]), 
+			my = ISA::set1(mes_start[i].x[1]), mz = ISA::set1(mes_start[i].x[2]);
+		const V zero = ISA::set1(0.f), rsig2 = ISA::set1(recip_reg_rad2);
+		double rx = 0, ry = 0, rz = 0;
+		for (int jb = sb; jb < se; jb += simd_block_size) {
+			const int je = jb + simd_block_size < se ? 
+				jb + simd_block_size : se;
+			V ax = zero, ay = zero, az = zero;
+			for (int j = jb; j < je; j += ISA::width) {
+				V dx = ISA::sub(mx, ISA::load(p.coord[0] + j));
+				V dy = ISA::sub(my, ISA::load(p.coord[1] + j));
+				V dz = ISA::sub(mz, ISA::load(p.coord[2] + j));
+				V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+				V f = ISA::select(ISA::gt(r2, zero), 
+					Reg::gr3(ISA::mul(r2, rsig2)), zero);
+				V wx = ISA::load(p.vorticity[0] + j);
+				V wy = ISA::load(p.vorticity[1] + j);
+				V wz = ISA::load(p.vorticity[2] + j);
+				ax = ISA::fmadd(ISA::sub(ISA::mul(dy, wz), ISA::mul(dz, wy)), f, ax);
+				ay = ISA::fmadd(ISA::sub(ISA::mul(dz, wx), ISA::mul(dx, wz)), f, ay);
+				az = ISA::fmadd(ISA::sub(ISA::mul(dx, wy), ISA::mul(dy, wx)), f, az);
+			}
+			rx += simd_hsum(ax);
+			ry += simd_hsum(ay);
+			rz += simd_hsum(az);
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(num_mes, p.size, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * coeff;
+		result_array[i].x[1] = (float)acc[1] * coeff;
+		result_array[i].x[2] = (float)acc[2] * coeff;
+	});
+	return;
+}
+
+template<typename Reg>
+void simd_P3D_M2M_dvort(
+	const SimdP3DArrays &p,
+	const SimdP3DArrays &induced,
+	const int num_induced,
+	bsv_V3f *result_array,
+	float regularisation_radius)
+{
+	const float recip_reg_rad2 = 1.f / 
+		(regularisation_radius * regularisation_radius);
+	const float t1 = 1.f / (4.f * 3.14159265359f * 
+		regularisation_radius * regularisation_radius * regularisation_radius);
+	auto tile = [&](int i, int sb, int se, double *acc) {
+		const V ix = ISA::set1(induced.coord[0][i]), 
+			iy = ISA::set1(induced.coord[1][i]), 
+			iz = ISA::set1(induced.coord[2][i]);
+		const V iwx = ISA::set1(induced.vorticity[0][i]), 
+			iwy = ISA::set1(induced.vorticity[1][i]), 
+			iwz = ISA::set1(induced.vorticity[2][i]);
+		const V zero = ISA::set1(0.f), rsig2 = ISA::set1(recip_reg_rad2);
+		double rx = 0, ry = 0, rz = 0;
+		for (int jb = sb; jb < se; jb += simd_block_size) {
+			const int je = jb + simd_block_size < se ? 
+				jb + simd_block_size : se;
+			V ax = zero, ay = zero, az = zero;
+			for (int j = jb; j < je; j += ISA::width) {
+				V dx = ISA::sub(ix, ISA::load(p.coord[0] + j));
+				V dy = ISA::sub(iy, ISA::load(p.coord[1] + j));
+				V dz = ISA::sub(iz, ISA::load(p.coord[2] + j));
+				V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+				M nonzero = ISA::gt(r2, zero);
+				V gr3, zeta;
+				Reg::gr3_zeta(ISA::mul(r2, rsig2), gr3, zeta);
+				V wx = ISA::load(p.vorticity[0] + j);
+				V wy = ISA::load(p.vorticity[1] + j);
+				V wz = ISA::load(p.vorticity[2] + j);
+				V cx = ISA::sub(ISA::mul(iwy, wz), ISA::mul(iwz, wy));
+				V cy = ISA::sub(ISA::mul(iwz, wx), ISA::mul(iwx, wz));
+				V cz = ISA::sub(ISA::mul(iwx, wy), ISA::mul(iwy, wx));
+				/* -(3 g / rho^3 - zeta) (rad . cross) / r^2 */
+				V t22 = ISA::div(ISA::mul(ISA::fmadd(ISA::set1(-3.f), gr3, zeta),
+					ISA::fmadd(dx, cx, ISA::fmadd(dy, cy, ISA::mul(dz, cz)))), r2);
+				gr3 = ISA::select(nonzero, gr3, zero);
+				t22 = ISA::select(nonzero, t22, zero);
+				ax = ISA::fmadd(cx, gr3, ISA::fmadd(dx, t22, ax));
+				ay = ISA::fmadd(cy, gr3, ISA::fmadd(dy, t22, ay));
+				az = ISA::fmadd(cz, gr3, ISA::fmadd(dz, t22, az));
+			}
+			rx += simd_hsum(ax);
+			ry += simd_hsum(ay);
+			rz += simd_hsum(az);
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(num_induced, p.size, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * t1;
+		result_array[i].x[1] = (float)acc[1] * t1;
+		result_array[i].x[2] = (float)acc[2] * t1;
+	});
+	return;
+}
+
+template<typename Reg>
+void simd_P3D_M2M_visc_dvort(
+	const SimdP3DArrays &p,
+	const SimdP3DArrays &induced,
+	const int num_induced,
+	bsv_V3f *result_array,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const float recip_reg_rad2 = 1.f / 
+		(regularisation_radius * regularisation_radius);
+	const float t1 = 2 * kinematic_visc / 
+		(regularisation_radius * regularisation_radius);
+	auto tile = [&](int i, int sb, int se, double *acc) {
+		const V ix = ISA::set1(induced.coord[0][i]), 
+			iy = ISA::set1(induced.coord[1][i]), 
+			iz = ISA::set1(induced.coord[2][i]);
+		const V iwx = ISA::set1(induced.vorticity[0][i]), 
+			iwy = ISA::set1(induced.vorticity[1][i]), 
+			iwz = ISA::set1(induced.vorticity[2][i]);
+		const V ivol = ISA::set1(induced.volume[i]);
+		const V zero = ISA::set1(0.f), rsig2 = ISA::set1(recip_reg_rad2);
+		double rx = 0, ry = 0, rz = 0;
+		for (int jb = sb; jb < se; jb += simd_block_size) {
+			const int je = jb + simd_block_size < se ? 
+				jb + simd_block_size : se;
+			V ax = zero, ay = zero, az = zero;
+			for (int j = jb; j < je; j += ISA::width) {
+				V dx = ISA::sub(ix, ISA::load(p.coord[0] + j));
+				V dy = ISA::sub(iy, ISA::load(p.coord[1] + j));
+				V dz = ISA::sub(iz, ISA::load(p.coord[2] + j));
+				V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+				V eta = ISA::select(ISA::gt(r2, zero), 
+					Reg::eta(ISA::mul(r2, rsig2)), zero);
+				V vol = ISA::load(p.volume + j);
+				/* (omega_j vol_i - omega_i vol_j) eta */
+				ax = ISA::fmadd(ISA::sub(ISA::mul(ISA::load(p.vorticity[0] + j), 
+					ivol), ISA::mul(iwx, vol)), eta, ax);
+				ay = ISA::fmadd(ISA::sub(ISA::mul(ISA::load(p.vorticity[1] + j), 
+					ivol), ISA::mul(iwy, vol)), eta, ay);
+				az = ISA::fmadd(ISA::sub(ISA::mul(ISA::load(p.vorticity[2] + j), 
+					ivol), ISA::mul(iwz, vol)), eta, az);
+			}
+			rx += simd_hsum(ax);
+			ry += simd_hsum(ay);
+			rz += simd_hsum(az);
+		}
+		acc[0] += rx;
+		acc[1] += ry;
+		acc[2] += rz;
+	};
+	tiled_M2M<3>(num_induced, p.size, tile, [&](int i, const double *acc) {
+		result_array[i].x[0] = (float)acc[0] * t1;
+		result_array[i].x[1] = (float)acc[1] * t1;
+		result_array[i].x[2] = (float)acc[2] * t1;
+	});
+	return;
+}
+
+/* Velocity at, and vortex stretching and viscous dvort of, the induced
+particles in one pass. The vectors are as in the functions above. */
+template<typename Reg>
+void simd_P3D_M2M_vel_dvort_visc(
+	const SimdP3DArrays &p,
+	const SimdP3DArrays &induced,
+	const int num_induced,
+	bsv_V3f *vel_result,
+	bsv_V3f *dvort_result,
+	bsv_V3f *visc_dvort_result,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const float recip_reg_rad2 = 1.f / 
+		(regularisation_radius * regularisation_radius);
+	const float abs_reg_rad = regularisation_radius < 0.f ?
+		-regularisation_radius : regularisation_radius;
+	const float vel_coeff = -1.f / (4.f * 3.14159265359f * 
+		abs_reg_rad * abs_reg_rad * abs_reg_rad);
+	const float dvort_coeff = 1.f / (4.f * 3.14159265359f * 
+		regularisation_radius * regularisation_radius * regularisation_radius);
+	const float visc_coeff = 2 * kinematic_visc / 
+		(regularisation_radius * regularisation_radius);
+	auto tile = [&](int i, int sb, int se, double *acc) {
+		const V ix = ISA::set1(induced.coord[0][i]), 
+			iy = ISA::set1(induced.coord[1][i]), 
+			iz = ISA::set1(induced.coord[2][i]);
+		const V iwx = ISA::set1(induced.vorticity[0][i]), 
+			iwy = ISA::set1(induced.vorticity[1][i]), 
+			iwz = ISA::set1(induced.vorticity[2][i]);
+		const V ivol = ISA::set1(induced.volume[i]);
+		const V zero = ISA::set1(0.f), rsig2 = ISA::set1(recip_reg_rad2);
+		for (int jb = sb; jb < se; jb += simd_block_size) {
+			const int je = jb + simd_block_size < se ? 
+				jb + simd_block_size : se;
+			V vx = zero, vy = zero, vz = zero;
+			V ax = zero, ay = zero, az = zero;
+			V bx = zero, by = zero, bz = zero;
+			for (int j = jb; j < je; j += ISA::width) {
+				V dx = ISA::sub(ix, ISA::load(p.coord[0] + j));
+				V dy = ISA::sub(iy, ISA::load(p.coord[1] + j));
+				V dz = ISA::sub(iz, ISA::load(p.coord[2] + j));
+				V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+				M nonzero = ISA::gt(r2, zero);
+				V gr3, zeta, eta;
+				Reg::gr3_zeta_eta(ISA::mul(r2, rsig2), gr3, zeta, eta);
+				V wx = ISA::load(p.vorticity[0] + j);
+				V wy = ISA::load(p.vorticity[1] + j);
+				V wz = ISA::load(p.vorticity[2] + j);
+				V vol = ISA::load(p.volume + j);
+				V cx = ISA::sub(ISA::mul(iwy, wz), ISA::mul(iwz, wy));
+				V cy = ISA::sub(ISA::mul(iwz, wx), ISA::mul(iwx, wz));
+				V cz = ISA::sub(ISA::mul(iwx, wy), ISA::mul(iwy, wx));
+				V t22 = ISA::div(ISA::mul(ISA::fmadd(ISA::set1(-3.f), gr3, zeta),
+					ISA::fmadd(dx, cx, ISA::fmadd(dy, cy, ISA::mul(dz, cz)))), r2);
+				gr3 = ISA::select(nonzero, gr3, zero);
+				t22 = ISA::select(nonzero, t22, zero);
+				eta = ISA::select(nonzero, eta, zero);
+				vx = ISA::fmadd(ISA::sub(ISA::mul(dy, wz), ISA::mul(dz, wy)), gr3, vx);
+				vy = ISA::fmadd(ISA::sub(ISA::mul(dz, wx), ISA::mul(dx, wz)), gr3, vy);
+				vz = ISA::fmadd(ISA::sub(ISA::mul(dx, wy), ISA::mul(dy, wx)), gr3, vz);
+				ax = ISA::fmadd(cx, gr3, ISA::fmadd(dx, t22, ax));
+				ay = ISA::fmadd(cy, gr3, ISA::fmadd(dy, t22, ay));
+				az = ISA::fmadd(cz, gr3, ISA::fmadd(dz, t22, az));
+				bx = ISA::fmadd(ISA::sub(ISA::mul(wx, ivol), ISA::mul(iwx, vol)), 
+					eta, bx);
+				by = ISA::fmadd(ISA::sub(ISA::mul(wy, ivol), ISA::mul(iwy, vol)), 
+					eta, by);
+				bz = ISA::fmadd(ISA::sub(ISA::mul(wz, ivol), ISA::mul(iwz, vol)), 
+					eta, bz);
+			}
+			acc[0] += simd_hsum(vx);
+			acc[1] += simd_hsum(vy);
+			acc[2] += simd_hsum(vz);
+			acc[3] += simd_hsum(ax);
+			acc[4] += simd_hsum(ay);
+			acc[5] += simd_hsum(az);
+			acc[6] += simd_hsum(bx);
+			acc[7] += simd_hsum(by);
+			acc[8] += simd_hsum(bz);
+		}
+	};
+	tiled_M2M<9>(num_induced, p.size, tile, [&](int i, const double *acc) {
+		for (int k = 0; k < 3; ++k) {
+			vel_result[i].x[k] = (float)acc[k] * vel_coeff;
+			dvort_result[i].x[k] = (float)acc[3 + k] * dvort_coeff;
+			visc_dvort_result[i].x[k] = (float)acc[6 + k] * visc_coeff;
+		}
+	});
+	return;
+}
+
+/* The pair interactions of the self interaction functions. Each is 
+constructed for particle i, then gives the effect of the particles 
+[j, j + width) on i. The effect of i on j is minus this. */
+template<typename Reg>
+struct SimdSelfDvort {
+	V ix, iy, iz, iwx, iwy, iwz, rsig2;
+	SimdSelfDvort(const SimdP3DArrays &p, int i, float recip_reg_rad2) 
+		: ix(ISA::set1(p.coord[0][i])), iy(ISA::set1(p.coord[1][i])), 
+		iz(ISA::set1(p.coord[2][i])), iwx(ISA::set1(p.vorticity[0][i])),
+		iwy(ISA::set1(p.vorticity[1][i])), iwz(ISA::set1(p.vorticity[2][i])),
+		rsig2(ISA::set1(recip_reg_rad2)) {}
+	void operator()(const SimdP3DArrays &p, int j, V &x, V &y, V &z) const {
+		const V zero = ISA::set1(0.f);
+		V dx = ISA::sub(ix, ISA::load(p.coord[0] + j));
+		V dy = ISA::sub(iy, ISA::load(p.coord[1] + j));
+		V dz = ISA::sub(iz, ISA::load(p.coord[2] + j));
+		V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+		M nonzero = ISA::gt(r2, zero);
+		V gr3, zeta;
+		Reg::gr3_zeta(ISA::mul(r2, rsig2), gr3, zeta);
+		V wx = ISA::load(p.vorticity[0] + j);
+		V wy = ISA::load(p.vorticity[1] + j);
+		V wz = ISA::load(p.vorticity[2] + j);
+		V cx = ISA::sub(ISA::mul(iwy, wz), ISA::mul(iwz, wy));
+		V cy = ISA::sub(ISA::mul(iwz, wx), ISA::mul(iwx, wz));
+		V cz = ISA::sub(ISA::mul(iwx, wy), ISA::mul(iwy, wx));
+		V t22 = ISA::div(ISA::mul(ISA::fmadd(ISA::set1(-3.f), gr3, zeta),
+			ISA::fmadd(dx, cx, ISA::fmadd(dy, cy, ISA::mul(dz, cz)))), r2);
+		gr3 = ISA::select(nonzero, gr3, zero);
+		t22 = ISA::select(nonzero, t22, zero);
+		x = ISA::fmadd(cx, gr3, ISA::mul(dx, t22));
+		y = ISA::fmadd(cy, gr3, ISA::mul(dy, t22));
+		z = ISA::fmadd(cz, gr3, ISA::mul(dz, t22));
+	}
+};
+
+template<typename Reg>
+struct SimdSelfViscDvort {
+	V ix, iy, iz, iwx, iwy, iwz, ivol, rsig2;
+	SimdSelfViscDvort(const SimdP3DArrays &p, int i, float recip_reg_rad2) 
+		: ix(ISA::set1(p.coord[0][i])), iy(ISA::set1(p.coord[1][i])), 
+		iz(ISA::set1(p.coord[2][i])), iwx(ISA::set1(p.vorticity[0][i])),
+		iwy(ISA::set1(p.vorticity[1][i])), iwz(ISA::set1(p.vorticity[2][i])),
+		ivol(ISA::set1(p.volume[i])), rsig2(ISA::set1(recip_reg_rad2)) {}
+	void operator()(const SimdP3DArrays &p, int j, V &x, V &y, V &z) const {
+		const V zero = ISA::set1(0.f);
+		V dx = ISA::sub(ix, ISA::load(p.coord[0] + j));
+		V dy = ISA::sub(iy, ISA::load(p.coord[1] + j));
+		V dz = ISA::sub(iz, ISA::load(p.coord[2] + j));
+		V r2 = ISA::fmadd(dx, dx, ISA::fmadd(dy, dy, ISA::mul(dz, dz)));
+		V eta = ISA::select(ISA::gt(r2, zero), 
+			Reg::eta(ISA::mul(r2, rsig2)), zero);
+		/* Unlike the M2M sums, these products are stored on their own, and
+		the far Gaussian pairs would make them denormal, which is slow. 
+		Their contribution is negligible anyway. */
+		eta = ISA::select(ISA::gt(eta, ISA::set1(1e-30f)), eta, zero);
+		V vol = ISA::load(p.volume + j);
+		x = ISA::mul(ISA::sub(ISA::mul(ISA::load(p.vorticity[0] + j), ivol), 
+			ISA::mul(iwx, vol)), eta);
+		y = ISA::mul(ISA::sub(ISA::mul(ISA::load(p.vorticity[1] + j), ivol), 
+			ISA::mul(iwy, vol)), eta);
+		z = ISA::mul(ISA::sub(ISA::mul(ISA::load(p.vorticity[2] + j), ivol), 
+			ISA::mul(iwz, vol)), eta);
+	}
+};
+
+/* Lane offsets, to mask out the pairs j <= i in the diagonal blocks. */
+alignas(64) const float simd_lane_index[16] = {
+	0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 
+	8.f, 9.f, 10.f, 11.f, 12.f, 13.f, 14.f, 15.f };
+
+/* Evaluates each pair of particles once, adding the effect of j on i to i
+and subtracting it from j, over the blocks given by tiled_self_interaction.
+Within a task the sources j are taken simd_block_size at a time. Their 
+single precision sums are added to the double precision accumulators 
+every simd_block_size targets, and those of the targets after each 
+source block. The padding particles are inert, so the last block runs 
+to the padded size. */
+template<typename Pair>
+void simd_P3D_self_interaction(
+	const SimdP3DArrays &p,
+	const int num_particles,
+	bsv_V3f *result_array,
+	float regularisation_radius,
+	float coeff)
+{
+	const float recip_reg_rad2 = 1.f / 
+		(regularisation_radius * regularisation_radius);
+	double *acc = new double[3 * (size_t)p.size];
+	for (long k = 0; k < 3 * (long)p.size; ++k) { acc[k] = 0.; }
+	tiled_self_interaction(num_particles, 
+		[&](int a_begin, int a_end, int b_begin, int b_end) {
+		const bool diagonal = a_begin == b_begin;
+		if (b_end == num_particles) { b_end = p.size; }
+		const V zero = ISA::set1(0.f);
+		alignas(64) float jacc[3][simd_block_size];
+		for (int jb = b_begin; jb < b_end; jb += simd_block_size) {
+			const int je = jb + simd_block_size < b_end ? 
+				jb + simd_block_size : b_end;
+			const int ie_max = diagonal && je - 1 < a_end ? je - 1 : a_end;
+			for (int ib = a_begin; ib < ie_max; ib += simd_block_size) {
+				const int ie = ib + simd_block_size < ie_max ?
+					ib + simd_block_size : ie_max;
+				for (int k = 0; k < je - jb; ++k) {
+					jacc[0][k] = jacc[1][k] = jacc[2][k] = 0.f;
+				}
+				for (int i = ib; i < ie; ++i) {
+					const Pair pair(p, i, recip_reg_rad2);
+					int j = jb;
+					if (diagonal && i + 1 > jb) {
+						j = (i + 1) / ISA::width * ISA::width;
+					}
+					V ax = zero, ay = zero, az = zero;
+					for (; j < je; j += ISA::width) {
+						V x, y, z;
+						pair(p, j, x, y, z);
+						if (diagonal && j <= i) {
+							M later = ISA::gt(ISA::add(ISA::set1((float)(j - i)),
+								ISA::load(simd_lane_index)), zero);
+							x = ISA::select(later, x, zero);
+							y = ISA::select(later, y, zero);
+							z = ISA::select(later, z, zero);
+						}
+						ax = ISA::add(ax, x);
+						ay = ISA::add(ay, y);
+						az = ISA::add(az, z);
+						float *jx = jacc[0] + j - jb, *jy = jacc[1] + j - jb,
+							*jz = jacc[2] + j - jb;
+						ISA::store(jx, ISA::sub(ISA::load(jx), x));
+						ISA::store(jy, ISA::sub(ISA::load(jy), y));
+						ISA::store(jz, ISA::sub(ISA::load(jz), z));
+					}
+					acc[3 * (size_t)i] += simd_hsum(ax);
+					acc[3 * (size_t)i + 1] += simd_hsum(ay);
+					acc[3 * (size_t)i + 2] += simd_hsum(az);
+				}
+				for (int j = jb; j < je; ++j) {
+					acc[3 * (size_t)j] += jacc[0][j - jb];
+					acc[3 * (size_t)j + 1] += jacc[1][j - jb];
+					acc[3 * (size_t)j + 2] += jacc[2][j - jb];
+				}
+			}
+		}
+	});
+	long i;
+#pragma omp parallel for schedule(static)
+	for (i = 0; i < num_particles; ++i) {
+		for (int k = 0; k < 3; ++k) {
+			result_array[i].x[k] = (float)acc[3 * i + k] * coeff;
+		}
+	}
+	delete[] acc;
+	return;
+}
+
+template<typename Reg>
+void simd_P3D_self_dvort(
+	const SimdP3DArrays &p,
+	const int num_particles,
+	bsv_V3f *result_array,
+	float regularisation_radius)
+{
+	const float t1 = 1.f / (4.f * 3.14159265359f * 
+		regularisation_radius * regularisation_radius * regularisation_radius);
+	simd_P3D_self_interaction<SimdSelfDvort<Reg>>(p, num_particles, 
+		result_array, regularisation_radius, t1);
+	return;
+}
+
+template<typename Reg>
+void simd_P3D_self_visc_dvort(
+	const SimdP3DArrays &p,
+	const int num_particles,
+	bsv_V3f *result_array,
+	float regularisation_radius,
+	float kinematic_visc)
+{
+	const float t1 = 2 * kinematic_visc / 
+		(regularisation_radius * regularisation_radius);
+	simd_P3D_self_interaction<SimdSelfViscDvort<Reg>>(p, num_particles, 
+		result_array, regularisation_radius, t1);
+	return;
+}
+
+/* Select the regularisation at runtime. */
+int simd_P3D_M2M_vel_dispatch(const SimdP3DArrays &particles, 
+	const bsv_V3f *mes_start, const int num_mes, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	switch (kernel) {
+	case VORTFUNC_SINGULAR:
+		simd_P3D_M2M_vel<SimdSingular>(particles, mes_start, num_mes,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_M2M_vel<SimdWinckelmans>(particles, mes_start, num_mes,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_PLANETARY:
+		simd_P3D_M2M_vel<SimdPlanetary>(particles, mes_start, num_mes,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_M2M_vel<SimdGaussian>(particles, mes_start, num_mes,
+			result_array, regularisation_radius);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_dvort_dispatch(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius)
+{
+	switch (kernel) {
+	case VORTFUNC_SINGULAR:
+		simd_P3D_M2M_dvort<SimdSingular>(particles, induced, num_induced,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_M2M_dvort<SimdWinckelmans>(particles, induced, num_induced,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_PLANETARY:
+		simd_P3D_M2M_dvort<SimdPlanetary>(particles, induced, num_induced,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_M2M_dvort<SimdGaussian>(particles, induced, num_induced,
+			result_array, regularisation_radius);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_visc_dvort_dispatch(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *result_array,
+	VortFuncType kernel, float regularisation_radius, float kinematic_visc)
+{
+	/* Singular and planetary regularisations have no eta function. */
+	switch (kernel) {
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_M2M_visc_dvort<SimdWinckelmans>(particles, induced, 
+			num_induced, result_array, regularisation_radius, kinematic_visc);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_M2M_visc_dvort<SimdGaussian>(particles, induced, 
+			num_induced, result_array, regularisation_radius, kinematic_visc);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_M2M_vel_dvort_visc_dispatch(const SimdP3DArrays &particles, 
+	const SimdP3DArrays &induced, const int num_induced, bsv_V3f *vel_result,
+	bsv_V3f *dvort_result, bsv_V3f *visc_dvort_result, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	/* Singular and planetary regularisations have no eta function. */
+	switch (kernel) {
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_M2M_vel_dvort_visc<SimdWinckelmans>(particles, induced, 
+			num_induced, vel_result, dvort_result, visc_dvort_result,
+			regularisation_radius, kinematic_visc);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_M2M_vel_dvort_visc<SimdGaussian>(particles, induced, 
+			num_induced, vel_result, dvort_result, visc_dvort_result,
+			regularisation_radius, kinematic_visc);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_self_dvort_dispatch(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius)
+{
+	switch (kernel) {
+	case VORTFUNC_SINGULAR:
+		simd_P3D_self_dvort<SimdSingular>(particles, num_particles,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_self_dvort<SimdWinckelmans>(particles, num_particles,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_PLANETARY:
+		simd_P3D_self_dvort<SimdPlanetary>(particles, num_particles,
+			result_array, regularisation_radius);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_self_dvort<SimdGaussian>(particles, num_particles,
+			result_array, regularisation_radius);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int simd_P3D_self_visc_dvort_dispatch(const SimdP3DArrays &particles, 
+	const int num_particles, bsv_V3f *result_array, VortFuncType kernel, 
+	float regularisation_radius, float kinematic_visc)
+{
+	/* Singular and planetary regularisations have no eta function. */
+	switch (kernel) {
+	case VORTFUNC_WINCKELMANS:
+		simd_P3D_self_visc_dvort<SimdWinckelmans>(particles, num_particles,
+			result_array, regularisation_radius, kinematic_visc);
+		return 0;
+	case VORTFUNC_GAUSSIAN:
+		simd_P3D_self_visc_dvort<SimdGaussian>(particles, num_particles,
+			result_array, regularisation_radius, kinematic_visc);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+} /* namespace */
+
+#endif /* CVTX_SIMD_ISA */
@@ -0,0 +1,72 @@
+#include "tiled_M2M.h"
+/*============================================================================
+tiled_M2M.cpp
+
+A single level parallel scheduler for CPU M2M evaluations over target and
+source tiles, and a coloured schedule over pairs of blocks for self 
+interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifdef CVTX_USING_OPENMP
+#	include <omp.h>
+#endif
+
+/* Don't split the sources into pieces smaller than this. */
+static const int min_source_split = 1024;
+/* Tasks per thread for the dynamic schedule to balance. */
+static const int tasks_per_thread = 4;
+/* Minimum number of particles in a self interaction block. */
+static const int min_self_block = 64;
+
+int tiled_M2M_num_source_splits(int num_targets, int num_sources)
+{
+#ifdef CVTX_USING_OPENMP
+	const int num_threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+	const int num_threads = 1;
+#endif
+	const int tt = tiled_M2M_target_tile;
+	const int num_target_tiles = (num_targets + tt - 1) / tt;
+	if (num_target_tiles == 0) { return 1; }
+	int num_splits = (tasks_per_thread * num_threads + num_target_tiles - 1)
+		/ num_target_tiles;
+	const int max_splits = num_sources / min_source_split;
+	if (num_splits > max_splits) { num_splits = max_splits; }
+	return num_splits > 1 ? num_splits : 1;
+}
+
+int tiled_self_num_blocks(int num_particles)
+{
+#ifdef CVTX_USING_OPENMP
+	const int num_threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+	const int num_threads = 1;
+#endif
+	int num_blocks = tasks_per_thread * num_threads;
+	if (num_blocks > num_particles / min_self_block) {
+		num_blocks = num_particles / min_self_block;
+	}
+	/* The round robin needs an even number of blocks. */
+	num_blocks += num_blocks % 2;
+	return num_blocks > 2 ? num_blocks : 2;
+}
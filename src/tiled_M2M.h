@@ -0,0 +1,178 @@
+#ifndef CVTX_TILED_M2M_H
+#define CVTX_TILED_M2M_H
+#include "libcvtx.h"
+/*============================================================================
+tiled_M2M.h
+
+A single level parallel scheduler for CPU M2M evaluations over target and
+source tiles, and a coloured schedule over pairs of blocks for self 
+interactions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#include <cstddef>
+
+/* Targets are processed in tiles of tiled_M2M_target_tile. Where there are
+too few target tiles to keep every thread busy (a few measurement points
+and many particles), the sources are split too, and the partial sums are
+reduced afterwards. All the tiles are distributed dynamically by a single
+parallel loop, so the tile functions must not open parallel regions of
+their own. */
+static const int tiled_M2M_target_tile = 32;
+/* Source splits are multiples of this so that vectorised tile functions
+can work on whole, aligned vectors. */
+static const int tiled_M2M_source_align = 16;
+/* Within a task, each block of this many sources is applied to every
+target in the tile before moving on, so that the block stays in L1 (up to
+7 floats per source for the P3D structure of arrays). It is a multiple of
+tiled_M2M_source_align. */
+static const int tiled_M2M_source_block = 1024;
+
+/* The number of pieces to split the sources into. */
+int tiled_M2M_num_source_splits(int num_targets, int num_sources);
+
+/* tile(i, source_begin, source_end, acc) adds the effect of the sources
+in [source_begin, source_end) on target i to acc[0, NumComponents). It is
+called for each source block in turn. store(i, acc) is then called once 
+for each target with the complete sum. */
+template<int NumComponents, typename TileFunc, typename StoreFunc>
+void tiled_M2M(
+	const int num_targets,
+	const int num_sources,
+	TileFunc tile,
+	StoreFunc store)
+{
+	const int tt = tiled_M2M_target_tile;
+	const int num_target_tiles = (num_targets + tt - 1) / tt;
+	const int num_splits = tiled_M2M_num_source_splits(
+		num_targets, num_sources);
+	const int align = tiled_M2M_source_align;
+	const int split_size = ((num_sources + num_splits - 1) / num_splits
+		+ align - 1) / align * align;
+	double *partial = NULL;
+	if (num_splits > 1) {
+		partial = new double[(size_t)num_splits * num_targets * NumComponents];
+	}
+	long task;
+#pragma omp parallel for schedule(dynamic)
+	for (task = 0; task < (long)num_target_tiles * num_splits; ++task) {
+		const int split = (int)(task % num_splits);
+		const int tb = (int)(task / num_splits) * tt;
+		const int te = tb + tt < num_targets ? tb + tt : num_targets;
+		const int sb = split * split_size < num_sources ? 
+			split * split_size : num_sources;
+		const int se = sb + split_size < num_sources ? 
+			sb + split_size : num_sources;
+		double acc[tiled_M2M_target_tile * NumComponents];
+		for (int k = 0; k < (te - tb) * NumComponents; ++k) { acc[k] = 0.; }
+		for (int bb = sb; bb < se; bb += tiled_M2M_source_block) {
+			const int be = bb + tiled_M2M_source_block < se ?
+				bb + tiled_M2M_source_block : se;
+			for (int i = tb; i < te; ++i) {
+				tile(i, bb, be, acc + (i - tb) * NumComponents);
+			}
+		}
+		if (num_splits == 1) {
+			for (int i = tb; i < te; ++i) {
+				store(i, (const double*)(acc + (i - tb) * NumComponents));
+			}
+		}
+		else {
+			double *dst = partial + ((size_t)split * num_targets + tb) 
+				* NumComponents;
+			for (int k = 0; k < (te - tb) * NumComponents; ++k) {
+				dst[k] = acc[k];
+			}
+		}
+	}
+	if (num_splits > 1) {
+		long i;
+#pragma omp parallel for schedule(static)
+		for (i = 0; i < num_targets; ++i) {
+			double sum[NumComponents];
+			for (int c = 0; c < NumComponents; ++c) { sum[c] = 0.; }
+			for (int s = 0; s < num_splits; ++s) {
+				const double *src = partial + ((size_t)s * num_targets + i)
+					* NumComponents;
+				for (int c = 0; c < NumComponents; ++c) { sum[c] += src[c]; }
+			}
+			store((int)i, (const double*)sum);
+		}
+		delete[] partial;
+	}
+	return;
+}
+
+/* Self interactions, where the effect of particle i on j is minus that of
+j on i, evaluate each pair once. The particles are split into blocks whose
+boundaries are multiples of tiled_M2M_source_align, and each task is a pair
+of blocks that writes to both. The tasks are coloured with a round robin
+schedule so that the tasks run concurrently never share a block, and no 
+locking is needed. */
+int tiled_self_num_blocks(int num_particles);
+
+/* pair(a_begin, a_end, b_begin, b_end) evaluates the pairs between blocks
+[a_begin, a_end) and [b_begin, b_end), or the pairs i < j within the block
+if a_begin == b_begin. The blocks are never empty. */
+template<typename PairFunc>
+void tiled_self_interaction(
+	const int num_particles,
+	PairFunc pair)
+{
+	const int num_blocks = tiled_self_num_blocks(num_particles);
+	const int align = tiled_M2M_source_align;
+	int *block_starts = new int[num_blocks + 1];
+	for (int b = 0; b < num_blocks; ++b) {
+		const int start = (int)(((long long)num_particles * b / num_blocks
+			+ align - 1) / align * align);
+		block_starts[b] = start < num_particles ? start : num_particles;
+	}
+	block_starts[num_blocks] = num_particles;
+	/* Round 0 is the blocks with themselves, the rest a round robin. */
+	for (int round = 0; round < num_blocks; ++round) {
+		const int num_tasks = round == 0 ? num_blocks : num_blocks / 2;
+		int task;
+#pragma omp parallel for schedule(dynamic, 1)
+		for (task = 0; task < num_tasks; ++task) {
+			int a, b;
+			if (round == 0) {
+				a = b = task;
+			} else if (task == 0) {
+				a = num_blocks - 1;
+				b = round - 1;
+			} else {
+				const int m = num_blocks - 1;
+				a = (round - 1 + task) % m;
+				b = (round - 1 - task + m) % m;
+			}
+			if (block_starts[a] < block_starts[a + 1]
+				&& block_starts[b] < block_starts[b + 1]) {
+				pair(block_starts[a], block_starts[a + 1], 
+					block_starts[b], block_starts[b + 1]);
+			}
+		}
+	}
+	delete[] block_starts;
+	return;
+}
+
+#endif /* CVTX_TILED_M2M_H */
@@ -0,0 +1,290 @@
+#ifndef CVTX_TEST_ALGORITHMS_H
+#define CVTX_TEST_ALGORITHMS_H
+
+/*============================================================================
+testalgorithms.h
+
+Test that the fast M2M algorithms agree with brute force summation.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#include "../include/cvortex/libcvtx.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/* mrand() gives values in [0, 0x7FFF] whatever RAND_MAX is. */
+float test_algorithms_rand(float max_float) {
+	return max_float * (float)mrand() / (float)0x7FFF;
+}
+
+/* A user regularisation identical to the winckelmans one. The CPU code has
+no specialisation for it, so takes its generic paths. */
+static void test_algorithms_user_combined(float rho, float* g, float* zeta) {
+	cvtx_VortFunc_winckelmans().combined_3D(rho, g, zeta);
+}
+
+/* Relative L2 norm of the difference of two 2D result arrays. */
+float test_algorithms_rel_err_2D(bsv_V2f* res, bsv_V2f* ref, int n) {
+	double num = 0, den = 0;
+	int i;
+	for (i = 0; i < n; ++i) {
+		num += pow(bsv_V2f_abs(bsv_V2f_minus(res[i], ref[i])), 2);
+		den += pow(bsv_V2f_abs(ref[i]), 2);
+	}
+	return den > 0 ? (float)sqrt(num / den) : (float)sqrt(num);
+}
+
+/* Relative L2 norm of the difference of two result arrays. */
+float test_algorithms_rel_err_3D(bsv_V3f* res, bsv_V3f* ref, int n) {
+	double num = 0, den = 0;
+	int i;
+	for (i = 0; i < n; ++i) {
+		num += pow(bsv_V3f_abs(bsv_V3f_minus(res[i], ref[i])), 2);
+		den += pow(bsv_V3f_abs(ref[i]), 2);
+	}
+	return den > 0 ? (float)sqrt(num / den) : (float)sqrt(num);
+}
+
+int testAlgorithms() {
+	SECTION("Algorithms");
+	const int num_obj = 4000;
+	float max_float = 10;
+	float reg_rad = 0.05f;
+	int i;
+	float err;
+	bsv_V3f *pmes, *presult, *presult2;
+	bsv_V2f *p2mes, *p2dres, *p2dres2;
+	cvtx_P3D *particles, **pparticles;
+	cvtx_P2D *p2ds, **pp2ds;
+	cvtx_VortFunc func;
+	cvtx_Algorithm alg, bf_alg, def_alg;
+	particles = malloc(sizeof(cvtx_P3D) * num_obj);
+	pparticles = malloc(sizeof(cvtx_P3D*) * num_obj);
+	pmes = malloc(sizeof(bsv_V3f) * num_obj);
+	presult = malloc(sizeof(bsv_V3f) * num_obj);
+	presult2 = malloc(sizeof(bsv_V3f) * num_obj);
+	p2mes = malloc(sizeof(bsv_V2f) * num_obj);
+	p2dres = malloc(sizeof(bsv_V2f) * num_obj);
+	p2dres2 = malloc(sizeof(bsv_V2f) * num_obj);
+	p2ds = malloc(sizeof(cvtx_P2D) * num_obj);
+	pp2ds = malloc(sizeof(cvtx_P2D*) * num_obj);
+	for (i = 0; i < num_obj; ++i) {
+		particles[i].coord.x[0] = test_algorithms_rand(max_float);
+		particles[i].coord.x[1] = test_algorithms_rand(max_float);
+		particles[i].coord.x[2] = test_algorithms_rand(max_float);
+		particles[i].vorticity.x[0] = test_algorithms_rand(max_float) - 5.f;
+		particles[i].vorticity.x[1] = test_algorithms_rand(max_float) - 5.f;
+		particles[i].vorticity.x[2] = test_algorithms_rand(max_float) - 5.f;
+		particles[i].volume = test_algorithms_rand(0.01f);
+		pparticles[i] = &(particles[i]);
+		pmes[i].x[0] = test_algorithms_rand(max_float);
+		pmes[i].x[1] = test_algorithms_rand(max_float);
+		pmes[i].x[2] = test_algorithms_rand(max_float);
+		p2ds[i].coord.x[0] = particles[i].coord.x[0];
+		p2ds[i].coord.x[1] = particles[i].coord.x[1];
+		p2ds[i].vorticity = particles[i].vorticity.x[0];
+		p2ds[i].area = particles[i].volume;
+		pp2ds[i] = &(p2ds[i]);
+		p2mes[i].x[0] = pmes[i].x[0];
+		p2mes[i].x[1] = pmes[i].x[1];
+	}
+	bf_alg = cvtx_Algorithm_brute_force();
+	def_alg = cvtx_Algorithm_default();
+	NAMED_TEST(def_alg.type == CVTX_ALGORITHM_BRUTE_FORCE, "Default is brute force");
+
+	/* Barnes-Hut */
+	func = cvtx_VortFunc_winckelmans();
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_barnes_hut(0.5f);
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 3e-2f, "P3D M2M vel Barnes-Hut theta=0.5 winckelmans");
+	alg = cvtx_Algorithm_barnes_hut(0.25f);
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 3e-3f, "P3D M2M vel Barnes-Hut theta=0.25 winckelmans");
+	func = cvtx_VortFunc_singular();
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad, &bf_alg);
+	cvtx_Algorithm_set_default(&alg);
+	cvtx_P3D_M2M_vel(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad);
+	cvtx_Algorithm_set_default(&def_alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 3e-3f, "P3D M2M vel Barnes-Hut default singular");
+
+	/* Fast multipole method */
+	func = cvtx_VortFunc_winckelmans();
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_fmm(4, 0.5f);
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 3e-3f, "P3D M2M vel FMM order 4 winckelmans");
+	alg = cvtx_Algorithm_fmm(8, 0.5f);
+	cvtx_P3D_M2M_vel_algorithm(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-4f, "P3D M2M vel FMM order 8 winckelmans");
+	cvtx_P3D_M2M_dvort_algorithm(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_fmm(4, 0.5f);
+	cvtx_P3D_M2M_dvort_algorithm(pparticles, num_obj, pparticles, num_obj, presult, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-3f, "P3D M2M dvort FMM order 4 winckelmans");
+	func = cvtx_VortFunc_gaussian();
+	cvtx_P3D_M2M_dvort_algorithm(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_fmm(8, 0.5f);
+	cvtx_Algorithm_set_default(&alg);
+	cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult, &func, reg_rad);
+	cvtx_Algorithm_set_default(&def_alg);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-4f, "P3D M2M dvort FMM default gaussian");
+
+	func = cvtx_VortFunc_winckelmans();
+	cvtx_P2D_M2M_vel_algorithm(pp2ds, num_obj, p2mes, num_obj, p2dres2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_fmm(16, 0.5f);
+	cvtx_P2D_M2M_vel_algorithm(pp2ds, num_obj, p2mes, num_obj, p2dres, &func, reg_rad, &alg);
+	err = test_algorithms_rel_err_2D(p2dres, p2dres2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P2D M2M vel FMM order 16 winckelmans");
+	func = cvtx_VortFunc_gaussian();
+	cvtx_P2D_M2M_vel_algorithm(pp2ds, num_obj, p2mes, num_obj, p2dres2, &func, reg_rad, &bf_alg);
+	alg = cvtx_Algorithm_fmm(8, 0.5f);
+	cvtx_Algorithm_set_default(&alg);
+	cvtx_P2D_M2M_vel(pp2ds, num_obj, p2mes, num_obj, p2dres, &func, reg_rad);
+	cvtx_Algorithm_set_default(&def_alg);
+	err = test_algorithms_rel_err_2D(p2dres, p2dres2, num_obj);
+	NAMED_TEST(err < 1e-4f, "P2D M2M vel FMM default gaussian");
+
+	/* Self interaction evaluating each pair once */
+	func = cvtx_VortFunc_winckelmans();
+	cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_self_dvort(pparticles, num_obj, presult, &func, reg_rad);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D self dvort winckelmans");
+	cvtx_P3D_M2M_visc_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad, 0.1f);
+	cvtx_P3D_self_visc_dvort(pparticles, num_obj, presult, &func, reg_rad, 0.1f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D self visc_dvort winckelmans");
+	func.combined_3D = test_algorithms_user_combined;
+	func.cl_kernel_name_ext[0] = 0;
+	cvtx_P3D_self_visc_dvort(pparticles, num_obj, presult, &func, reg_rad, 0.1f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D self visc_dvort scalar pairwise");
+	cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_self_dvort(pparticles, num_obj, presult, &func, reg_rad);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D self dvort scalar pairwise");
+
+	/* Cell lists for short ranged interactions */
+	func = cvtx_VortFunc_gaussian();
+	for (i = 0; i < num_obj; ++i) {
+		presult2[i] = cvtx_P3D_M2S_vort(pparticles, num_obj, pmes[i], &func, 0.5f);
+	}
+	cvtx_P3D_M2M_vort(pparticles, num_obj, pmes, num_obj, presult, &func, 0.5f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D M2M vort cell list gaussian");
+	func = cvtx_VortFunc_planetary();
+	for (i = 0; i < num_obj; ++i) {
+		presult2[i] = cvtx_P3D_M2S_vort(pparticles, num_obj, particles[i].coord, &func, 0.5f);
+		pmes[i] = particles[i].coord;
+	}
+	cvtx_P3D_M2M_vort(pparticles, num_obj, pmes, num_obj, presult, &func, 0.5f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D M2M vort cell list planetary");
+	func = cvtx_VortFunc_winckelmans();
+	cvtx_P3D_M2M_visc_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, 0.5f, 0.1f);
+	cvtx_P3D_M2M_visc_dvort_truncated(pparticles, num_obj, pparticles, num_obj, presult, &func, 0.5f, 0.1f, 100.f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-5f, "P3D M2M visc_dvort truncated 100 winckelmans");
+	cvtx_P3D_M2M_visc_dvort_truncated(pparticles, num_obj, pparticles, num_obj, presult, &func, 0.5f, 0.1f, 6.f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-4f, "P3D M2M visc_dvort truncated 6 winckelmans");
+	func = cvtx_VortFunc_gaussian();
+	cvtx_P3D_M2M_visc_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, 0.5f, 0.1f);
+	cvtx_P3D_M2M_visc_dvort_truncated(pparticles, num_obj, pparticles, num_obj, presult, &func, 0.5f, 0.1f, 6.f);
+	err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+	NAMED_TEST(err < 1e-6f, "P3D M2M visc_dvort truncated 6 gaussian");
+
+	/* Fused vel, dvort and visc_dvort against the separate functions. 
+	pmes holds the particle locations from here. */
+	{
+		bsv_V3f *pvel, *pdvort;
+		char *names[2][3] = {
+			{"P3D M2M fused vel winckelmans", "P3D M2M fused dvort winckelmans",
+			"P3D M2M fused visc_dvort winckelmans"},
+			{"P3D M2M fused vel gaussian", "P3D M2M fused dvort gaussian",
+			"P3D M2M fused visc_dvort gaussian"} };
+		int j;
+		pvel = malloc(sizeof(bsv_V3f) * num_obj);
+		pdvort = malloc(sizeof(bsv_V3f) * num_obj);
+		for (j = 0; j < 2; ++j) {
+			func = j == 0 ? cvtx_VortFunc_winckelmans() : cvtx_VortFunc_gaussian();
+			cvtx_P3D_M2M_vel_dvort_visc(pparticles, num_obj, pparticles, num_obj,
+				pvel, pdvort, presult, &func, 0.5f, 0.1f);
+			cvtx_P3D_M2M_vel(pparticles, num_obj, pmes, num_obj, presult2, &func, 0.5f);
+			err = test_algorithms_rel_err_3D(pvel, presult2, num_obj);
+			NAMED_TEST(err < 1e-5f, names[j][0]);
+			cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, 0.5f);
+			err = test_algorithms_rel_err_3D(pdvort, presult2, num_obj);
+			NAMED_TEST(err < 1e-4f, names[j][1]);
+			cvtx_P3D_M2M_visc_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, 0.5f, 0.1f);
+			err = test_algorithms_rel_err_3D(presult, presult2, num_obj);
+			NAMED_TEST(err < 1e-5f, names[j][2]);
+		}
+		free(pvel);
+		free(pdvort);
+	}
+
+	/* A few measurement points with many particles, so that the sources
+	are split between tasks. */
+	func = cvtx_VortFunc_winckelmans();
+	for (i = 0; i < 5; ++i) {
+		presult2[i] = cvtx_P3D_M2S_vel(pparticles, num_obj, pmes[i], &func, reg_rad);
+		p2dres2[i] = cvtx_P2D_M2S_vel(pp2ds, num_obj, p2mes[i], &func, reg_rad);
+	}
+	cvtx_P3D_M2M_vel(pparticles, num_obj, pmes, 5, presult, &func, reg_rad);
+	err = test_algorithms_rel_err_3D(presult, presult2, 5);
+	NAMED_TEST(err < 1e-5f, "P3D M2M vel few measurement points");
+	cvtx_P2D_M2M_vel(pp2ds, num_obj, p2mes, 5, p2dres, &func, reg_rad);
+	err = test_algorithms_rel_err_2D(p2dres, p2dres2, 5);
+	NAMED_TEST(err < 1e-5f, "P2D M2M vel few measurement points");
+	{
+		float visc[5];
+		cvtx_P2D_M2M_visc_dvort(pp2ds, num_obj, pp2ds, 5, visc, &func, 0.5f, 0.1f);
+		err = 0.f;
+		for (i = 0; i < 5; ++i) {
+			float ref = cvtx_P2D_M2S_visc_dvort(pp2ds, num_obj, pp2ds[i], &func, 0.5f, 0.1f);
+			err = fmaxf(err, fabsf(visc[i] - ref) / (fabsf(ref) + 1e-6f));
+		}
+		NAMED_TEST(err < 1e-5f, "P2D M2M visc_dvort few induced particles");
+	}
+
+	free(particles);
+	free(pparticles);
+	free(pmes);
+	free(presult);
+	free(presult2);
+	free(p2mes);
+	free(p2dres);
+	free(p2dres2);
+	free(p2ds);
+	free(pp2ds);
+	return 0;
+}
+
+#endif /* CVTX_TEST_ALGORITHMS_H */
@@ -96,6 +96,10 @@ int mrand(void)
 #include "testvortfunc.h"
 #include "testsamecpugpuresultsingle.h"
 #include "testsamecpugpuresultmany.h"
+#include "testalgorithms.h"
+#include "teststrided.h"
+#include "testsoa.h"
+#include "testsimd.h"
 
 int main(int argc, char* argv[]){
 	cvtx_initialise();
@@ -104,6 +108,10 @@ int main(int argc, char* argv[]){
     testParticle();
 	testSameCpuGpuResSingle();
 	testSameCpuGpuResMany();
+	testAlgorithms();
+	testStrided();
+	testSoa();
+	testSimd();
 	cvtx_finalise();
 	SECTION("");
 	return print_summary();
@@ -107,6 +107,33 @@ int testParticle(){
     TEST(cvtx_P3D_S2S_dvort(&p2, &pzz, &vfs, 1).x[0] == 0);
     TEST(cvtx_P3D_S2S_dvort(&p2, &pzz, &vfs, 1).x[1] == 0);
     TEST(cvtx_P3D_S2S_dvort(&p2, &pzz, &vfs, 1).x[2] == 0);
+
+    /* Test redistribution onto a grid conserves vorticity */
+    {
+        cvtx_P3D redist_in[3] = {
+            {0.1f,0.2f,0.3f, 1,0,0, 1}, 
+            {0.55f,0.2f,-0.4f, 0,2,0, 1}, 
+            {-0.3f,0.45f,0.3f, 1,1,-1, 1}};
+        const cvtx_P3D *redist_ptrs[3] = {
+            redist_in, redist_in + 1, redist_in + 2};
+        cvtx_RedistFunc lambda3 = cvtx_RedistFunc_lambda3();
+        cvtx_P3D *redist_out;
+        bsv_V3f total = {0,0,0};
+        int n_out, i;
+        n_out = cvtx_P3D_redistribute_on_grid(redist_ptrs, 3, NULL, 0,
+            &lambda3, 0.2f, 0.f);
+        TEST(n_out > 3);
+        redist_out = (cvtx_P3D*)malloc(sizeof(cvtx_P3D) * n_out);
+        TEST(cvtx_P3D_redistribute_on_grid(redist_ptrs, 3, redist_out, 
+            n_out, &lambda3, 0.2f, 0.f) == n_out);
+        for (i = 0; i < n_out; ++i) {
+            total = bsv_V3f_plus(total, redist_out[i].vorticity);
+        }
+        TEST(fabsf(total.x[0] - 2.f) < 1e-4f);
+        TEST(fabsf(total.x[1] - 3.f) < 1e-4f);
+        TEST(fabsf(total.x[2] + 1.f) < 1e-4f);
+        free(redist_out);
+    }
     
     return 0;
 }
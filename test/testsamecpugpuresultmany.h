@@ -288,6 +288,48 @@ int testSameCpuGpuResMany() {
 			}
 			NAMED_TEST(good, "P3D M2M visc dvort winckelmans");
 			if (!good) { printf("\tAve Err = %.2e Max Err = %.2e\n", aveerr / num_obj, maxerr); }
+			cvtx_accelerator_enable(0);
+			cvtx_accelerator_share_with_cpu(1);
+			cvtx_P3D_M2M_vel(pparticles, num_obj, pmes, num_obj, presult, &func, reg_rad);
+			cvtx_accelerator_share_with_cpu(0);
+			cvtx_accelerator_disable(0);
+			cvtx_P3D_M2M_vel(pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad);
+			good = 1;
+			maxerr = aveerr = 0.;
+			for (i = 0; i < num_obj; ++i) {
+				tmpm = bsv_V3f_abs(bsv_V3f_minus(presult[i], presult2[i]));
+				tmpp = bsv_V3f_abs(bsv_V3f_plus(presult[i], presult2[i]));
+				if (tmpp > 2e-35f) {
+					aveerr += fabsf(tmpm / tmpp);
+					maxerr = fabsf(tmpm / tmpp) > maxerr ? fabsf(tmpm / tmpp) : maxerr;
+					if (tmpm / tmpp > rel_acc) {
+						good = 0;
+					}
+				}
+			}
+			NAMED_TEST(good, "P3D M2M vel winckelmans shared with CPU");
+			if (!good) { printf("\tAve Err = %.2e Max Err = %.2e\n", aveerr / num_obj, maxerr); }
+			cvtx_accelerator_enable(0);
+			cvtx_accelerator_share_with_cpu(1);
+			cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult, &func, reg_rad);
+			cvtx_accelerator_share_with_cpu(0);
+			cvtx_accelerator_disable(0);
+			cvtx_P3D_M2M_dvort(pparticles, num_obj, pparticles, num_obj, presult2, &func, reg_rad);
+			good = 1;
+			maxerr = aveerr = 0.;
+			for (i = 0; i < num_obj; ++i) {
+				tmpm = bsv_V3f_abs(bsv_V3f_minus(presult[i], presult2[i]));
+				tmpp = bsv_V3f_abs(bsv_V3f_plus(presult[i], presult2[i]));
+				if (tmpp > 2e-35f) {
+					aveerr += fabsf(tmpm / tmpp);
+					maxerr = fabsf(tmpm / tmpp) > maxerr ? fabsf(tmpm / tmpp) : maxerr;
+					if (tmpm / tmpp > rel_acc) {
+						good = 0;
+					}
+				}
+			}
+			NAMED_TEST(good, "P3D M2M dvort winckelmans shared with CPU");
+			if (!good) { printf("\tAve Err = %.2e Max Err = %.2e\n", aveerr / num_obj, maxerr); }
 
 			/* Vortex filaments */
 			cvtx_accelerator_enable(0);
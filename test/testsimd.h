@@ -0,0 +1,128 @@
+#ifndef CVTX_TEST_SIMD_H
+#define CVTX_TEST_SIMD_H
+
+/*============================================================================
+testsimd.h
+
+Test that the vectorised CPU M2M kernels for the built in
+regularisations agree with the scalar M2S functions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#include "../include/cvortex/libcvtx.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/* 1 if the vectors agree within a relative tolerance of their sum. */
+int test_simd_same(bsv_V3f* res, bsv_V3f* ref, int n, float rel_acc) {
+	int i;
+	float tmpm, tmpp;
+	for (i = 0; i < n; ++i) {
+		tmpm = bsv_V3f_abs(bsv_V3f_minus(res[i], ref[i]));
+		tmpp = bsv_V3f_abs(bsv_V3f_plus(res[i], ref[i]));
+		if (tmpp > 2e-35f && tmpm / tmpp > rel_acc) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int testSimd() {
+	SECTION("Vectorised CPU kernels");
+	const int num_obj = 1000;
+	float reg_rad = 0.3f, rel_acc = 1e-5f;
+	int i, k;
+	bsv_V3f *pmes, *presult, *presult2;
+	cvtx_P3D *particles, **pparticles;
+	cvtx_VortFunc funcs[4];
+	const char *names[4] = { "singular", "winckelmans", "planetary", "gaussian" };
+	char name[128];
+	funcs[0] = cvtx_VortFunc_singular();
+	funcs[1] = cvtx_VortFunc_winckelmans();
+	funcs[2] = cvtx_VortFunc_planetary();
+	funcs[3] = cvtx_VortFunc_gaussian();
+	particles = malloc(sizeof(cvtx_P3D) * num_obj);
+	pparticles = malloc(sizeof(cvtx_P3D*) * num_obj);
+	pmes = malloc(sizeof(bsv_V3f) * num_obj);
+	presult = malloc(sizeof(bsv_V3f) * num_obj);
+	presult2 = malloc(sizeof(bsv_V3f) * num_obj);
+	/* Not a multiple of the vector width, and measured at the particles
+	themselves to check coincident particles are excluded. */
+	for (i = 0; i < num_obj - 3; ++i) {
+		particles[i].coord.x[0] = 5.f * mrand() / 0x7FFF;
+		particles[i].coord.x[1] = 5.f * mrand() / 0x7FFF;
+		particles[i].coord.x[2] = 5.f * mrand() / 0x7FFF;
+		particles[i].vorticity.x[0] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[1] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[2] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].volume = 0.1f * mrand() / 0x7FFF;
+		pparticles[i] = &(particles[i]);
+		pmes[i] = particles[i].coord;
+	}
+	/* Including the origin, where the padding particles are. */
+	pmes[0] = bsv_V3f_zero();
+	for (k = 0; k < 4; ++k) {
+		cvtx_P3D_M2M_vel((const cvtx_P3D**)pparticles, num_obj - 3, pmes, num_obj - 3, presult, &funcs[k], reg_rad);
+		for (i = 0; i < num_obj - 3; ++i) {
+			presult2[i] = cvtx_P3D_M2S_vel((const cvtx_P3D**)pparticles, num_obj - 3, pmes[i], &funcs[k], reg_rad);
+		}
+		sprintf(name, "P3D M2M vel %s", names[k]);
+		NAMED_TEST(test_simd_same(presult, presult2, num_obj - 3, rel_acc), name);
+		cvtx_P3D_M2M_dvort((const cvtx_P3D**)pparticles, num_obj - 3, (const cvtx_P3D**)pparticles, num_obj - 3, presult, &funcs[k], reg_rad);
+		for (i = 0; i < num_obj - 3; ++i) {
+			presult2[i] = cvtx_P3D_M2S_dvort((const cvtx_P3D**)pparticles, num_obj - 3, pparticles[i], &funcs[k], reg_rad);
+		}
+		sprintf(name, "P3D M2M dvort %s", names[k]);
+		/* For the gaussian, 3 g / rho^3 - zeta is computed by cancellation
+		that amplifies rounding differences for close particles. */
+		NAMED_TEST(test_simd_same(presult, presult2, num_obj - 3, 
+			k == 3 ? 1e-3f : rel_acc), name);
+		if (k == 1 || k == 3) { /* Only these have viscous methods. */
+			cvtx_P3D_M2M_visc_dvort((const cvtx_P3D**)pparticles, num_obj - 3, (const cvtx_P3D**)pparticles, num_obj - 3, presult, &funcs[k], reg_rad, 0.1f);
+			for (i = 0; i < num_obj - 3; ++i) {
+				presult2[i] = cvtx_P3D_M2S_visc_dvort((const cvtx_P3D**)pparticles, num_obj - 3, pparticles[i], &funcs[k], reg_rad, 0.1f);
+			}
+			sprintf(name, "P3D M2M visc_dvort %s", names[k]);
+			NAMED_TEST(test_simd_same(presult, presult2, num_obj - 3, rel_acc), name);
+			cvtx_P3D_self_visc_dvort((const cvtx_P3D**)pparticles, num_obj - 3, presult, &funcs[k], reg_rad, 0.1f);
+			sprintf(name, "P3D self visc_dvort %s", names[k]);
+			NAMED_TEST(test_simd_same(presult, presult2, num_obj - 3, rel_acc), name);
+		}
+		/* Each pair once, including the diagonal blocks' masked lanes. */
+		cvtx_P3D_self_dvort((const cvtx_P3D**)pparticles, num_obj - 3, presult, &funcs[k], reg_rad);
+		for (i = 0; i < num_obj - 3; ++i) {
+			presult2[i] = cvtx_P3D_M2S_dvort((const cvtx_P3D**)pparticles, num_obj - 3, pparticles[i], &funcs[k], reg_rad);
+		}
+		sprintf(name, "P3D self dvort %s", names[k]);
+		NAMED_TEST(test_simd_same(presult, presult2, num_obj - 3, 
+			k == 3 ? 1e-3f : rel_acc), name);
+	}
+
+	free(particles);
+	free(pparticles);
+	free(pmes);
+	free(presult);
+	free(presult2);
+	return 0;
+}
+
+#endif /* CVTX_TEST_SIMD_H */
@@ -0,0 +1,153 @@
+#ifndef CVTX_TEST_SOA_H
+#define CVTX_TEST_SOA_H
+
+/*============================================================================
+testsoa.h
+
+Test that the cvtx_P3D_soa M2M functions agree with the pointer array
+functions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#include "../include/cvortex/libcvtx.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/* 1 if the arrays are identical within a relative tolerance. */
+int test_soa_same(float* res, float* ref, int n) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		if (fabsf(res[i] - ref[i]) > 1e-6f * (fabsf(ref[i]) + 1e-6f)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int testSoa() {
+	SECTION("Structure of arrays");
+	const int num_obj = 1000;
+	float reg_rad = 0.3f;
+	int i, good;
+	bsv_V3f *pmes, *presult, *presult2;
+	cvtx_P3D *particles, **pparticles, tmp;
+	cvtx_P3D_soa *soa, *soa2;
+	cvtx_Request *request;
+	cvtx_VortFunc func = cvtx_VortFunc_winckelmans();
+	particles = malloc(sizeof(cvtx_P3D) * num_obj);
+	pparticles = malloc(sizeof(cvtx_P3D*) * num_obj);
+	pmes = malloc(sizeof(bsv_V3f) * num_obj);
+	presult = malloc(sizeof(bsv_V3f) * num_obj);
+	presult2 = malloc(sizeof(bsv_V3f) * num_obj);
+	for (i = 0; i < num_obj; ++i) {
+		particles[i].coord.x[0] = 10.f * mrand() / 0x7FFF;
+		particles[i].coord.x[1] = 10.f * mrand() / 0x7FFF;
+		particles[i].coord.x[2] = 10.f * mrand() / 0x7FFF;
+		particles[i].vorticity.x[0] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[1] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[2] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].volume = 0.1f * mrand() / 0x7FFF;
+		pparticles[i] = &(particles[i]);
+		pmes[i].x[0] = 10.f * mrand() / 0x7FFF;
+		pmes[i].x[1] = 10.f * mrand() / 0x7FFF;
+		pmes[i].x[2] = 10.f * mrand() / 0x7FFF;
+	}
+	soa = cvtx_P3D_soa_create();
+	soa2 = cvtx_P3D_soa_create();
+	cvtx_P3D_soa_fill(soa, (const cvtx_P3D**)pparticles, num_obj);
+	cvtx_P3D_soa_fill_strided(soa2, particles, 0, num_obj / 2);
+	NAMED_TEST(cvtx_P3D_soa_size(soa) == num_obj 
+		&& cvtx_P3D_soa_size(soa2) == num_obj / 2, "P3D soa size");
+	tmp = cvtx_P3D_soa_get(soa, 7);
+	NAMED_TEST(bsv_V3f_isequal(tmp.coord, particles[7].coord)
+		&& bsv_V3f_isequal(tmp.vorticity, particles[7].vorticity)
+		&& tmp.volume == particles[7].volume, "P3D soa get");
+
+	cvtx_P3D_M2M_vel((const cvtx_P3D**)pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_vel_soa(soa, pmes, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vel soa");
+	cvtx_P3D_M2M_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj / 2, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_dvort_soa(soa, soa2, presult, &func, reg_rad);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * (num_obj / 2)), "P3D M2M dvort soa");
+	cvtx_P3D_M2M_visc_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2, &func, reg_rad, 0.1f);
+	cvtx_P3D_M2M_visc_dvort_soa(soa, soa, presult, &func, reg_rad, 0.1f);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M visc_dvort soa");
+	cvtx_P3D_M2M_vort((const cvtx_P3D**)pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_vort_soa(soa, pmes, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vort soa");
+
+	/* Move the particles to the measurement points and change their
+	vorticities and volumes. */
+	for (i = 0; i < num_obj; ++i) {
+		particles[i].coord = pmes[i];
+		particles[i].vorticity = bsv_V3f_mult(particles[i].vorticity, 2.f);
+		particles[i].volume = 0.05f;
+		presult[i] = particles[i].vorticity;
+		((float*)presult2)[i] = particles[i].volume;
+	}
+	cvtx_P3D_soa_update_coords(soa, pmes);
+	cvtx_P3D_soa_update_vorticities(soa, presult);
+	cvtx_P3D_soa_update_volumes(soa, (float*)presult2);
+	good = 1;
+	for (i = 0; i < num_obj; ++i) {
+		tmp = cvtx_P3D_soa_get(soa, i);
+		good &= bsv_V3f_isequal(tmp.coord, particles[i].coord)
+			&& bsv_V3f_isequal(tmp.vorticity, particles[i].vorticity)
+			&& tmp.volume == particles[i].volume;
+	}
+	NAMED_TEST(good, "P3D soa update");
+
+	/* The copy kept on an accelerator must follow the updates. */
+	NAMED_TEST(cvtx_P3D_soa_to_accelerator(soa) == 
+		(cvtx_num_enabled_accelerators() > 0 ? 0 : -1), "P3D soa to accelerator");
+	for (i = 0; i < num_obj; ++i) {
+		particles[i].vorticity = bsv_V3f_mult(particles[i].vorticity, 0.5f);
+		presult[i] = particles[i].vorticity;
+	}
+	cvtx_P3D_soa_update_vorticities(soa, presult);
+	cvtx_P3D_M2M_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_dvort_soa(soa, soa, presult, &func, reg_rad);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M dvort soa on accelerator");
+
+	/* Asynchronous evaluations give the same results once waited on. */
+	request = cvtx_P3D_M2M_vel_soa_async(soa, pmes, num_obj, presult, &func, reg_rad);
+	cvtx_P3D_M2M_vel_soa(soa, pmes, num_obj, presult2, &func, reg_rad);
+	cvtx_wait(request);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vel soa async");
+	request = cvtx_P3D_M2M_dvort_async((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult, &func, reg_rad);
+	while (!cvtx_test(request)) {}
+	cvtx_wait(request);
+	cvtx_P3D_M2M_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2, &func, reg_rad);
+	NAMED_TEST(test_soa_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M dvort async");
+	cvtx_P3D_soa_release_accelerator(soa);
+
+	cvtx_P3D_soa_destroy(soa);
+	cvtx_P3D_soa_destroy(soa2);
+	free(particles);
+	free(pparticles);
+	free(pmes);
+	free(presult);
+	free(presult2);
+	return 0;
+}
+
+#endif /* CVTX_TEST_SOA_H */
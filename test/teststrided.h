@@ -0,0 +1,161 @@
+#ifndef CVTX_TEST_STRIDED_H
+#define CVTX_TEST_STRIDED_H
+
+/*============================================================================
+teststrided.h
+
+Test that the strided array M2M functions agree with the pointer array
+functions.
+
+Copyright(c) 2020 HJA Bird
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+#include "../include/cvortex/libcvtx.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/* Particles embedded in a larger user structure. */
+typedef struct {
+	int tag;
+	cvtx_P3D particle;
+	double user_data;
+} test_strided_P3D;
+
+typedef struct {
+	cvtx_P2D particle;
+	char user_data[5];
+} test_strided_P2D;
+
+/* 1 if the arrays are identical within a relative tolerance. */
+int test_strided_same(float* res, float* ref, int n) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		if (fabsf(res[i] - ref[i]) > 1e-6f * (fabsf(ref[i]) + 1e-6f)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int testStrided() {
+	SECTION("Strided arrays");
+	const int num_obj = 1000;
+	float reg_rad = 0.3f;
+	int i;
+	bsv_V3f *pmes, *presult, *presult2;
+	bsv_V2f *p2mes, *p2dres, *p2dres2;
+	float *fres, *fres2;
+	test_strided_P3D *sparticles;
+	test_strided_P2D *sp2ds;
+	cvtx_P3D *particles, **pparticles;
+	cvtx_P2D **pp2ds;
+	cvtx_F3D *fils, **pfils;
+	cvtx_VortFunc func = cvtx_VortFunc_winckelmans();
+	sparticles = malloc(sizeof(test_strided_P3D) * num_obj);
+	particles = malloc(sizeof(cvtx_P3D) * num_obj);
+	pparticles = malloc(sizeof(cvtx_P3D*) * num_obj);
+	sp2ds = malloc(sizeof(test_strided_P2D) * num_obj);
+	pp2ds = malloc(sizeof(cvtx_P2D*) * num_obj);
+	fils = malloc(sizeof(cvtx_F3D) * num_obj);
+	pfils = malloc(sizeof(cvtx_F3D*) * num_obj);
+	pmes = malloc(sizeof(bsv_V3f) * num_obj);
+	presult = malloc(sizeof(bsv_V3f) * num_obj);
+	presult2 = malloc(sizeof(bsv_V3f) * num_obj);
+	p2mes = malloc(sizeof(bsv_V2f) * num_obj);
+	p2dres = malloc(sizeof(bsv_V2f) * num_obj);
+	p2dres2 = malloc(sizeof(bsv_V2f) * num_obj);
+	fres = malloc(sizeof(float) * num_obj);
+	fres2 = malloc(sizeof(float) * num_obj);
+	for (i = 0; i < num_obj; ++i) {
+		particles[i].coord.x[0] = 10.f * mrand() / 0x7FFF;
+		particles[i].coord.x[1] = 10.f * mrand() / 0x7FFF;
+		particles[i].coord.x[2] = 10.f * mrand() / 0x7FFF;
+		particles[i].vorticity.x[0] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[1] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].vorticity.x[2] = 1.f * mrand() / 0x7FFF - 0.5f;
+		particles[i].volume = 0.1f * mrand() / 0x7FFF;
+		sparticles[i].tag = i;
+		sparticles[i].particle = particles[i];
+		pparticles[i] = &(sparticles[i].particle);
+		sp2ds[i].particle.coord.x[0] = particles[i].coord.x[0];
+		sp2ds[i].particle.coord.x[1] = particles[i].coord.x[1];
+		sp2ds[i].particle.vorticity = particles[i].vorticity.x[2];
+		sp2ds[i].particle.area = particles[i].volume;
+		pp2ds[i] = &(sp2ds[i].particle);
+		fils[i].start = particles[i].coord;
+		fils[i].end = bsv_V3f_plus(particles[i].coord, particles[i].vorticity);
+		fils[i].strength = particles[i].volume;
+		pfils[i] = &(fils[i]);
+		pmes[i].x[0] = 10.f * mrand() / 0x7FFF;
+		pmes[i].x[1] = 10.f * mrand() / 0x7FFF;
+		pmes[i].x[2] = 10.f * mrand() / 0x7FFF;
+		p2mes[i].x[0] = pmes[i].x[0];
+		p2mes[i].x[1] = pmes[i].x[1];
+	}
+
+	cvtx_P3D_M2M_vel((const cvtx_P3D**)pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_vel_strided(&(sparticles[0].particle), sizeof(test_strided_P3D), num_obj, pmes, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vel strided");
+	cvtx_P3D_M2M_vel_strided(particles, 0, num_obj, pmes, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vel contiguous");
+	cvtx_P3D_M2M_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_dvort_strided(&(sparticles[0].particle), sizeof(test_strided_P3D), num_obj, particles, 0, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M dvort strided");
+	cvtx_P3D_M2M_visc_dvort((const cvtx_P3D**)pparticles, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2, &func, reg_rad, 0.1f);
+	cvtx_P3D_M2M_visc_dvort_strided(particles, 0, num_obj, &(sparticles[0].particle), sizeof(test_strided_P3D), num_obj, presult, &func, reg_rad, 0.1f);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M visc_dvort strided");
+	cvtx_P3D_M2M_vort((const cvtx_P3D**)pparticles, num_obj, pmes, num_obj, presult2, &func, reg_rad);
+	cvtx_P3D_M2M_vort_strided(&(sparticles[0].particle), sizeof(test_strided_P3D), num_obj, pmes, num_obj, presult, &func, reg_rad);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "P3D M2M vort strided");
+
+	cvtx_P2D_M2M_vel((const cvtx_P2D**)pp2ds, num_obj, p2mes, num_obj, p2dres2, &func, reg_rad);
+	cvtx_P2D_M2M_vel_strided(&(sp2ds[0].particle), sizeof(test_strided_P2D), num_obj, p2mes, num_obj, p2dres, &func, reg_rad);
+	NAMED_TEST(test_strided_same((float*)p2dres, (float*)p2dres2, 2 * num_obj), "P2D M2M vel strided");
+	cvtx_P2D_M2M_visc_dvort((const cvtx_P2D**)pp2ds, num_obj, (const cvtx_P2D**)pp2ds, num_obj, fres2, &func, reg_rad, 0.1f);
+	cvtx_P2D_M2M_visc_dvort_strided(&(sp2ds[0].particle), sizeof(test_strided_P2D), num_obj, &(sp2ds[0].particle), sizeof(test_strided_P2D), num_obj, fres, &func, reg_rad, 0.1f);
+	NAMED_TEST(test_strided_same(fres, fres2, num_obj), "P2D M2M visc_dvort strided");
+
+	cvtx_F3D_M2M_vel((const cvtx_F3D**)pfils, num_obj, pmes, num_obj, presult2);
+	cvtx_F3D_M2M_vel_strided(fils, 0, num_obj, pmes, num_obj, presult);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "F3D M2M vel strided");
+	cvtx_F3D_M2M_dvort((const cvtx_F3D**)pfils, num_obj, (const cvtx_P3D**)pparticles, num_obj, presult2);
+	cvtx_F3D_M2M_dvort_strided(fils, sizeof(cvtx_F3D), num_obj, &(sparticles[0].particle), sizeof(test_strided_P3D), num_obj, presult);
+	NAMED_TEST(test_strided_same((float*)presult, (float*)presult2, 3 * num_obj), "F3D M2M dvort strided");
+
+	free(sparticles);
+	free(particles);
+	free(pparticles);
+	free(sp2ds);
+	free(pp2ds);
+	free(fils);
+	free(pfils);
+	free(pmes);
+	free(presult);
+	free(presult2);
+	free(p2mes);
+	free(p2dres);
+	free(p2dres2);
+	free(fres);
+	free(fres2);
+	return 0;
+}
+
+#endif /* CVTX_TEST_STRIDED_H */
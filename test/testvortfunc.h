@@ -30,6 +30,10 @@ SOFTWARE.
 
 #include <math.h>
 
+/* A user regularisation that reuses most of a built in one. */
+static float test_vortfunc_double_winckelmans_g(float rho) {
+	return 2.f * cvtx_VortFunc_winckelmans().g_3D(rho);
+}
 
 int testVortFunc(){
     SECTION("VortFunc");
@@ -65,6 +69,32 @@ int testVortFunc(){
     TEST(vfg.g_3D(10.f) == 1.f);
     TEST(fabs(vfg.zeta_3D(1.f) - 0.483941449f) < 1e-6);
     TEST(fabs(vfg.zeta_3D(0.5f) - 0.70413065f) < 1e-6);
+
+	/* A copy of a built in with a replaced pointer must not use the built
+	in's specialised code. */
+	{
+		cvtx_P3D particles[3];
+		const cvtx_P3D *pparticles[3];
+		bsv_V3f mes = { 0.1f, 0.2f, 0.3f }, v1, v2;
+		cvtx_VortFunc vfu = vfw;
+		int i;
+		vfu.g_3D = test_vortfunc_double_winckelmans_g;
+		for (i = 0; i < 3; ++i) {
+			particles[i].coord.x[0] = 0.3f * i;
+			particles[i].coord.x[1] = -0.2f * i;
+			particles[i].coord.x[2] = 0.1f;
+			particles[i].vorticity.x[0] = 1.f;
+			particles[i].vorticity.x[1] = 0.5f * i;
+			particles[i].vorticity.x[2] = -1.f;
+			particles[i].volume = 0.1f;
+			pparticles[i] = &particles[i];
+		}
+		v1 = cvtx_P3D_M2S_vel(pparticles, 3, mes, &vfw, 0.5f);
+		v2 = cvtx_P3D_M2S_vel(pparticles, 3, mes, &vfu, 0.5f);
+		TEST(fabs(2.f * v1.x[0] - v2.x[0]) < 1e-5);
+		TEST(fabs(2.f * v1.x[1] - v2.x[1]) < 1e-5);
+		TEST(fabs(2.f * v1.x[2] - v2.x[2]) < 1e-5);
+	}
     return 0;
 }
 